@@ -0,0 +1,467 @@
+/*
+ * ChatBenchmark.cpp - microbenchmarks for the chat core
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include <QApplication>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLineEdit>
+#include <QRandomGenerator>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QTemporaryFile>
+#include <QTimer>
+#include <QXmlStreamReader>
+#include <QtTest>
+#include <algorithm>
+
+#include "ChatCommandDispatcher.h"
+#include "ChatFileTransfer.h"
+#include "ChatMasterWidget.h"
+#include "ChatMessage.h"
+#include "ChatScrollbackStore.h"
+#include "ChatSession.h"
+#include "FeatureMessage.h"
+
+namespace {
+constexpr auto FEATURE_UID = "a1b2c3d4-e5f6-7890-abcd-ef1234567890";
+constexpr auto MASTER_ID = "master";
+constexpr int SEND_MESSAGE = 1;
+constexpr int FILE_OFFER = 11;
+constexpr int FILE_CHUNK = 12;
+// Upper bound for one loopback transfer, a stalled transfer fails instead of hanging
+constexpr int TRANSFER_TIMEOUT = 60000;
+
+ChatMessage makeMessage(int index, const QString& clientId)
+{
+    return ChatMessage(clientId, QString::fromLatin1(MASTER_ID),
+                       QStringLiteral("Message %1: could you have a look at exercise 4b please?").arg(index));
+}
+
+// Scales of a classroom: a quiet session, a busy lesson, a whole day
+void addScales()
+{
+    QTest::addColumn<int>("count");
+    QTest::newRow("100") << 100;
+    QTest::newRow("1000") << 1000;
+    QTest::newRow("10000") << 10000;
+}
+}
+
+class ChatBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void messageConstruction();
+
+    void messageToJson();
+    void messageFromJson();
+
+    void featureMessagePacking();
+    void commandDispatch();
+
+    void sessionAddMessage_data() { addScales(); }
+    void sessionAddMessage();
+    void sessionMarkAllAsRead_data() { addScales(); }
+    void sessionMarkAllAsRead();
+    void sessionHistory_data() { addScales(); }
+    void sessionHistory();
+
+    void updateMessageStatus_data();
+    void updateMessageStatus();
+
+    void scrollbackPageIn_data() { addScales(); }
+    void scrollbackPageIn();
+
+    void fileTransferLoopback_data();
+    void fileTransferLoopback();
+};
+
+void ChatBenchmark::messageConstruction()
+{
+    QBENCHMARK {
+        const ChatMessage message = makeMessage(1, QStringLiteral("pc-01"));
+        Q_UNUSED(message)
+    }
+}
+
+void ChatBenchmark::messageToJson()
+{
+    const ChatMessage message = makeMessage(1, QStringLiteral("pc-01"));
+
+    QBENCHMARK {
+        const QByteArray json = QJsonDocument(message.toJson()).toJson(QJsonDocument::Compact);
+        Q_UNUSED(json)
+    }
+}
+
+void ChatBenchmark::messageFromJson()
+{
+    const QByteArray json = QJsonDocument(makeMessage(1, QStringLiteral("pc-01")).toJson()).toJson(QJsonDocument::Compact);
+
+    QBENCHMARK {
+        const ChatMessage message = ChatMessage::fromJson(QJsonDocument::fromJson(json).object());
+        Q_UNUSED(message)
+    }
+}
+
+// What the master does per student when sending a message
+void ChatBenchmark::featureMessagePacking()
+{
+    const ChatMessage message = makeMessage(1, QStringLiteral("pc-01"));
+
+    QBENCHMARK {
+        FeatureMessage featureMessage(QString::fromLatin1(FEATURE_UID), SEND_MESSAGE);
+        featureMessage.addArgument(chatArgumentKey(ChatArgumentId::Message), message.toJson());
+        Q_UNUSED(featureMessage)
+    }
+}
+
+// What the worker does per received message, decoding included
+void ChatBenchmark::commandDispatch()
+{
+    ChatCommandDispatcher<FeatureMessage> dispatcher(QString::fromLatin1(FEATURE_UID));
+    int received = 0;
+    dispatcher.add<ChatArguments::Message>(SEND_MESSAGE, [&received](const ChatMessage& message) {
+        received += message.content().size() > 0;
+    });
+
+    FeatureMessage featureMessage(QString::fromLatin1(FEATURE_UID), SEND_MESSAGE);
+    featureMessage.addArgument(chatArgumentKey(ChatArgumentId::Message), makeMessage(1, QStringLiteral("pc-01")).toJson());
+
+    QBENCHMARK {
+        if (dispatcher.accepts(featureMessage.featureUid())) {
+            dispatcher.dispatch(featureMessage.command(), featureMessage);
+        }
+    }
+
+    QVERIFY(received > 0);
+}
+
+void ChatBenchmark::sessionAddMessage()
+{
+    QFETCH(int, count);
+
+    QList<ChatMessage> messages;
+    for (int i = 0; i < count; ++i) {
+        messages.append(makeMessage(i, QStringLiteral("pc-01")));
+    }
+
+    QBENCHMARK {
+        ChatSession session(QStringLiteral("pc-01"));
+        for (const auto& message : qAsConst(messages)) {
+            session.addMessage(message);
+        }
+    }
+}
+
+// Includes detaching the history from the prepared session, which a
+// session marked read for real pays as well
+void ChatBenchmark::sessionMarkAllAsRead()
+{
+    QFETCH(int, count);
+
+    ChatSession session(QStringLiteral("pc-01"));
+    for (int i = 0; i < count; ++i) {
+        session.addMessage(makeMessage(i, QStringLiteral("pc-01")));
+    }
+
+    QBENCHMARK {
+        ChatSession copy(session);
+        copy.markAllAsRead();
+    }
+}
+
+void ChatBenchmark::sessionHistory()
+{
+    QFETCH(int, count);
+
+    ChatSession session(QStringLiteral("pc-01"));
+    for (int i = 0; i < count; ++i) {
+        session.addMessage(makeMessage(i, QStringLiteral("pc-01")));
+    }
+
+    int length = 0;
+    QBENCHMARK {
+        const auto history = session.history();
+        for (const auto& message : history) {
+            length += message.content().size();
+        }
+    }
+
+    QVERIFY(length > 0);
+}
+
+void ChatBenchmark::updateMessageStatus_data()
+{
+    QTest::addColumn<int>("clients");
+    QTest::addColumn<int>("messages");
+    QTest::newRow("30x100") << 30 << 100;
+    QTest::newRow("30x1000") << 30 << 1000;
+    QTest::newRow("300x100") << 300 << 100;
+}
+
+// Receipts for messages sent through the master window, in random order
+void ChatBenchmark::updateMessageStatus()
+{
+    QFETCH(int, clients);
+    QFETCH(int, messages);
+
+    ChatMasterWidget widget;
+    auto* input = widget.findChild<QLineEdit*>(QStringLiteral("messageInput"));
+    QVERIFY(input);
+
+    QStringList messageIds;
+    connect(&widget, &ChatMasterWidget::sendMessage, this, [&messageIds](const ChatMessage& message) {
+        messageIds.append(message.messageId());
+    });
+
+    for (int client = 0; client < clients; ++client) {
+        const QString clientId = QStringLiteral("pc-%1").arg(client);
+        widget.addClient(clientId, clientId);
+        widget.focusClient(clientId);
+        for (int i = 0; i < messages; ++i) {
+            input->setText(QStringLiteral("Message %1").arg(i));
+            QMetaObject::invokeMethod(&widget, "onSendButtonClicked");
+        }
+    }
+    QCOMPARE(messageIds.size(), clients * messages);
+
+    std::shuffle(messageIds.begin(), messageIds.end(), *QRandomGenerator::global());
+
+    int index = 0;
+    QBENCHMARK {
+        widget.updateMessageStatus(messageIds[index], (index & 1) ? ChatMessage::Status::Read
+                                                                  : ChatMessage::Status::Delivered);
+        index = (index + 1) % messageIds.size();
+    }
+}
+
+// One page of older lines read back from a client's scrollback
+void ChatBenchmark::scrollbackPageIn()
+{
+    QFETCH(int, count);
+    constexpr int PageSize = 100;
+
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+
+    ChatScrollbackStore store(directory.filePath(QStringLiteral("scrollback")));
+    QVERIFY(store.isOpen());
+    for (int i = 0; i < count; ++i) {
+        store.append(QStringLiteral("<b>pc-01</b> [10:%1] Message %2").arg(i % 60).arg(i));
+    }
+
+    int first = 0;
+    QBENCHMARK {
+        const QStringList page = store.read(first, PageSize);
+        Q_UNUSED(page)
+        first = (first + PageSize) % qMax(1, count - PageSize);
+    }
+}
+
+void ChatBenchmark::fileTransferLoopback_data()
+{
+    QTest::addColumn<qint64>("size");
+    QTest::newRow("1 MiB") << qint64(1024 * 1024);
+    QTest::newRow("16 MiB") << qint64(16 * 1024 * 1024);
+}
+
+// A file sent to one student over a queued loopback standing in for the
+// control interface. Offers and chunks are packed into feature messages and
+// decoded by a dispatcher, checksums are verified, as in the plugin.
+void ChatBenchmark::fileTransferLoopback()
+{
+    QFETCH(qint64, size);
+
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    QByteArray block(1024 * 1024, Qt::Uninitialized);
+    for (int i = 0; i < block.size(); ++i) {
+        block[i] = char(QRandomGenerator::global()->bounded(256));
+    }
+    for (qint64 written = 0; written < size; written += block.size()) {
+        file.write(block.constData(), int(qMin<qint64>(block.size(), size - written)));
+    }
+    file.close();
+
+    const QString clientId = QStringLiteral("pc-01");
+    ChatFileSender sender;
+    ChatFileReceiver receiver;
+
+    ChatCommandDispatcher<FeatureMessage> dispatcher(QString::fromLatin1(FEATURE_UID));
+    dispatcher.add<ChatArguments::Transfer, ChatArguments::FileName, ChatArguments::Size, ChatArguments::ChunkSize>(
+        FILE_OFFER, [&receiver](const QString& transferId, const QString& fileName, qint64 offerSize, int chunkSize) {
+            ChatFileOffer offer;
+            offer.transferId = transferId;
+            offer.fileName = fileName;
+            offer.size = offerSize;
+            offer.chunkSize = chunkSize;
+            receiver.receiveOffer(offer);
+        });
+    dispatcher.add<ChatArguments::Transfer, ChatArguments::Index, ChatArguments::Checksum, ChatArguments::Data>(
+        FILE_CHUNK, [&receiver](const QString& transferId, quint32 index, quint32 checksum, const QByteArray& data) {
+            ChatFileChunk chunk;
+            chunk.transferId = transferId;
+            chunk.index = index;
+            chunk.checksum = checksum;
+            chunk.data = data;
+            if (chunk.isValid()) {
+                receiver.receiveChunk(chunk);
+            }
+        });
+
+    const auto deliver = [&dispatcher, &receiver](const FeatureMessage& featureMessage) {
+        QMetaObject::invokeMethod(&receiver, [&dispatcher, featureMessage]() {
+            dispatcher.dispatch(featureMessage.command(), featureMessage);
+        }, Qt::QueuedConnection);
+    };
+
+    connect(&sender, &ChatFileSender::sendOffer, &receiver, [deliver](const QString&, const ChatFileOffer& offer) {
+        FeatureMessage featureMessage(QString::fromLatin1(FEATURE_UID), FILE_OFFER);
+        featureMessage.addArgument(chatArgumentKey(ChatArgumentId::Transfer), offer.transferId);
+        featureMessage.addArgument(chatArgumentKey(ChatArgumentId::FileName), offer.fileName);
+        featureMessage.addArgument(chatArgumentKey(ChatArgumentId::Size), offer.size);
+        featureMessage.addArgument(chatArgumentKey(ChatArgumentId::ChunkSize), offer.chunkSize);
+        deliver(featureMessage);
+    });
+    connect(&sender, &ChatFileSender::sendChunk, &receiver, [deliver](const QString&, const ChatFileChunk& chunk) {
+        FeatureMessage featureMessage(QString::fromLatin1(FEATURE_UID), FILE_CHUNK);
+        featureMessage.addArgument(chatArgumentKey(ChatArgumentId::Transfer), chunk.transferId);
+        featureMessage.addArgument(chatArgumentKey(ChatArgumentId::Index), chunk.index);
+        featureMessage.addArgument(chatArgumentKey(ChatArgumentId::Checksum), chunk.checksum);
+        featureMessage.addArgument(chatArgumentKey(ChatArgumentId::Data), chunk.data);
+        deliver(featureMessage);
+    });
+    connect(&receiver, &ChatFileReceiver::acknowledge, &sender, [&sender, clientId](const QString& transferId, quint32 next) {
+        sender.acknowledge(transferId, clientId, next);
+    }, Qt::QueuedConnection);
+
+    QString receivedPath;
+    connect(&receiver, &ChatFileReceiver::fileReceived, this, [&receivedPath](const QString&, const QString& filePath) {
+        receivedPath = filePath;
+    });
+
+    QBENCHMARK {
+        receivedPath.clear();
+
+        QEventLoop loop;
+        connect(&receiver, &ChatFileReceiver::fileReceived, &loop, &QEventLoop::quit);
+        QTimer::singleShot(TRANSFER_TIMEOUT, &loop, &QEventLoop::quit);
+
+        QVERIFY(!sender.send(file.fileName(), clientId).isEmpty());
+        loop.exec();
+
+        QVERIFY(!receivedPath.isEmpty());
+        QCOMPARE(QFileInfo(receivedPath).size(), size);
+        QFile::remove(receivedPath);
+    }
+}
+
+// Runs the benchmarks like QTEST_MAIN does. With --json <file> the results
+// are also written as JSON, converted from QtTest's XML log, so runs can be
+// compared by scripts.
+static QJsonObject convertResults(const QByteArray& xml)
+{
+    QJsonArray results;
+    QString function;
+
+    QXmlStreamReader reader(xml);
+    while (!reader.atEnd()) {
+        if (reader.readNext() != QXmlStreamReader::StartElement) {
+            continue;
+        }
+
+        const auto attributes = reader.attributes();
+        if (reader.name() == QLatin1String("TestFunction")) {
+            function = attributes.value(QLatin1String("name")).toString();
+        } else if (reader.name() == QLatin1String("BenchmarkResult")) {
+            const double value = attributes.value(QLatin1String("value")).toDouble();
+            const qint64 iterations = qMax<qint64>(1, attributes.value(QLatin1String("iterations")).toLongLong());
+            results.append(QJsonObject{
+                {QStringLiteral("name"), function},
+                {QStringLiteral("tag"), attributes.value(QLatin1String("tag")).toString()},
+                {QStringLiteral("metric"), attributes.value(QLatin1String("metric")).toString()},
+                {QStringLiteral("value"), value},
+                {QStringLiteral("iterations"), iterations},
+                {QStringLiteral("perIteration"), value / double(iterations)}
+            });
+        }
+    }
+
+    return QJsonObject{
+        {QStringLiteral("qtVersion"), QString::fromLatin1(qVersion())},
+        {QStringLiteral("cpu"), QSysInfo::currentCpuArchitecture()},
+        {QStringLiteral("kernel"), QSysInfo::kernelVersion()},
+        {QStringLiteral("timestamp"), QDateTime::currentDateTimeUtc().toString(Qt::ISODate)},
+        {QStringLiteral("results"), results}
+    };
+}
+
+int main(int argc, char* argv[])
+{
+    // The master window is created, but never shown
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication app(argc, argv);
+
+    QStringList arguments = app.arguments();
+    QString jsonFileName;
+    const int jsonIndex = arguments.indexOf(QStringLiteral("--json"));
+    if (jsonIndex > 0 && jsonIndex + 1 < arguments.size()) {
+        jsonFileName = arguments.at(jsonIndex + 1);
+        arguments.erase(arguments.begin() + jsonIndex, arguments.begin() + jsonIndex + 2);
+    }
+
+    ChatBenchmark benchmark;
+    if (jsonFileName.isEmpty()) {
+        return QTest::qExec(&benchmark, arguments);
+    }
+
+    QTemporaryDir directory;
+    const QString xmlFileName = directory.filePath(QStringLiteral("results.xml"));
+    arguments << QStringLiteral("-o") << xmlFileName + QStringLiteral(",xml")
+              << QStringLiteral("-o") << QStringLiteral("-,txt");
+
+    const int result = QTest::qExec(&benchmark, arguments);
+
+    QFile xmlFile(xmlFileName);
+    QFile jsonFile(jsonFileName);
+    if (!xmlFile.open(QIODevice::ReadOnly) || !jsonFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning("Cannot write benchmark results to %s", qPrintable(jsonFileName));
+        return result != 0 ? result : 1;
+    }
+
+    jsonFile.write(QJsonDocument(convertResults(xmlFile.readAll())).toJson());
+
+    return result;
+}
+
+#include "ChatBenchmark.moc"
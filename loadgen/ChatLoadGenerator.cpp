@@ -0,0 +1,783 @@
+/*
+ * ChatLoadGenerator.cpp - headless classroom load generator
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHostInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLineEdit>
+#include <QRandomGenerator>
+#include <QTextStream>
+#include <QTimer>
+#include <QUdpSocket>
+#include <algorithm>
+#include <cmath>
+
+#ifdef Q_OS_LINUX
+#include <sys/resource.h>
+#endif
+
+#include "ChatCommandDispatcher.h"
+#include "ChatFeaturePlugin.h"
+#include "ChatMasterWidget.h"
+#include "ChatRequestDatagram.h"
+#include "ChatSignalSettings.h"
+#include "ComputerControlInterface.h"
+#include "VeyonServerInterface.h"
+#include "VeyonWorkerInterface.h"
+
+namespace {
+constexpr int TICK_INTERVAL = 10;
+constexpr int TYPING_BURST = 3000;
+// Time after the last phase for messages and receipts still in flight
+constexpr int SETTLE_TIME = 3000;
+constexpr int MAX_STUDENTS = 5000;
+
+// Command numbers of ChatFeaturePlugin
+enum Command
+{
+    SendMessage = 1,
+    ReceiveMessage = 2,
+    UpdateStatus = 3,
+    GlobalBroadcast = 5,
+    Heartbeat = 6,
+    Acknowledge = 8
+};
+
+#ifdef Q_OS_LINUX
+// Every simulated student costs sockets and files, the default soft limit
+// of 1024 descriptors is reached long before 2000 students
+void raiseFileLimit()
+{
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+#endif
+}
+
+// One part of a script. Rates are events per minute, per student where the
+// name says so; events are spread randomly over the phase.
+struct ChatLoadPhase
+{
+    QString name;
+    int duration = 60;
+    double messageRate = 1.0;
+    double typingRate = 1.0;
+    double broadcastRate = 0.0;
+    double replyRate = 0.0;
+    // Fraction of the students pressing F10 when the phase starts
+    double f10Storm = 0.0;
+
+    static ChatLoadPhase fromJson(const QJsonObject& json, const ChatLoadPhase& defaults)
+    {
+        ChatLoadPhase phase = defaults;
+        phase.name = json.value(QStringLiteral("name")).toString(defaults.name);
+        phase.duration = json.value(QStringLiteral("duration")).toInt(defaults.duration);
+        phase.messageRate = json.value(QStringLiteral("messageRate")).toDouble(defaults.messageRate);
+        phase.typingRate = json.value(QStringLiteral("typingRate")).toDouble(defaults.typingRate);
+        phase.broadcastRate = json.value(QStringLiteral("broadcastRate")).toDouble(defaults.broadcastRate);
+        phase.replyRate = json.value(QStringLiteral("replyRate")).toDouble(defaults.replyRate);
+        phase.f10Storm = qBound(0.0, json.value(QStringLiteral("f10Storm")).toDouble(defaults.f10Storm), 1.0);
+        return phase;
+    }
+};
+
+// Latency samples of one kind of event, in nanoseconds
+class ChatLatencyStats
+{
+public:
+    explicit ChatLatencyStats(const QString& name = QString()) :
+        m_name(name),
+        m_events(0)
+    {
+    }
+
+    QString name() const { return m_name; }
+
+    void count() { ++m_events; }
+    void add(qint64 latency)
+    {
+        ++m_events;
+        m_samples.append(latency);
+    }
+
+    QJsonObject toJson(double seconds)
+    {
+        std::sort(m_samples.begin(), m_samples.end());
+        return QJsonObject{
+            {QStringLiteral("name"), m_name},
+            {QStringLiteral("count"), m_events},
+            {QStringLiteral("perSecond"), seconds > 0 ? double(m_events) / seconds : 0.0},
+            {QStringLiteral("p50"), percentile(0.5)},
+            {QStringLiteral("p99"), percentile(0.99)},
+            {QStringLiteral("max"), percentile(1.0)}
+        };
+    }
+
+private:
+    // Milliseconds, -1 without samples
+    double percentile(double fraction) const
+    {
+        if (m_samples.isEmpty()) {
+            return -1;
+        }
+        const int index = qMin(m_samples.size() - 1, int(std::ceil(fraction * m_samples.size())) - 1);
+        return double(m_samples[qMax(0, index)]) / 1e6;
+    }
+
+    QString m_name;
+    qint64 m_events;
+    QVector<qint64> m_samples;
+};
+
+// Drives ChatFeaturePlugin instances through the mock Veyon interfaces.
+//
+// Master role: one master plugin and N scripted students which speak the
+// feature message protocol directly: questions, typing bursts, heartbeats,
+// receipts, and F10 requests over UDP to the master's request listener.
+// The teacher broadcasts and replies through the master window.
+//
+// Client role: N student plugins in worker mode fed by a scripted master.
+// Latency is taken from the receipts the workers send back, so it includes
+// their acknowledgement batching.
+class ChatLoadGenerator : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class Role
+    {
+        Master,
+        Client
+    };
+
+    ChatLoadGenerator(Role role, int students, const QVector<ChatLoadPhase>& phases, QObject* parent = nullptr) :
+        QObject(parent),
+        m_role(role),
+        m_phases(phases),
+        m_phaseIndex(-1),
+        m_phaseEnd(0),
+        m_tickTimer(new QTimer(this)),
+        m_masterPlugin(nullptr),
+        m_masterWidget(nullptr),
+        m_messageInput(nullptr),
+        m_requestSocket(nullptr),
+        m_nextRequestId(0),
+        m_eventCount(0),
+        m_messages(QStringLiteral("student messages")),
+        m_replies(QStringLiteral("teacher replies")),
+        m_broadcasts(QStringLiteral("broadcast deliveries")),
+        m_requests(QStringLiteral("F10 request acks")),
+        m_statusUpdates(QStringLiteral("status updates")),
+        m_heartbeats(QStringLiteral("heartbeats")),
+        m_receipts(QStringLiteral("message receipts")),
+        m_sent(QStringLiteral("worker messages to master"))
+    {
+        m_students.resize(students);
+        m_tickTimer->setTimerType(Qt::PreciseTimer);
+        m_tickTimer->setInterval(TICK_INTERVAL);
+        connect(m_tickTimer, &QTimer::timeout, this, &ChatLoadGenerator::tick);
+    }
+
+    ~ChatLoadGenerator() override
+    {
+        // The plugins send through the interfaces until they are gone
+        delete m_masterPlugin;
+        for (auto& student : m_students) {
+            delete student.plugin;
+        }
+        qDeleteAll(m_controlInterfaces);
+        for (auto& student : m_students) {
+            delete student.worker;
+        }
+    }
+
+    void start()
+    {
+        if (m_role == Role::Master) {
+            setupMaster();
+        } else {
+            setupClients();
+        }
+
+        m_clock.start();
+        nextPhase();
+        m_tickTimer->start();
+    }
+
+    QJsonObject report()
+    {
+        const double seconds = double(m_runTime) / 1e9;
+
+        QJsonArray stats;
+        for (auto* entry : { &m_messages, &m_replies, &m_broadcasts, &m_requests,
+                             &m_statusUpdates, &m_heartbeats, &m_receipts, &m_sent }) {
+            stats.append(entry->toJson(seconds));
+        }
+
+        return QJsonObject{
+            {QStringLiteral("role"), m_role == Role::Master ? QStringLiteral("master") : QStringLiteral("client")},
+            {QStringLiteral("students"), m_students.size()},
+            {QStringLiteral("seconds"), seconds},
+            {QStringLiteral("events"), m_eventCount},
+            {QStringLiteral("eventsPerSecond"), seconds > 0 ? double(m_eventCount) / seconds : 0.0},
+            {QStringLiteral("unanswered"), m_messageStart.size() + m_requestStart.size() + pendingReceipts()},
+            {QStringLiteral("stats"), stats}
+        };
+    }
+
+signals:
+    void finished();
+
+private:
+    struct Student
+    {
+        QString id;
+        // Master role
+        ComputerControlInterface* controlInterface = nullptr;
+        // Client role
+        ChatFeaturePlugin* plugin = nullptr;
+        VeyonWorkerInterface* worker = nullptr;
+        quint32 sequence = 0;
+        quint32 delivered = 0;
+        QHash<quint32, qint64> sendTimes;
+    };
+
+    static QString studentAddress(int index)
+    {
+        return QStringLiteral("10.%1.%2.%3").arg(1 + index / 62500).arg(index / 250 % 250).arg(index % 250 + 1);
+    }
+
+    qint64 now() const { return m_clock.nsecsElapsed(); }
+
+    int pendingReceipts() const
+    {
+        int count = 0;
+        for (const auto& student : m_students) {
+            count += student.sendTimes.size();
+        }
+        return count;
+    }
+
+    void setupMaster()
+    {
+        m_masterPlugin = new ChatFeaturePlugin;
+
+        ComputerControlInterfaceList controlInterfaces;
+        for (int i = 0; i < m_students.size(); ++i) {
+            m_students[i].id = studentAddress(i);
+            m_students[i].controlInterface = new ComputerControlInterface(m_students[i].id,
+                [this, i](const FeatureMessage& message) { receiveAsStudent(i, message); });
+            controlInterfaces.append(m_students[i].controlInterface);
+        }
+        m_controlInterfaces = controlInterfaces;
+
+        m_masterPlugin->controlFeature(ChatFeaturePlugin::chatFeatureUid(), FeatureProviderInterface::Start,
+                                       QVariantMap(), controlInterfaces);
+
+        for (auto* widget : QApplication::topLevelWidgets()) {
+            if (auto* masterWidget = qobject_cast<ChatMasterWidget*>(widget)) {
+                m_masterWidget = masterWidget;
+            }
+        }
+        Q_ASSERT(m_masterWidget);
+
+        m_messageInput = m_masterWidget->findChild<QLineEdit*>(QStringLiteral("messageInput"));
+        connect(m_masterWidget, &ChatMasterWidget::messageRecorded,
+                this, [this](const QString&, const ChatMessage& message) {
+                    const auto it = m_messageStart.find(message.messageId());
+                    if (it != m_messageStart.end()) {
+                        m_messages.add(now() - *it);
+                        m_messageStart.erase(it);
+                    }
+                });
+
+        m_requestSocket = new QUdpSocket(this);
+        m_requestSocket->bind(QHostAddress::LocalHost, 0);
+        connect(m_requestSocket, &QUdpSocket::readyRead, this, &ChatLoadGenerator::readRequestAcks);
+    }
+
+    void setupClients()
+    {
+        // Workers compare numbered messages with their own id, which is
+        // the host name for all of them here
+        m_localClientId = QHostInfo::localHostName();
+
+        for (int i = 0; i < m_students.size(); ++i) {
+            m_students[i].id = m_localClientId;
+            m_students[i].plugin = new ChatFeaturePlugin;
+            m_students[i].worker = new VeyonWorkerInterface(
+                [this, i](const FeatureMessage& message) { receiveFromClient(i, message); });
+        }
+    }
+
+    void nextPhase()
+    {
+        m_runTime = now();
+        if (++m_phaseIndex >= m_phases.size()) {
+            m_tickTimer->stop();
+            QTimer::singleShot(SETTLE_TIME, this, &ChatLoadGenerator::finished);
+            return;
+        }
+
+        const auto& phase = m_phases[m_phaseIndex];
+        m_phaseEnd = now() + qint64(phase.duration) * 1000000000;
+        m_lastTick = now();
+
+        if (phase.f10Storm > 0 && m_role == Role::Master) {
+            const int count = int(std::lround(phase.f10Storm * m_students.size()));
+            for (int i = 0; i < count; ++i) {
+                sendRequest(i);
+            }
+        }
+    }
+
+    // Number of events due in this tick for a rate per minute, the
+    // fractional rest is carried over
+    int due(double ratePerMinute, double elapsedSeconds, double& carry)
+    {
+        carry += ratePerMinute / 60.0 * elapsedSeconds;
+        const int count = int(carry);
+        carry -= count;
+        return count;
+    }
+
+    int randomStudent() const
+    {
+        return int(QRandomGenerator::global()->bounded(quint32(m_students.size())));
+    }
+
+    void tick()
+    {
+        const qint64 current = now();
+        const double elapsed = double(current - m_lastTick) / 1e9;
+        m_lastTick = current;
+        m_runTime = current;
+
+        const auto& phase = m_phases[m_phaseIndex];
+        const int students = m_students.size();
+
+        for (int n = due(phase.messageRate * students, elapsed, m_messageCarry); n > 0; --n) {
+            if (m_role == Role::Master) {
+                sendQuestion(randomStudent());
+            } else {
+                sendToClient(randomStudent());
+            }
+        }
+
+        for (int n = due(phase.broadcastRate, elapsed, m_broadcastCarry); n > 0; --n) {
+            broadcast();
+        }
+
+        if (m_role == Role::Master) {
+            for (int n = due(phase.typingRate * students, elapsed, m_typingCarry); n > 0; --n) {
+                sendTypingBurst(randomStudent());
+            }
+
+            for (int n = due(phase.replyRate, elapsed, m_replyCarry); n > 0; --n) {
+                reply(randomStudent());
+            }
+
+            // Every student announces itself once per heartbeat interval
+            const double heartbeatRate = 60000.0 / ChatSession::HeartbeatInterval * students;
+            for (int n = due(heartbeatRate, elapsed, m_heartbeatCarry); n > 0; --n) {
+                sendHeartbeat(m_nextHeartbeat);
+                m_nextHeartbeat = (m_nextHeartbeat + 1) % students;
+            }
+        }
+
+        if (current >= m_phaseEnd) {
+            nextPhase();
+        }
+    }
+
+    // Master role: students
+
+    void submitToMaster(const FeatureMessage& message)
+    {
+        ++m_eventCount;
+        m_masterPlugin->handleFeatureMessage(m_server, m_messageContext, message);
+    }
+
+    void sendQuestion(int index)
+    {
+        const auto& student = m_students[index];
+        const ChatMessage message(student.id, QStringLiteral("master"),
+                                  QStringLiteral("Question %1: how do I solve exercise 3?").arg(m_eventCount));
+
+        m_messageStart.insert(message.messageId(), now());
+
+        FeatureMessage featureMessage(ChatFeaturePlugin::chatFeatureUid(), ReceiveMessage);
+        featureMessage.addArgument(chatArgumentKey(ChatArgumentId::Message), message.toJson());
+        submitToMaster(featureMessage);
+    }
+
+    void sendStatus(int index, ChatSession::ClientStatus status)
+    {
+        FeatureMessage featureMessage(ChatFeaturePlugin::chatFeatureUid(), UpdateStatus);
+        featureMessage.addArgument(chatArgumentKey(ChatArgumentId::ClientId), m_students[index].id);
+        featureMessage.addArgument(chatArgumentKey(ChatArgumentId::Status), static_cast<int>(status));
+        if (status == ChatSession::ClientStatus::Typing) {
+            featureMessage.addArgument(chatArgumentKey(ChatArgumentId::Lease), ChatSession::TypingLease);
+        }
+        m_statusUpdates.count();
+        submitToMaster(featureMessage);
+    }
+
+    void sendTypingBurst(int index)
+    {
+        sendStatus(index, ChatSession::ClientStatus::Typing);
+        QTimer::singleShot(TYPING_BURST, this, [this, index]() {
+            sendStatus(index, ChatSession::ClientStatus::Online);
+        });
+    }
+
+    void sendHeartbeat(int index)
+    {
+        FeatureMessage featureMessage(ChatFeaturePlugin::chatFeatureUid(), Heartbeat);
+        featureMessage.addArgument(chatArgumentKey(ChatArgumentId::ClientId), m_students[index].id);
+        m_heartbeats.count();
+        submitToMaster(featureMessage);
+    }
+
+    void sendRequest(int index)
+    {
+        QByteArray datagram = ChatRequestDatagram::encode(m_students[index].id, QStringLiteral("student"));
+        const quint32 requestId = ++m_nextRequestId;
+        ChatRequestDatagram::setTimestamp(datagram, QDateTime::currentMSecsSinceEpoch());
+        ChatRequestDatagram::setRequestId(datagram, requestId);
+
+        ++m_eventCount;
+        m_requestStart.insert(requestId, now());
+        m_requestSocket->writeDatagram(datagram, QHostAddress::LocalHost, ChatSignalSettings::Port);
+    }
+
+    void readRequestAcks()
+    {
+        while (m_requestSocket->hasPendingDatagrams()) {
+            char buffer[ChatRequestDatagram::AckSize];
+            const qint64 size = m_requestSocket->readDatagram(buffer, sizeof(buffer));
+
+            quint32 requestId = 0;
+            if (ChatRequestDatagram::decodeAck(buffer, size, requestId)) {
+                const auto it = m_requestStart.find(requestId);
+                if (it != m_requestStart.end()) {
+                    m_requests.add(now() - *it);
+                    m_requestStart.erase(it);
+                }
+            }
+        }
+    }
+
+    // Messages from the master to one student. Direct messages go out to
+    // every computer, students only take the ones addressed to them.
+    void receiveAsStudent(int index, const FeatureMessage& featureMessage)
+    {
+        const auto command = featureMessage.command();
+        if (command != SendMessage && command != GlobalBroadcast) {
+            return;
+        }
+
+        const auto message = ChatMessage::fromJson(
+            chatArgument(featureMessage, ChatArgumentId::Message).toJsonObject());
+
+        if (command == GlobalBroadcast) {
+            const auto it = m_broadcastStart.constFind(message.content());
+            if (it != m_broadcastStart.constEnd()) {
+                m_broadcasts.add(now() - *it);
+            }
+            return;
+        }
+
+        const auto& student = m_students[index];
+        if (message.receiverId() != student.id) {
+            return;
+        }
+
+        const auto it = m_replyStart.find(message.content());
+        if (it != m_replyStart.end()) {
+            m_replies.add(now() - *it);
+            m_replyStart.erase(it);
+        }
+
+        // Read right away, the receipt goes back as a worker would send it
+        FeatureMessage receipt(ChatFeaturePlugin::chatFeatureUid(), Acknowledge);
+        receipt.addArgument(chatArgumentKey(ChatArgumentId::ClientId), student.id);
+        receipt.addArgument(chatArgumentKey(ChatArgumentId::Delivered), message.sequence());
+        receipt.addArgument(chatArgumentKey(ChatArgumentId::Read), message.sequence());
+        QMetaObject::invokeMethod(this, [this, receipt]() { submitToMaster(receipt); }, Qt::QueuedConnection);
+    }
+
+    // Master role: the teacher, through the master window
+
+    void broadcast()
+    {
+        if (m_role == Role::Client) {
+            broadcastToClients();
+            return;
+        }
+
+        const QString content = QStringLiteral("Announcement %1").arg(++m_eventCount);
+        m_broadcastStart.insert(content, now());
+        m_masterWidget->broadcastMessage(content, ChatMessage::Priority::Announcement);
+        m_broadcastStart.remove(content);
+    }
+
+    void reply(int index)
+    {
+        if (!m_messageInput) {
+            return;
+        }
+
+        const QString content = QStringLiteral("Reply %1").arg(++m_eventCount);
+        m_replyStart.insert(content, now());
+
+        m_masterWidget->focusClient(m_students[index].id);
+        m_messageInput->setText(content);
+        QMetaObject::invokeMethod(m_masterWidget, "onSendButtonClicked");
+    }
+
+    // Client role: a scripted master
+
+    void submitToClient(int index, const FeatureMessage& featureMessage)
+    {
+        ++m_eventCount;
+        auto& student = m_students[index];
+        student.plugin->handleFeatureMessage(*student.worker, featureMessage);
+    }
+
+    void sendToClient(int index)
+    {
+        auto& student = m_students[index];
+
+        ChatMessage message(QStringLiteral("master"), student.id,
+                            QStringLiteral("Message %1: please open exercise 3").arg(m_eventCount));
+        message.setSequence(++student.sequence);
+        student.sendTimes.insert(message.sequence(), now());
+
+        FeatureMessage featureMessage(ChatFeaturePlugin::chatFeatureUid(), SendMessage);
+        featureMessage.addArgument(chatArgumentKey(ChatArgumentId::Message), message.toJson());
+        submitToClient(index, featureMessage);
+    }
+
+    void broadcastToClients()
+    {
+        const ChatMessage message(QStringLiteral("master"), QStringLiteral("all"),
+                                  QStringLiteral("Announcement %1").arg(m_eventCount),
+                                  ChatMessage::Priority::Announcement);
+
+        FeatureMessage featureMessage(ChatFeaturePlugin::chatFeatureUid(), GlobalBroadcast);
+        featureMessage.addArgument(chatArgumentKey(ChatArgumentId::Message), message.toJson());
+
+        const qint64 start = now();
+        for (int i = 0; i < m_students.size(); ++i) {
+            submitToClient(i, featureMessage);
+        }
+        m_broadcasts.add(now() - start);
+    }
+
+    void receiveFromClient(int index, const FeatureMessage& featureMessage)
+    {
+        m_sent.count();
+        if (featureMessage.command() != Acknowledge) {
+            return;
+        }
+
+        auto& student = m_students[index];
+        const quint32 delivered = chatArgument(featureMessage, ChatArgumentId::Delivered).toUInt();
+        for (; student.delivered < delivered; ++student.delivered) {
+            const auto it = student.sendTimes.find(student.delivered + 1);
+            if (it != student.sendTimes.end()) {
+                m_receipts.add(now() - *it);
+                student.sendTimes.erase(it);
+            }
+        }
+    }
+
+    const Role m_role;
+    const QVector<ChatLoadPhase> m_phases;
+    int m_phaseIndex;
+    qint64 m_phaseEnd;
+    qint64 m_lastTick = 0;
+    qint64 m_runTime = 0;
+    QElapsedTimer m_clock;
+    QTimer* m_tickTimer;
+
+    QVector<Student> m_students;
+    ComputerControlInterfaceList m_controlInterfaces;
+    QString m_localClientId;
+
+    ChatFeaturePlugin* m_masterPlugin;
+    ChatMasterWidget* m_masterWidget;
+    QLineEdit* m_messageInput;
+    VeyonServerInterface m_server;
+    MessageContext m_messageContext;
+    QUdpSocket* m_requestSocket;
+    quint32 m_nextRequestId;
+
+    double m_messageCarry = 0;
+    double m_typingCarry = 0;
+    double m_broadcastCarry = 0;
+    double m_replyCarry = 0;
+    double m_heartbeatCarry = 0;
+    int m_nextHeartbeat = 0;
+
+    QHash<QString, qint64> m_messageStart;
+    QHash<QString, qint64> m_replyStart;
+    QHash<QString, qint64> m_broadcastStart;
+    QHash<quint32, qint64> m_requestStart;
+
+    qint64 m_eventCount;
+    ChatLatencyStats m_messages;
+    ChatLatencyStats m_replies;
+    ChatLatencyStats m_broadcasts;
+    ChatLatencyStats m_requests;
+    ChatLatencyStats m_statusUpdates;
+    ChatLatencyStats m_heartbeats;
+    ChatLatencyStats m_receipts;
+    ChatLatencyStats m_sent;
+};
+
+static void printReport(const QJsonObject& report)
+{
+    QTextStream out(stdout);
+    out << "role " << report.value(QStringLiteral("role")).toString()
+        << ", " << report.value(QStringLiteral("students")).toInt() << " students, "
+        << QString::number(report.value(QStringLiteral("seconds")).toDouble(), 'f', 1) << " s, "
+        << QString::number(report.value(QStringLiteral("eventsPerSecond")).toDouble(), 'f', 1) << " events/s, "
+        << report.value(QStringLiteral("unanswered")).toInt() << " unanswered\n\n";
+
+    out << qSetFieldWidth(28) << Qt::left << "" << qSetFieldWidth(10) << Qt::right
+        << "count" << "per s" << "p50 ms" << "p99 ms" << "max ms" << qSetFieldWidth(0) << "\n";
+
+    const auto format = [](double value) {
+        return value < 0 ? QStringLiteral("-") : QString::number(value, 'f', 2);
+    };
+
+    for (const auto& value : report.value(QStringLiteral("stats")).toArray()) {
+        const auto entry = value.toObject();
+        if (entry.value(QStringLiteral("count")).toInt() == 0) {
+            continue;
+        }
+        out << qSetFieldWidth(28) << Qt::left << entry.value(QStringLiteral("name")).toString()
+            << qSetFieldWidth(10) << Qt::right
+            << QString::number(entry.value(QStringLiteral("count")).toInt())
+            << QString::number(entry.value(QStringLiteral("perSecond")).toDouble(), 'f', 1)
+            << format(entry.value(QStringLiteral("p50")).toDouble())
+            << format(entry.value(QStringLiteral("p99")).toDouble())
+            << format(entry.value(QStringLiteral("max")).toDouble())
+            << qSetFieldWidth(0) << "\n";
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+#ifdef Q_OS_LINUX
+    raiseFileLimit();
+#endif
+
+    QApplication app(argc, argv);
+    // Keeps the students' settings, outbox and caches apart from real ones
+    app.setApplicationName(QStringLiteral("ChatLoadGenerator"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Simulates a classroom against the chat plugin."));
+    parser.addHelpOption();
+    parser.addOptions({
+        {QStringLiteral("role"), QStringLiteral("master or client."), QStringLiteral("role"), QStringLiteral("master")},
+        {QStringLiteral("students"), QStringLiteral("Number of simulated students."), QStringLiteral("count"), QStringLiteral("30")},
+        {QStringLiteral("script"), QStringLiteral("JSON file with a list of phases."), QStringLiteral("file")},
+        {QStringLiteral("duration"), QStringLiteral("Seconds, without a script."), QStringLiteral("seconds"), QStringLiteral("60")},
+        {QStringLiteral("message-rate"), QStringLiteral("Messages per student and minute."), QStringLiteral("rate"), QStringLiteral("1")},
+        {QStringLiteral("typing-rate"), QStringLiteral("Typing bursts per student and minute."), QStringLiteral("rate"), QStringLiteral("1")},
+        {QStringLiteral("broadcast-rate"), QStringLiteral("Broadcasts per minute."), QStringLiteral("rate"), QStringLiteral("0")},
+        {QStringLiteral("reply-rate"), QStringLiteral("Teacher replies per minute."), QStringLiteral("rate"), QStringLiteral("0")},
+        {QStringLiteral("f10-storm"), QStringLiteral("Fraction of students pressing F10 at the start."), QStringLiteral("fraction"), QStringLiteral("0")},
+        {QStringLiteral("json"), QStringLiteral("Also write the report as JSON."), QStringLiteral("file")}
+    });
+    parser.process(app);
+
+    ChatLoadPhase defaults;
+    defaults.duration = parser.value(QStringLiteral("duration")).toInt();
+    defaults.messageRate = parser.value(QStringLiteral("message-rate")).toDouble();
+    defaults.typingRate = parser.value(QStringLiteral("typing-rate")).toDouble();
+    defaults.broadcastRate = parser.value(QStringLiteral("broadcast-rate")).toDouble();
+    defaults.replyRate = parser.value(QStringLiteral("reply-rate")).toDouble();
+    defaults.f10Storm = qBound(0.0, parser.value(QStringLiteral("f10-storm")).toDouble(), 1.0);
+
+    QVector<ChatLoadPhase> phases;
+    if (parser.isSet(QStringLiteral("script"))) {
+        QFile script(parser.value(QStringLiteral("script")));
+        if (!script.open(QIODevice::ReadOnly)) {
+            qCritical("Cannot read script %s", qPrintable(script.fileName()));
+            return 1;
+        }
+        for (const auto& value : QJsonDocument::fromJson(script.readAll()).array()) {
+            phases.append(ChatLoadPhase::fromJson(value.toObject(), defaults));
+        }
+    } else {
+        phases.append(defaults);
+    }
+
+    const int students = qBound(1, parser.value(QStringLiteral("students")).toInt(), MAX_STUDENTS);
+    if (phases.isEmpty()) {
+        qCritical("The script contains no phases");
+        return 1;
+    }
+
+    const auto role = parser.value(QStringLiteral("role")) == QLatin1String("client") ? ChatLoadGenerator::Role::Client
+                                                                                       : ChatLoadGenerator::Role::Master;
+
+    ChatLoadGenerator generator(role, students, phases);
+    QObject::connect(&generator, &ChatLoadGenerator::finished, &app, [&]() {
+        const auto report = generator.report();
+        printReport(report);
+
+        if (parser.isSet(QStringLiteral("json"))) {
+            QFile file(parser.value(QStringLiteral("json")));
+            if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+                file.write(QJsonDocument(report).toJson());
+            }
+        }
+
+        app.quit();
+    });
+
+    QTimer::singleShot(0, &generator, &ChatLoadGenerator::start);
+
+    return app.exec();
+}
+
+#include "ChatLoadGenerator.moc"
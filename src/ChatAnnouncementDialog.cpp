@@ -0,0 +1,143 @@
+/*
+ * ChatAnnouncementDialog.cpp - implementation of ChatAnnouncementDialog class
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include "ChatAnnouncementDialog.h"
+#include "ChatAnnouncementScheduler.h"
+#include <QComboBox>
+#include <QDateTimeEdit>
+#include <QDialogButtonBox>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+#include <iterator>
+
+namespace {
+constexpr int DEFAULT_DELAY = 10 * 60;
+
+// Repeat intervals offered in the dialog, in seconds
+const int REPEAT_INTERVALS[] = {0, 5 * 60, 10 * 60, 15 * 60, 30 * 60, 60 * 60, 24 * 60 * 60};
+}
+
+ChatAnnouncementDialog::ChatAnnouncementDialog(ChatAnnouncementScheduler* scheduler, QWidget* parent) :
+    QDialog(parent),
+    m_scheduler(scheduler),
+    m_list(new QTreeWidget(this)),
+    m_contentInput(new QLineEdit(this)),
+    m_dueEdit(new QDateTimeEdit(QDateTime::currentDateTime().addSecs(DEFAULT_DELAY), this)),
+    m_repeatCombo(new QComboBox(this)),
+    m_priorityCombo(new QComboBox(this)),
+    m_addButton(new QPushButton(tr("Add"), this)),
+    m_removeButton(new QPushButton(tr("Remove"), this))
+{
+    setWindowTitle(tr("Scheduled Announcements"));
+
+    m_list->setHeaderLabels({tr("Time"), tr("Repeat"), tr("Announcement")});
+    m_list->setRootIsDecorated(false);
+    m_list->header()->setStretchLastSection(true);
+
+    m_contentInput->setPlaceholderText(tr("e.g. 10 minutes left"));
+    m_dueEdit->setCalendarPopup(true);
+    m_dueEdit->setDisplayFormat(QStringLiteral("yyyy-MM-dd HH:mm"));
+
+    m_repeatCombo->addItems({tr("Once"), tr("Every 5 minutes"), tr("Every 10 minutes"), tr("Every 15 minutes"),
+                             tr("Every 30 minutes"), tr("Every hour"), tr("Every day")});
+
+    m_priorityCombo->addItem(tr("Announcement"), static_cast<int>(ChatMessage::Priority::Announcement));
+    m_priorityCombo->addItem(tr("Normal"), static_cast<int>(ChatMessage::Priority::Normal));
+    m_priorityCombo->addItem(tr("Urgent"), static_cast<int>(ChatMessage::Priority::Urgent));
+
+    auto* inputLayout = new QHBoxLayout();
+    inputLayout->addWidget(m_contentInput, 1);
+    inputLayout->addWidget(m_dueEdit);
+    inputLayout->addWidget(m_repeatCombo);
+    inputLayout->addWidget(m_priorityCombo);
+    inputLayout->addWidget(m_addButton);
+
+    auto* buttons = new QDialogButtonBox(QDialogButtonBox::Close, this);
+    buttons->addButton(m_removeButton, QDialogButtonBox::ActionRole);
+
+    auto* layout = new QVBoxLayout(this);
+    layout->addWidget(m_list, 1);
+    layout->addLayout(inputLayout);
+    layout->addWidget(buttons);
+
+    connect(m_addButton, &QPushButton::clicked, this, &ChatAnnouncementDialog::onAddClicked);
+    connect(m_contentInput, &QLineEdit::returnPressed, this, &ChatAnnouncementDialog::onAddClicked);
+    connect(m_removeButton, &QPushButton::clicked, this, &ChatAnnouncementDialog::onRemoveClicked);
+    connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+    connect(m_scheduler, &ChatAnnouncementScheduler::scheduleChanged, this, &ChatAnnouncementDialog::refresh);
+
+    resize(640, 360);
+    refresh();
+}
+
+void ChatAnnouncementDialog::onAddClicked()
+{
+    const QString content = m_contentInput->text().trimmed();
+    if (content.isEmpty()) {
+        return;
+    }
+
+    m_scheduler->schedule(content,
+                          static_cast<ChatMessage::Priority>(m_priorityCombo->currentData().toInt()),
+                          m_dueEdit->dateTime(),
+                          REPEAT_INTERVALS[qBound(0, m_repeatCombo->currentIndex(), int(std::size(REPEAT_INTERVALS)) - 1)]);
+    m_contentInput->clear();
+}
+
+void ChatAnnouncementDialog::onRemoveClicked()
+{
+    const auto items = m_list->selectedItems();
+    for (const auto* item : items) {
+        m_scheduler->cancel(item->data(0, Qt::UserRole).toString());
+    }
+}
+
+void ChatAnnouncementDialog::refresh()
+{
+    m_list->clear();
+
+    const auto announcements = m_scheduler->announcements();
+    for (const auto& announcement : announcements) {
+        QString repeat = tr("Once");
+        for (int i = 1; i < int(std::size(REPEAT_INTERVALS)); ++i) {
+            if (REPEAT_INTERVALS[i] == announcement.repeatInterval) {
+                repeat = m_repeatCombo->itemText(i);
+            }
+        }
+        if (announcement.repeatInterval > 0 && repeat == tr("Once")) {
+            repeat = tr("Every %1 s").arg(announcement.repeatInterval);
+        }
+
+        auto* item = new QTreeWidgetItem(m_list, {announcement.due.toString(QStringLiteral("yyyy-MM-dd HH:mm")),
+                                                  repeat, announcement.content});
+        item->setData(0, Qt::UserRole, announcement.id);
+    }
+
+    m_removeButton->setEnabled(!announcements.isEmpty());
+}
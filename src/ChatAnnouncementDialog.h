@@ -0,0 +1,61 @@
+/*
+ * ChatAnnouncementDialog.h - declaration of ChatAnnouncementDialog class
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#pragma once
+
+#include <QDialog>
+
+QT_BEGIN_NAMESPACE
+class QComboBox;
+class QDateTimeEdit;
+class QLineEdit;
+class QPushButton;
+class QTreeWidget;
+QT_END_NAMESPACE
+
+class ChatAnnouncementScheduler;
+
+// Lists the scheduled announcements and adds or removes them
+class ChatAnnouncementDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit ChatAnnouncementDialog(ChatAnnouncementScheduler* scheduler, QWidget* parent = nullptr);
+
+private slots:
+    void onAddClicked();
+    void onRemoveClicked();
+    void refresh();
+
+private:
+    ChatAnnouncementScheduler* m_scheduler;
+    QTreeWidget* m_list;
+    QLineEdit* m_contentInput;
+    QDateTimeEdit* m_dueEdit;
+    QComboBox* m_repeatCombo;
+    QComboBox* m_priorityCombo;
+    QPushButton* m_addButton;
+    QPushButton* m_removeButton;
+};
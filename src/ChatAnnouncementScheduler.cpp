@@ -0,0 +1,197 @@
+/*
+ * ChatAnnouncementScheduler.cpp - implementation of ChatAnnouncementScheduler class
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include "ChatAnnouncementScheduler.h"
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QTimer>
+#include <QUuid>
+
+#include <algorithm>
+
+namespace {
+constexpr auto KEY_ID = "id";
+constexpr auto KEY_CONTENT = "content";
+constexpr auto KEY_PRIORITY = "priority";
+constexpr auto KEY_DUE = "due";
+constexpr auto KEY_REPEAT = "repeat";
+// Announcements missed while the master was not running are still made if
+// they are at most this late
+constexpr qint64 MISSED_GRACE = 5 * 60 * 1000;
+}
+
+ChatAnnouncementScheduler::ChatAnnouncementScheduler(const QString& fileName, QObject* parent) :
+    QObject(parent),
+    m_fileName(fileName),
+    m_timer(new QTimer(this))
+{
+    m_timer->setSingleShot(true);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    connect(m_timer, &QTimer::timeout, this, &ChatAnnouncementScheduler::onTimeout);
+
+    load();
+    arm();
+}
+
+QString ChatAnnouncementScheduler::schedule(const QString& content, ChatMessage::Priority priority,
+                                            const QDateTime& due, int repeatInterval)
+{
+    Announcement announcement{QUuid::createUuid().toString(QUuid::WithoutBraces), content, priority,
+                              due, qMax(0, repeatInterval)};
+
+    m_announcements.insert(announcement.id, announcement);
+    push(announcement);
+    save();
+    arm();
+
+    emit scheduleChanged();
+    return announcement.id;
+}
+
+void ChatAnnouncementScheduler::cancel(const QString& id)
+{
+    // The heap entry is dropped once it reaches the top
+    if (m_announcements.remove(id) == 0) {
+        return;
+    }
+
+    save();
+    emit scheduleChanged();
+}
+
+QList<ChatAnnouncementScheduler::Announcement> ChatAnnouncementScheduler::announcements() const
+{
+    QList<Announcement> result = m_announcements.values();
+    std::sort(result.begin(), result.end(), [](const Announcement& a, const Announcement& b) {
+        return a.due < b.due;
+    });
+    return result;
+}
+
+void ChatAnnouncementScheduler::onTimeout()
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    bool changed = false;
+
+    while (!m_heap.isEmpty() && m_heap.top().due <= now) {
+        const ChatDueHeap::Entry entry = m_heap.pop();
+
+        auto it = m_announcements.find(entry.key);
+        if (it == m_announcements.end() || it->due.toMSecsSinceEpoch() != entry.due) {
+            continue;
+        }
+
+        if (now - entry.due <= MISSED_GRACE) {
+            emit announcementDue(it->content, it->priority);
+        }
+        changed = true;
+
+        if (it->repeatInterval > 0) {
+            // Repetitions missed while not running are skipped, not caught up
+            const qint64 interval = qint64(it->repeatInterval) * 1000;
+            const qint64 missed = (now - entry.due) / interval;
+            it->due = QDateTime::fromMSecsSinceEpoch(entry.due + (missed + 1) * interval);
+            push(*it);
+        } else {
+            m_announcements.erase(it);
+        }
+    }
+
+    if (changed) {
+        save();
+        emit scheduleChanged();
+    }
+
+    arm();
+}
+
+void ChatAnnouncementScheduler::push(const Announcement& announcement)
+{
+    m_heap.push(announcement.id, announcement.due.toMSecsSinceEpoch());
+}
+
+void ChatAnnouncementScheduler::arm()
+{
+    // Drop stale entries so the timer is not armed for them
+    while (!m_heap.isEmpty()) {
+        const auto it = m_announcements.constFind(m_heap.top().key);
+        if (it != m_announcements.constEnd() && it->due.toMSecsSinceEpoch() == m_heap.top().due) {
+            break;
+        }
+        m_heap.pop();
+    }
+
+    m_heap.arm(m_timer);
+}
+
+void ChatAnnouncementScheduler::load()
+{
+    QFile file(m_fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    const QJsonArray entries = QJsonDocument::fromJson(file.readAll()).array();
+    for (const auto& value : entries) {
+        const QJsonObject object = value.toObject();
+
+        // Due times are stored as strings, JSON numbers are doubles
+        Announcement announcement{
+            object.value(QLatin1String(KEY_ID)).toString(),
+            object.value(QLatin1String(KEY_CONTENT)).toString(),
+            static_cast<ChatMessage::Priority>(object.value(QLatin1String(KEY_PRIORITY)).toInt()),
+            QDateTime::fromMSecsSinceEpoch(object.value(QLatin1String(KEY_DUE)).toString().toLongLong()),
+            object.value(QLatin1String(KEY_REPEAT)).toInt()
+        };
+        if (announcement.id.isEmpty() || announcement.content.isEmpty()) {
+            continue;
+        }
+
+        m_announcements.insert(announcement.id, announcement);
+        push(announcement);
+    }
+}
+
+void ChatAnnouncementScheduler::save() const
+{
+    QJsonArray entries;
+    for (const auto& announcement : m_announcements) {
+        entries.append(QJsonObject{
+            {QLatin1String(KEY_ID), announcement.id},
+            {QLatin1String(KEY_CONTENT), announcement.content},
+            {QLatin1String(KEY_PRIORITY), static_cast<int>(announcement.priority)},
+            {QLatin1String(KEY_DUE), QString::number(announcement.due.toMSecsSinceEpoch())},
+            {QLatin1String(KEY_REPEAT), announcement.repeatInterval}
+        });
+    }
+
+    QSaveFile file(m_fileName);
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(QJsonDocument(entries).toJson(QJsonDocument::Compact));
+        file.commit();
+    }
+}
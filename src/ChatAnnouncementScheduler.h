@@ -0,0 +1,84 @@
+/*
+ * ChatAnnouncementScheduler.h - declaration of ChatAnnouncementScheduler class
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#pragma once
+
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QObject>
+
+#include "ChatDueHeap.h"
+#include "ChatMessage.h"
+
+class QTimer;
+
+// Announcements to the whole class at a given time, optionally repeated.
+// Pending announcements sit in a min-heap ordered by due time and one
+// single-shot QTimer is armed for the earliest of them, however many are
+// pending. Cancelled or rescheduled entries are skipped when they reach the
+// top of the heap instead of being searched for. The schedule is kept in a
+// small JSON file and survives restarts.
+class ChatAnnouncementScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Announcement
+    {
+        QString id;
+        QString content;
+        ChatMessage::Priority priority;
+        QDateTime due;
+        // Seconds between repetitions, 0 for a single announcement
+        int repeatInterval;
+    };
+
+    explicit ChatAnnouncementScheduler(const QString& fileName, QObject* parent = nullptr);
+
+    QString schedule(const QString& content, ChatMessage::Priority priority,
+                     const QDateTime& due, int repeatInterval = 0);
+    void cancel(const QString& id);
+
+    // Sorted by due time
+    QList<Announcement> announcements() const;
+
+signals:
+    void announcementDue(const QString& content, ChatMessage::Priority priority);
+    void scheduleChanged();
+
+private slots:
+    void onTimeout();
+
+private:
+    void push(const Announcement& announcement);
+    void arm();
+    void load();
+    void save() const;
+
+    const QString m_fileName;
+    QTimer* m_timer;
+    ChatDueHeap m_heap;
+    QHash<QString, Announcement> m_announcements;
+};
@@ -0,0 +1,132 @@
+/*
+ * ChatClientListModel.cpp - implementation of ChatClientListModel class
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include "ChatClientListModel.h"
+#include <limits>
+
+ChatClientListModel::ChatClientListModel(const QMap<QString, ChatSession>& sessions, QObject* parent) :
+    QAbstractListModel(parent),
+    m_sessions(sessions)
+{
+}
+
+int ChatClientListModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : m_clientIds.size();
+}
+
+QVariant ChatClientListModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_clientIds.size()) {
+        return QVariant();
+    }
+
+    const QString& clientId = m_clientIds.at(index.row());
+    const auto it = m_sessions.constFind(clientId);
+    if (it == m_sessions.constEnd()) {
+        return QVariant();
+    }
+
+    const ChatSession& session = it.value();
+
+    switch (role) {
+    case Qt::DisplayRole: {
+        QString label = session.clientName();
+        if (session.hasUnreadMessages()) {
+            label += tr(" (%1 new)").arg(session.unreadCount());
+        }
+        return label;
+    }
+    case Qt::ToolTipRole:
+        return session.statusString();
+    case ClientIdRole:
+        return clientId;
+    case HandleRole:
+        return session.handle();
+    case UnreadCountRole:
+        return session.unreadCount();
+    case UrgencyRole:
+        return session.urgency();
+    case OldestUnansweredRole:
+        return session.oldestUnanswered().isValid() ? session.oldestUnanswered().toMSecsSinceEpoch()
+                                                    : std::numeric_limits<qint64>::max();
+    default:
+        break;
+    }
+
+    return QVariant();
+}
+
+void ChatClientListModel::addSession(const QString& clientId)
+{
+    if (m_rows.contains(clientId)) {
+        return;
+    }
+
+    const int row = m_clientIds.size();
+    beginInsertRows(QModelIndex(), row, row);
+    m_clientIds.append(clientId);
+    m_rows.insert(clientId, row);
+    m_handleRows.insert(m_sessions.value(clientId).handle(), row);
+    endInsertRows();
+}
+
+void ChatClientListModel::removeSession(const QString& clientId)
+{
+    const int row = rowOf(clientId);
+    if (row < 0) {
+        return;
+    }
+
+    beginRemoveRows(QModelIndex(), row, row);
+    m_clientIds.remove(row);
+    m_rows.clear();
+    m_handleRows.clear();
+    for (int i = 0; i < m_clientIds.size(); ++i) {
+        m_rows.insert(m_clientIds.at(i), i);
+        m_handleRows.insert(m_sessions.value(m_clientIds.at(i)).handle(), i);
+    }
+    endRemoveRows();
+}
+
+void ChatClientListModel::sessionChanged(const QString& clientId)
+{
+    const QModelIndex index = indexOf(clientId);
+    if (index.isValid()) {
+        emit dataChanged(index, index);
+    }
+}
+
+void ChatClientListModel::allSessionsChanged()
+{
+    if (!m_clientIds.isEmpty()) {
+        emit dataChanged(index(0), index(m_clientIds.size() - 1));
+    }
+}
+
+QModelIndex ChatClientListModel::indexOf(const QString& clientId) const
+{
+    const int row = rowOf(clientId);
+    return row >= 0 ? index(row) : QModelIndex();
+}
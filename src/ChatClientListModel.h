@@ -0,0 +1,69 @@
+/*
+ * ChatClientListModel.h - declaration of ChatClientListModel class
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#pragma once
+
+#include <QAbstractListModel>
+#include <QHash>
+#include <QMap>
+#include <QVector>
+#include "ChatSession.h"
+
+// Flat list model over the master's sessions. Rows are kept in insertion
+// order and are updated one at a time, views apply their own ordering
+// through proxy models.
+class ChatClientListModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    enum Roles
+    {
+        ClientIdRole = Qt::UserRole,
+        HandleRole,
+        UnreadCountRole,
+        UrgencyRole,
+        OldestUnansweredRole
+    };
+
+    explicit ChatClientListModel(const QMap<QString, ChatSession>& sessions, QObject* parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+    void addSession(const QString& clientId);
+    void removeSession(const QString& clientId);
+    void sessionChanged(const QString& clientId);
+    void allSessionsChanged();
+
+    int rowOf(const QString& clientId) const { return m_rows.value(clientId, -1); }
+    int rowOfHandle(int handle) const { return m_handleRows.value(handle, -1); }
+    QModelIndex indexOf(const QString& clientId) const;
+
+private:
+    const QMap<QString, ChatSession>& m_sessions;
+    QVector<QString> m_clientIds;
+    QHash<QString, int> m_rows;
+    QHash<int, int> m_handleRows;
+};
@@ -1,8 +1,13 @@
 #include "ChatClientWidget.h"
+#include "ChatMetrics.h"
+#include "ChatNotificationAggregator.h"
 
+#include <QAbstractTextDocumentLayout>
 #include <QApplication>
 #include <QAction>
+#include <QAtomicInt>
 #include <QDateTime>
+#include <QDir>
 #include <QHBoxLayout>
 #include <QIcon>
 #include <QLabel>
@@ -10,10 +15,14 @@
 #include <QLineEdit>
 #include <QMenu>
 #include <QPushButton>
+#include <QScrollBar>
 #include <QSettings>
 #include <QShortcut>
+#include <QStandardPaths>
 #include <QSystemTrayIcon>
+#include <QTextBlock>
 #include <QTextCursor>
+#include <QTextDocument>
 #include <QTextEdit>
 #include <QTimer>
 #include <QUrl>
@@ -24,8 +33,23 @@ constexpr auto ORGANIZATION_NAME = "Veyon";
 constexpr auto APPLICATION_NAME = "ChatClient";
 constexpr auto SETTINGS_GEOMETRY = "geometry";
 constexpr auto SETTINGS_SOUND = "soundEnabled";
+constexpr auto SETTINGS_SCROLLBACK = "scrollbackLimit";
 constexpr auto CLIENT_ID = "client";
 constexpr auto MASTER_ID = "master";
+constexpr int DEFAULT_SCROLLBACK_LIMIT = 500;
+constexpr int MIN_SCROLLBACK_LIMIT = 50;
+constexpr int SCROLLBACK_PAGE_SIZE = 100;
+
+QString scrollbackFileName()
+{
+    QDir directory(QStandardPaths::writableLocation(QStandardPaths::CacheLocation));
+    directory.mkpath(QStringLiteral("."));
+    // Numbered per window, a load test runs many students in one process
+    static QAtomicInt windowCount;
+    return directory.filePath(QStringLiteral("chat-scrollback-%1-%2.dat")
+                                  .arg(QCoreApplication::applicationPid())
+                                  .arg(windowCount.fetchAndAddRelaxed(1)));
+}
 }
 
 ChatClientWidget::ChatClientWidget(QWidget* parent) :
@@ -38,15 +62,22 @@ ChatClientWidget::ChatClientWidget(QWidget* parent) :
     m_f10Shortcut(nullptr),
     m_sendShortcut(nullptr),
     m_typingTimer(new QTimer(this)),
+    m_typingActive(false),
     m_notificationSound(new QSoundEffect(this)),
+    m_notifications(new ChatNotificationAggregator(this)),
     m_soundEnabled(true),
     m_clientId(QString::fromUtf8(CLIENT_ID)),
-    m_unreadCount(0)
+    m_unreadCount(0),
+    m_scrollback(scrollbackFileName()),
+    m_scrollbackLimit(DEFAULT_SCROLLBACK_LIMIT),
+    m_firstShown(0),
+    m_repositioning(false)
 {
     setObjectName(QStringLiteral("ChatClientWidget"));
     setupUI();
     setupTrayIcon();
     setupShortcuts();
+    setupSound();
     loadSettings();
 
     m_typingTimer->setInterval(2000);
@@ -55,19 +86,16 @@ ChatClientWidget::ChatClientWidget(QWidget* parent) :
 
     connect(m_sendButton, &QPushButton::clicked, this, &ChatClientWidget::onSendButtonClicked);
     connect(m_messageInput, &QLineEdit::textChanged, this, &ChatClientWidget::onMessageInputChanged);
+    connect(m_chatDisplay->verticalScrollBar(), &QScrollBar::valueChanged,
+            this, &ChatClientWidget::onScrollPositionChanged);
 
     if (m_trayIcon) {
         connect(m_trayIcon, &QSystemTrayIcon::activated,
                 this, &ChatClientWidget::onTrayIconActivated);
     }
 
-    connect(m_notificationSound, &QSoundEffect::statusChanged, this, [this]() {
-        const auto status = m_notificationSound->status();
-
-        if (status == QSoundEffect::Ready || status == QSoundEffect::Null) {
-            playNotificationSound();
-        }
-    });
+    connect(m_notifications, &ChatNotificationAggregator::digestReady,
+            this, &ChatClientWidget::onNotificationDigest);
 
     setWindowTitle(tr("Veyon Chat"));
     resize(500, 400);
@@ -80,22 +108,24 @@ ChatClientWidget::~ChatClientWidget()
 
 void ChatClientWidget::receiveMessage(const ChatMessage& message)
 {
+    static auto& refreshTime = ChatMetrics::instance().histogram(
+        QStringLiteral("chat_ui_refresh_seconds"), QStringLiteral("Time to rebuild or extend a chat display"),
+        QStringLiteral("view=\"client\""));
+    const ChatMetricsTimer timer(refreshTime);
+
     addMessageToDisplay(message);
     ++m_unreadCount;
     updateWindowTitle();
 
-    if (m_trayIcon && !isActiveWindow()) {
-        m_trayIcon->showMessage(tr("New message"),
-                                tr("Message from %1").arg(message.senderId()),
-                                QIcon(QStringLiteral(":/chat/icons/chat.png")));
-    }
-
-    playNotificationSound();
+    m_notifications->notify(message.senderId(), message.priority());
 }
 
 void ChatClientWidget::clearChat()
 {
     m_chatDisplay->clear();
+    m_scrollback.clear();
+    m_displayedBlocks.clear();
+    m_firstShown = 0;
     m_unreadCount = 0;
     updateWindowTitle();
 }
@@ -122,6 +152,8 @@ void ChatClientWidget::changeEvent(QEvent* event)
     QWidget::changeEvent(event);
     if (event->type() == QEvent::LanguageChange) {
         updateWindowTitle();
+    } else if (event->type() == QEvent::ActivationChange && isActiveWindow()) {
+        emit activated();
     }
 }
 
@@ -136,8 +168,10 @@ void ChatClientWidget::onSendButtonClicked()
     addMessageToDisplay(message);
     emit sendMessage(message);
 
-    m_messageInput->clear();
+    // The master ends the typing lease itself when the message arrives
+    m_typingActive = false;
     m_typingTimer->stop();
+    m_messageInput->clear();
 }
 
 void ChatClientWidget::onMessageInputChanged()
@@ -145,10 +179,20 @@ void ChatClientWidget::onMessageInputChanged()
     const bool hasText = !m_messageInput->text().trimmed().isEmpty();
     m_sendButton->setEnabled(hasText);
 
-    if (hasText) {
+    if (!hasText) {
+        stopTyping();
+        return;
+    }
+
+    // Only the start of typing and periodic lease refreshes reach the master,
+    // not every keystroke
+    if (!m_typingActive || m_typingLeaseRefresh.elapsed() >= ChatSession::TypingLeaseRefresh) {
+        m_typingActive = true;
+        m_typingLeaseRefresh.start();
         emit statusChanged(ChatSession::ClientStatus::Typing);
-        m_typingTimer->start();
     }
+
+    m_typingTimer->start();
 }
 
 void ChatClientWidget::onTrayIconActivated(QSystemTrayIcon::ActivationReason reason)
@@ -165,21 +209,55 @@ void ChatClientWidget::onTrayIconActivated(QSystemTrayIcon::ActivationReason rea
 
 void ChatClientWidget::onTypingTimer()
 {
-    emit statusChanged(ChatSession::ClientStatus::Online);
+    stopTyping();
+}
+
+void ChatClientWidget::stopTyping()
+{
+    m_typingTimer->stop();
+
+    if (m_typingActive) {
+        m_typingActive = false;
+        emit statusChanged(ChatSession::ClientStatus::Online);
+    }
+}
+
+void ChatClientWidget::onNotificationDigest(int messageCount, const QStringList& senders, bool urgent)
+{
+    if (m_trayIcon && !isActiveWindow()) {
+        QString text;
+        if (messageCount == 1) {
+            text = urgent ? tr("Urgent message from %1").arg(senders.value(0))
+                          : tr("Message from %1").arg(senders.value(0));
+        } else {
+            text = tr("%1 new messages").arg(messageCount);
+        }
+
+        m_trayIcon->showMessage(tr("New message"), text, QIcon(QStringLiteral(":/chat/icons/chat.png")));
+    }
+
+    playNotificationSound();
 }
 
 void ChatClientWidget::playNotificationSound()
 {
-    if (!m_soundEnabled) {
+    // The sound is loaded once at startup, alerts arriving before it is ready stay silent
+    if (m_soundEnabled && m_notificationSound->status() == QSoundEffect::Ready) {
+        m_notificationSound->play();
+    }
+}
+
+void ChatClientWidget::onScrollPositionChanged(int value)
+{
+    // Moving the view after a page-in must not page in at the other end
+    if (m_repositioning) {
         return;
     }
 
-    if (m_notificationSound->status() == QSoundEffect::Ready) {
-        m_notificationSound->play();
-    } else if (m_notificationSound->status() == QSoundEffect::Null) {
-        m_notificationSound->setSource(QUrl(QStringLiteral("qrc:/chat/sounds/notification.wav")));
-        m_notificationSound->setVolume(0.6);
-        m_notificationSound->play();
+    if (value == m_chatDisplay->verticalScrollBar()->minimum()) {
+        loadOlderMessages();
+    } else if (value == m_chatDisplay->verticalScrollBar()->maximum()) {
+        loadNewerMessages();
     }
 }
 
@@ -192,10 +270,13 @@ void ChatClientWidget::setupUI()
 
     m_chatDisplay = new QTextEdit(this);
     m_chatDisplay->setReadOnly(true);
+    // Trimmed lines would otherwise live on in the undo stack
+    m_chatDisplay->setUndoRedoEnabled(false);
     layout->addWidget(m_chatDisplay, 1);
 
     auto* inputLayout = new QHBoxLayout();
     m_messageInput = new QLineEdit(this);
+    m_messageInput->setObjectName(QStringLiteral("messageInput"));
     m_messageInput->setPlaceholderText(tr("Type a message"));
     inputLayout->addWidget(m_messageInput, 1);
 
@@ -249,6 +330,12 @@ void ChatClientWidget::setupShortcuts()
     connect(m_sendShortcut, &QShortcut::activated, this, &ChatClientWidget::onSendButtonClicked);
 }
 
+void ChatClientWidget::setupSound()
+{
+    m_notificationSound->setSource(QUrl(QStringLiteral("qrc:/chat/sounds/notification.wav")));
+    m_notificationSound->setVolume(0.6);
+}
+
 void ChatClientWidget::loadSettings()
 {
     QSettings settings(ORGANIZATION_NAME, APPLICATION_NAME);
@@ -256,6 +343,8 @@ void ChatClientWidget::loadSettings()
         restoreGeometry(settings.value(SETTINGS_GEOMETRY).toByteArray());
     }
     m_soundEnabled = settings.value(SETTINGS_SOUND, true).toBool();
+    m_scrollbackLimit = qMax(MIN_SCROLLBACK_LIMIT,
+                             settings.value(SETTINGS_SCROLLBACK, DEFAULT_SCROLLBACK_LIMIT).toInt());
 }
 
 void ChatClientWidget::saveSettings()
@@ -268,10 +357,162 @@ void ChatClientWidget::saveSettings()
 void ChatClientWidget::addMessageToDisplay(const ChatMessage& message)
 {
     const QString text = formatMessage(message);
-    m_chatDisplay->append(text);
+
+    // A student paging through older messages is taken back to the latest
+    const bool showingLatest = !m_scrollback.isOpen() ||
+                               m_firstShown + m_displayedBlocks.size() == m_scrollback.size();
+    m_scrollback.append(text);
+
+    if (showingLatest) {
+        appendToDisplay(text);
+        trimDisplay();
+    } else {
+        showLatestMessages();
+    }
     scrollToBottom();
 }
 
+void ChatClientWidget::appendToDisplay(const QString& text)
+{
+    // Appending to an empty document reuses its single empty block
+    QTextDocument* document = m_chatDisplay->document();
+    const int blocksBefore = m_displayedBlocks.isEmpty() ? 0 : document->blockCount();
+    m_chatDisplay->append(text);
+    m_displayedBlocks.append(document->blockCount() - blocksBefore);
+}
+
+void ChatClientWidget::trimDisplay()
+{
+    const int excess = m_displayedBlocks.size() - m_scrollbackLimit;
+    if (excess <= 0) {
+        return;
+    }
+
+    int blocks = 0;
+    for (int i = 0; i < excess; ++i) {
+        blocks += m_displayedBlocks.takeFirst();
+    }
+
+    QTextCursor cursor(m_chatDisplay->document()->begin());
+    cursor.movePosition(QTextCursor::NextBlock, QTextCursor::KeepAnchor, blocks);
+    cursor.removeSelectedText();
+
+    m_firstShown += excess;
+}
+
+void ChatClientWidget::trimDisplayBottom()
+{
+    const int excess = m_displayedBlocks.size() - m_scrollbackLimit;
+    if (excess <= 0) {
+        return;
+    }
+
+    int blocks = 0;
+    for (int i = 0; i < excess; ++i) {
+        blocks += m_displayedBlocks.takeLast();
+    }
+
+    // From the end of the last kept block, so its line break goes too
+    QTextCursor cursor(m_chatDisplay->document());
+    cursor.movePosition(QTextCursor::End);
+    cursor.movePosition(QTextCursor::PreviousBlock, QTextCursor::KeepAnchor, blocks);
+    cursor.movePosition(QTextCursor::EndOfBlock, QTextCursor::KeepAnchor);
+    cursor.removeSelectedText();
+}
+
+void ChatClientWidget::loadOlderMessages()
+{
+    if (m_firstShown <= 0 || !m_scrollback.isOpen()) {
+        return;
+    }
+
+    const int first = qMax(0, m_firstShown - SCROLLBACK_PAGE_SIZE);
+    const QStringList lines = m_scrollback.read(first, m_firstShown - first);
+    if (lines.isEmpty()) {
+        return;
+    }
+
+    // Keep the line the student is looking at in place
+    const int topBlock = topVisibleBlock();
+
+    QTextDocument* document = m_chatDisplay->document();
+    QTextCursor cursor(document);
+    cursor.beginEditBlock();
+    int insertedBlocks = 0;
+    for (int i = lines.size() - 1; i >= 0; --i) {
+        const int blocksBefore = document->blockCount();
+
+        cursor.movePosition(QTextCursor::Start);
+        cursor.insertBlock();
+        cursor.movePosition(QTextCursor::Start);
+        // Same rich text detection as QTextEdit::append()
+        if (Qt::mightBeRichText(lines[i])) {
+            cursor.insertHtml(lines[i]);
+        } else {
+            cursor.insertText(lines[i]);
+        }
+
+        m_displayedBlocks.prepend(document->blockCount() - blocksBefore);
+        insertedBlocks += m_displayedBlocks.first();
+    }
+    cursor.endEditBlock();
+
+    m_firstShown = first;
+    trimDisplayBottom();
+    scrollToBlock(topBlock + insertedBlocks);
+}
+
+void ChatClientWidget::loadNewerMessages()
+{
+    const int shown = m_firstShown + m_displayedBlocks.size();
+    if (!m_scrollback.isOpen() || shown >= m_scrollback.size()) {
+        return;
+    }
+
+    const QStringList lines = m_scrollback.read(shown, SCROLLBACK_PAGE_SIZE);
+    if (lines.isEmpty()) {
+        return;
+    }
+
+    const int topBlock = topVisibleBlock();
+    QTextDocument* document = m_chatDisplay->document();
+    for (const auto& line : lines) {
+        appendToDisplay(line);
+    }
+    const int blocksBefore = document->blockCount();
+    trimDisplay();
+
+    // What was dropped above the view moves the line up
+    scrollToBlock(qMax(0, topBlock - (blocksBefore - document->blockCount())));
+}
+
+void ChatClientWidget::showLatestMessages()
+{
+    m_chatDisplay->clear();
+    m_displayedBlocks.clear();
+
+    m_firstShown = qMax(0, m_scrollback.size() - m_scrollbackLimit);
+    const QStringList lines = m_scrollback.read(m_firstShown, m_scrollback.size() - m_firstShown);
+    for (const auto& line : lines) {
+        appendToDisplay(line);
+    }
+}
+
+int ChatClientWidget::topVisibleBlock() const
+{
+    return m_chatDisplay->cursorForPosition(QPoint(0, 0)).blockNumber();
+}
+
+void ChatClientWidget::scrollToBlock(int blockNumber)
+{
+    const QTextBlock block = m_chatDisplay->document()->findBlockByNumber(blockNumber);
+    const QRectF bounds = m_chatDisplay->document()->documentLayout()->blockBoundingRect(block);
+
+    m_repositioning = true;
+    m_chatDisplay->verticalScrollBar()->setValue(int(bounds.top()));
+    m_repositioning = false;
+}
+
 void ChatClientWidget::scrollToBottom()
 {
     QTextCursor cursor = m_chatDisplay->textCursor();
@@ -24,14 +24,18 @@
 
 #pragma once
 
+#include <QElapsedTimer>
 #include <QWidget>
 #include <QSystemTrayIcon>
 #include <QTimer>
 #include <QShortcut>
 #include <QSoundEffect>
 #include "ChatMessage.h"
+#include "ChatScrollbackStore.h"
 #include "ChatSession.h"
 
+class ChatNotificationAggregator;
+
 QT_BEGIN_NAMESPACE
 class QTextEdit;
 class QLineEdit;
@@ -59,6 +63,7 @@ public:
 signals:
     void sendMessage(const ChatMessage& message);
     void statusChanged(ChatSession::ClientStatus status);
+    void activated();
 
 protected:
     void closeEvent(QCloseEvent* event) override;
@@ -69,18 +74,30 @@ private slots:
     void onMessageInputChanged();
     void onTrayIconActivated(QSystemTrayIcon::ActivationReason reason);
     void onTypingTimer();
+    void onNotificationDigest(int messageCount, const QStringList& senders, bool urgent);
     void playNotificationSound();
+    void onScrollPositionChanged(int value);
 
 private:
     void setupUI();
     void setupTrayIcon();
     void setupShortcuts();
+    void setupSound();
     void loadSettings();
     void saveSettings();
     
     void addMessageToDisplay(const ChatMessage& message);
+    void appendToDisplay(const QString& text);
+    void trimDisplay();
+    void trimDisplayBottom();
+    void loadOlderMessages();
+    void loadNewerMessages();
+    void showLatestMessages();
+    int topVisibleBlock() const;
+    void scrollToBlock(int blockNumber);
     void scrollToBottom();
     void updateWindowTitle();
+    void stopTyping();
     
     QString formatMessage(const ChatMessage& message) const;
     
@@ -99,13 +116,27 @@ private:
     
     // Timers
     QTimer* m_typingTimer;
+    QElapsedTimer m_typingLeaseRefresh;
+    bool m_typingActive;
     
-    // Sound
+    // Notifications
     QSoundEffect* m_notificationSound;
+    ChatNotificationAggregator* m_notifications;
     
     // Data
     QString m_masterName;
     QString m_clientId;
     bool m_soundEnabled;
     int m_unreadCount;
+
+    // Scrollback: the display is a window of at most m_scrollbackLimit
+    // messages, all of them are kept in m_scrollback. Paging in at one end
+    // drops as many messages at the other. m_firstShown is the store index
+    // of the topmost displayed message, m_displayedBlocks the number of text
+    // blocks each displayed message occupies.
+    ChatScrollbackStore m_scrollback;
+    int m_scrollbackLimit;
+    int m_firstShown;
+    QList<int> m_displayedBlocks;
+    bool m_repositioning;
 };
@@ -0,0 +1,55 @@
+/*
+ * ChatCommandDispatcher.cpp - implementation of ChatCommandDispatcher helpers
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include "ChatCommandDispatcher.h"
+
+const QString& chatArgumentKey(ChatArgumentId id)
+{
+    static const QString keys[] = {
+        QStringLiteral("command"),
+        QStringLiteral("message"),
+        QStringLiteral("messages"),
+        QStringLiteral("clientId"),
+        QStringLiteral("status"),
+        QStringLiteral("lease"),
+        QStringLiteral("content"),
+        QStringLiteral("priority"),
+        QStringLiteral("delivered"),
+        QStringLiteral("read"),
+        QStringLiteral("first"),
+        QStringLiteral("last"),
+        QStringLiteral("transfer"),
+        QStringLiteral("fileName"),
+        QStringLiteral("size"),
+        QStringLiteral("chunkSize"),
+        QStringLiteral("index"),
+        QStringLiteral("checksum"),
+        QStringLiteral("data"),
+        QStringLiteral("next"),
+    };
+    static_assert(sizeof(keys) / sizeof(keys[0]) == int(ChatArgumentId::Count),
+                  "every ChatArgumentId needs a key");
+
+    return keys[int(id)];
+}
@@ -0,0 +1,243 @@
+/*
+ * ChatCommandDispatcher.h - declaration of ChatCommandDispatcher class
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+#include <QVariant>
+#include <QVariantMap>
+#include <QVector>
+#include <functional>
+
+#include "ChatMessage.h"
+#include "ChatSession.h"
+#include "FeatureMessage.h"
+
+// Keys of all feature message arguments. Handlers name arguments by id, the
+// key strings exist once and are never rebuilt per message.
+enum class ChatArgumentId
+{
+    Command,
+    Message,
+    Messages,
+    ClientId,
+    Status,
+    Lease,
+    Content,
+    Priority,
+    Delivered,
+    Read,
+    First,
+    Last,
+    Transfer,
+    FileName,
+    Size,
+    ChunkSize,
+    Index,
+    Checksum,
+    Data,
+    Next,
+    Count
+};
+
+const QString& chatArgumentKey(ChatArgumentId id);
+
+// Compile-time argument descriptor: which key to read and what type to decode it to
+template<ChatArgumentId Id, typename T>
+struct ChatArgument
+{
+    static constexpr ChatArgumentId id = Id;
+    using Type = T;
+};
+
+namespace ChatArguments {
+using Message = ChatArgument<ChatArgumentId::Message, ChatMessage>;
+using Messages = ChatArgument<ChatArgumentId::Messages, QList<ChatMessage>>;
+using ClientId = ChatArgument<ChatArgumentId::ClientId, QString>;
+using Status = ChatArgument<ChatArgumentId::Status, ChatSession::ClientStatus>;
+using Lease = ChatArgument<ChatArgumentId::Lease, int>;
+using Content = ChatArgument<ChatArgumentId::Content, QString>;
+using Priority = ChatArgument<ChatArgumentId::Priority, ChatMessage::Priority>;
+using Delivered = ChatArgument<ChatArgumentId::Delivered, quint32>;
+using Read = ChatArgument<ChatArgumentId::Read, quint32>;
+using First = ChatArgument<ChatArgumentId::First, quint32>;
+using Last = ChatArgument<ChatArgumentId::Last, quint32>;
+using Entries = ChatArgument<ChatArgumentId::Messages, QJsonArray>;
+using Transfer = ChatArgument<ChatArgumentId::Transfer, QString>;
+using FileName = ChatArgument<ChatArgumentId::FileName, QString>;
+using Size = ChatArgument<ChatArgumentId::Size, qint64>;
+using ChunkSize = ChatArgument<ChatArgumentId::ChunkSize, int>;
+using Index = ChatArgument<ChatArgumentId::Index, quint32>;
+using Checksum = ChatArgument<ChatArgumentId::Checksum, quint32>;
+using Data = ChatArgument<ChatArgumentId::Data, QByteArray>;
+using Next = ChatArgument<ChatArgumentId::Next, quint32>;
+}
+
+template<typename T>
+struct ChatArgumentDecoder;
+
+template<>
+struct ChatArgumentDecoder<QString>
+{
+    static QString decode(const QVariant& value) { return value.toString(); }
+};
+
+template<>
+struct ChatArgumentDecoder<int>
+{
+    static int decode(const QVariant& value) { return value.toInt(); }
+};
+
+template<>
+struct ChatArgumentDecoder<quint32>
+{
+    static quint32 decode(const QVariant& value) { return value.toUInt(); }
+};
+
+template<>
+struct ChatArgumentDecoder<qint64>
+{
+    static qint64 decode(const QVariant& value) { return value.toLongLong(); }
+};
+
+template<>
+struct ChatArgumentDecoder<QByteArray>
+{
+    static QByteArray decode(const QVariant& value) { return value.toByteArray(); }
+};
+
+template<>
+struct ChatArgumentDecoder<QJsonArray>
+{
+    static QJsonArray decode(const QVariant& value) { return value.toJsonArray(); }
+};
+
+template<>
+struct ChatArgumentDecoder<ChatMessage>
+{
+    static ChatMessage decode(const QVariant& value) { return ChatMessage::fromJson(value.toJsonObject()); }
+};
+
+template<>
+struct ChatArgumentDecoder<QList<ChatMessage>>
+{
+    static QList<ChatMessage> decode(const QVariant& value)
+    {
+        const QJsonArray array = value.toJsonArray();
+        QList<ChatMessage> messages;
+        messages.reserve(array.size());
+        for (const auto& entry : array) {
+            messages.append(ChatMessage::fromJson(entry.toObject()));
+        }
+        return messages;
+    }
+};
+
+template<>
+struct ChatArgumentDecoder<ChatSession::ClientStatus>
+{
+    static ChatSession::ClientStatus decode(const QVariant& value)
+    {
+        return static_cast<ChatSession::ClientStatus>(value.toInt());
+    }
+};
+
+template<>
+struct ChatArgumentDecoder<ChatMessage::Priority>
+{
+    static ChatMessage::Priority decode(const QVariant& value)
+    {
+        return static_cast<ChatMessage::Priority>(value.toInt());
+    }
+};
+
+// Argument sources: feature messages and the argument map of controlFeature()
+inline QVariant chatArgument(const FeatureMessage& message, ChatArgumentId id)
+{
+    return message.argument(chatArgumentKey(id));
+}
+
+inline QVariant chatArgument(const QVariantMap& arguments, ChatArgumentId id)
+{
+    return arguments.value(chatArgumentKey(id));
+}
+
+// Table of command handlers for one feature, indexed by command number.
+// Handlers declare their arguments as ChatArguments descriptors and receive
+// them decoded, after any Context values passed to dispatch():
+//
+//   dispatcher.add<ChatArguments::ClientId, ChatArguments::Lease>(UpdateStatus,
+//       [](const QString& clientId, int lease) { ... });
+template<typename Source, typename... Context>
+class ChatCommandDispatcher
+{
+public:
+    using Handler = std::function<void(const Source&, Context...)>;
+
+    explicit ChatCommandDispatcher(const QString& featureUid) :
+        m_featureUid(featureUid)
+    {
+    }
+
+    // Feature uids are compared against the one kept here; hashing them
+    // first would read every character just the same
+    bool accepts(const QString& featureUid) const { return featureUid == m_featureUid; }
+
+    bool handles(int command) const
+    {
+        return command >= 0 && command < m_handlers.size() && m_handlers[command];
+    }
+
+    template<typename... Arguments, typename Function>
+    void add(int command, Function function)
+    {
+        if (command >= m_handlers.size()) {
+            m_handlers.resize(command + 1);
+        }
+
+        m_handlers[command] = [function](const Source& source, Context... context) {
+            Q_UNUSED(source)
+            function(context...,
+                     ChatArgumentDecoder<typename Arguments::Type>::decode(chatArgument(source, Arguments::id))...);
+        };
+    }
+
+    bool dispatch(int command, const Source& source, Context... context) const
+    {
+        if (!handles(command)) {
+            return false;
+        }
+
+        m_handlers[command](source, context...);
+        return true;
+    }
+
+private:
+    const QString m_featureUid;
+    QVector<Handler> m_handlers;
+};
@@ -0,0 +1,61 @@
+/*
+ * ChatDueHeap.cpp - implementation of ChatHistoryCompactor class
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include "ChatDueHeap.h"
+#include <QDateTime>
+#include <QTimer>
+
+#include <algorithm>
+
+namespace {
+// The timer is re-armed at least this often, which also follows changes of
+// the system clock
+constexpr qint64 MAX_TIMER_DELAY = 60 * 1000;
+}
+
+void ChatDueHeap::push(const QString& key, qint64 due)
+{
+    m_entries.push_back({due, key});
+    std::push_heap(m_entries.begin(), m_entries.end());
+}
+
+ChatDueHeap::Entry ChatDueHeap::pop()
+{
+    std::pop_heap(m_entries.begin(), m_entries.end());
+    Entry entry = std::move(m_entries.back());
+    m_entries.pop_back();
+    return entry;
+}
+
+void ChatDueHeap::arm(QTimer* timer) const
+{
+    if (m_entries.empty()) {
+        timer->stop();
+        return;
+    }
+
+    // Entries already due go on with the next event loop iteration
+    const qint64 delay = m_entries.front().due - QDateTime::currentMSecsSinceEpoch();
+    timer->start(int(qBound<qint64>(0, delay, MAX_TIMER_DELAY)));
+}
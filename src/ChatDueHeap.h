@@ -0,0 +1,60 @@
+/*
+ * ChatDueHeap.h - declaration of ChatHistoryCompactor class
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#pragma once
+
+#include <QString>
+#include <vector>
+
+class QTimer;
+
+// Keys ordered by due time, in milliseconds since the epoch, for the timed
+// parts of the chat which drive one single-shot QTimer for all pending
+// entries. Entries are never searched for; owners skip stale ones as they
+// reach the top.
+class ChatDueHeap
+{
+public:
+    struct Entry
+    {
+        qint64 due;
+        QString key;
+
+        // std::push_heap builds a max-heap, so order by later due time
+        bool operator<(const Entry& other) const { return due > other.due; }
+    };
+
+    void push(const QString& key, qint64 due);
+    Entry pop();
+    void clear() { m_entries.clear(); }
+
+    bool isEmpty() const { return m_entries.empty(); }
+    const Entry& top() const { return m_entries.front(); }
+
+    // Starts the timer for the earliest entry, or stops it if there is none
+    void arm(QTimer* timer) const;
+
+private:
+    std::vector<Entry> m_entries;
+};
@@ -28,11 +28,90 @@
 #include "VeyonWorkerInterface.h"
 #include "ComputerControlInterface.h"
 #include <QApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QStandardPaths>
 #include <QShortcut>
+#include <QTimer>
 #include <QKeySequence>
 
+#include "ChatCommandDispatcher.h"
+#include "ChatFileTransfer.h"
+#include "ChatIngressPipeline.h"
+#include "ChatMetrics.h"
+#include "ChatMetricsServer.h"
+#include "ChatOutbox.h"
+#include "ChatReplicator.h"
+#include "ChatRequestIntake.h"
 #include "ChatSignalListener.h"
 
+namespace {
+constexpr auto MASTER_APPLICATION_NAME = "ChatMaster";
+constexpr auto CLIENT_APPLICATION_NAME = "ChatClient";
+// A master which sends heartbeats is considered gone after missing three
+constexpr int MASTER_TIMEOUT = 3 * ChatSession::HeartbeatInterval;
+
+// Commands by number, as labels of the message counters
+const QStringList& commandNames()
+{
+    static const QStringList names{
+        QStringLiteral("OpenChatWindow"), QStringLiteral("SendMessage"), QStringLiteral("ReceiveMessage"),
+        QStringLiteral("UpdateStatus"), QStringLiteral("ClearChat"), QStringLiteral("GlobalBroadcast"),
+        QStringLiteral("Heartbeat"), QStringLiteral("Batch"), QStringLiteral("Acknowledge"),
+        QStringLiteral("ResyncRequest"), QStringLiteral("Resync"), QStringLiteral("FileOffer"),
+        QStringLiteral("FileChunk"), QStringLiteral("FileAck")
+    };
+    return names;
+}
+
+ChatCounterFamily& messagesIn()
+{
+    static auto& family = ChatMetrics::instance().counterFamily(
+        QStringLiteral("chat_messages_in_total"), QStringLiteral("Feature messages received, by command"),
+        QStringLiteral("command"), commandNames());
+    return family;
+}
+
+ChatCounterFamily& messagesOut()
+{
+    static auto& family = ChatMetrics::instance().counterFamily(
+        QStringLiteral("chat_messages_out_total"), QStringLiteral("Feature messages sent per recipient, by command"),
+        QStringLiteral("command"), commandNames());
+    return family;
+}
+
+ChatHistogram& encodeTime()
+{
+    static auto& histogram = ChatMetrics::instance().histogram(
+        QStringLiteral("chat_encode_seconds"), QStringLiteral("Time to build an outgoing feature message"));
+    return histogram;
+}
+
+ChatHistogram& fanOutTime()
+{
+    static auto& histogram = ChatMetrics::instance().histogram(
+        QStringLiteral("chat_fanout_seconds"), QStringLiteral("Time to hand a feature message to all its recipients"));
+    return histogram;
+}
+
+ChatGauge& outboxDepth()
+{
+    static auto& gauge = ChatMetrics::instance().gauge(
+        QStringLiteral("chat_outbox_depth"), QStringLiteral("Messages queued by a client while disconnected"));
+    return gauge;
+}
+
+QJsonArray messagesToJson(const QList<ChatMessage>& messages)
+{
+    QJsonArray array;
+    for (const auto& message : messages) {
+        array.append(message.toJson());
+    }
+    return array;
+}
+}
+
 ChatFeaturePlugin::ChatFeaturePlugin(QObject* parent) :
     QObject(parent),
     m_chatFeature(chatFeatureUid(),
@@ -46,16 +125,47 @@ ChatFeaturePlugin::ChatFeaturePlugin(QObject* parent) :
     m_masterWidget(nullptr),
     m_serviceClient(nullptr),
     m_workerInterface(nullptr),
-    m_signalListener(new ChatSignalListener(this))
+    m_deliveringWorker(nullptr),
+    m_masterHeartbeats(false),
+    m_signalListener(nullptr),
+    m_requestIntake(new ChatRequestIntake(this)),
+    m_outbox(nullptr),
+    m_masterIngress(new ChatIngressPipeline(QStringLiteral("ChatMasterIngress"), this)),
+    m_clientIngress(new ChatIngressPipeline(QStringLiteral("ChatClientIngress"), this)),
+    m_fileSender(nullptr),
+    m_fileReceiver(nullptr),
+    m_replicator(nullptr),
+    m_metricsServer(nullptr),
+    m_heartbeatTimer(nullptr),
+    m_controlCommands(chatFeatureUid()),
+    m_masterCommands(chatFeatureUid()),
+    m_clientCommands(chatFeatureUid())
 {
     initializeFeatures();
+    initializeCommands();
     setupKeyboardShortcuts();
 
-    connect(m_signalListener, &ChatSignalListener::requestFromHost, this, [this](const QString& host) {
-        openOrFocusChatForHost(host);
+    // The plugin is loaded by the service and worker processes as well, only
+    // the master must occupy the request port and join the multicast group
+    if (QFileInfo(QCoreApplication::applicationFilePath()).baseName().startsWith(QLatin1String("veyon-master"))) {
+        ensureSignalListener();
+    }
+
+    connect(m_requestIntake, &ChatRequestIntake::requestQueued, this, [this](const QString& clientId) {
+        // Only bring the window up when it is not shown yet, never steal the
+        // selection or focus from an ongoing conversation
+        if (!m_masterWidget || m_masterWidget->isHidden()) {
+            openChatWindow();
+        }
+        m_masterWidget->addChatRequest(clientId);
     });
 }
 
+ChatFeaturePlugin::~ChatFeaturePlugin()
+{
+    delete m_outbox;
+}
+
 Plugin::Uid ChatFeaturePlugin::uid() const
 {
     return QStringLiteral("a1b2c3d4-e5f6-7890-abcd-ef1234567890");
@@ -105,18 +215,25 @@ bool ChatFeaturePlugin::controlFeature(Feature::Uid featureUid, Operation operat
                                       const QVariantMap& arguments,
                                       const ComputerControlInterfaceList& computerControlInterfaces)
 {
-    if (featureUid != chatFeatureUid()) {
+    if (!m_controlCommands.accepts(featureUid)) {
         return false;
     }
 
     switch (operation) {
         case Operation::Start:
             m_activeControlInterfaces = computerControlInterfaces;
+            m_controlInterfaceByClient.clear();
+            for (auto* controlInterface : computerControlInterfaces) {
+                if (controlInterface) {
+                    m_controlInterfaceByClient.insert(controlInterface->computer().hostAddress(), controlInterface);
+                }
+            }
             openChatWindow();
             return true;
 
         case Operation::Stop:
             m_activeControlInterfaces.clear();
+            m_controlInterfaceByClient.clear();
             if (m_masterWidget) {
                 m_masterWidget->close();
             }
@@ -127,51 +244,8 @@ bool ChatFeaturePlugin::controlFeature(Feature::Uid featureUid, Operation operat
     }
 
     // Handle specific chat commands
-    const auto command = static_cast<Commands>(arguments.value("command").toInt());
-    
-    switch (command) {
-        case SendMessage: {
-            const auto message = ChatMessage::fromJson(arguments.value("message").toJsonObject());
-            for (const auto& controlInterface : computerControlInterfaces) {
-                FeatureMessage featureMessage(featureUid, command);
-                featureMessage.addArgument("message", message.toJson());
-                controlInterface->sendFeatureMessage(featureMessage, false);
-            }
-            return true;
-        }
-
-        case GlobalBroadcast: {
-            const auto content = arguments.value("content").toString();
-            const auto priority = static_cast<ChatMessage::Priority>(arguments.value("priority").toInt());
-            
-            ChatMessage message("master", "all", content, priority);
-            
-            for (const auto& controlInterface : computerControlInterfaces) {
-                FeatureMessage featureMessage(featureUid, command);
-                featureMessage.addArgument("message", message.toJson());
-                controlInterface->sendFeatureMessage(featureMessage, false);
-            }
-            return true;
-        }
-
-        case ClearChat: {
-            const auto clientId = arguments.value("clientId").toString();
-            
-            for (const auto& controlInterface : computerControlInterfaces) {
-                if (controlInterface->computer().hostAddress() == clientId) {
-                    FeatureMessage featureMessage(featureUid, command);
-                    controlInterface->sendFeatureMessage(featureMessage, false);
-                    break;
-                }
-            }
-            return true;
-        }
-
-        default:
-            break;
-    }
-
-    return false;
+    const auto command = chatArgument(arguments, ChatArgumentId::Command).toInt();
+    return m_controlCommands.dispatch(command, arguments, computerControlInterfaces);
 }
 
 bool ChatFeaturePlugin::handleFeatureMessage(VeyonServerInterface& server,
@@ -181,151 +255,251 @@ bool ChatFeaturePlugin::handleFeatureMessage(VeyonServerInterface& server,
     Q_UNUSED(server)
     Q_UNUSED(messageContext)
 
-    if (message.featureUid() != chatFeatureUid()) {
+    if (!m_masterCommands.accepts(message.featureUid())) {
         return false;
     }
 
-    const auto command = static_cast<Commands>(message.command());
-
-    switch (command) {
-        case ReceiveMessage: {
-            // Forward message to master widget if it exists
-            if (m_masterWidget) {
-                const auto chatMessage = ChatMessage::fromJson(message.argument("message").toJsonObject());
-                m_masterWidget->receiveMessage(chatMessage);
-            }
-            return true;
-        }
-
-        case UpdateStatus: {
-            // Update client status in master widget
-            if (m_masterWidget) {
-                const auto clientId = message.argument("clientId").toString();
-                const auto status = static_cast<ChatSession::ClientStatus>(message.argument("status").toInt());
-                m_masterWidget->updateClientStatus(clientId, status);
-            }
-            return true;
-        }
-
-        default:
-            break;
+    if (!m_masterCommands.handles(message.command())) {
+        return false;
     }
 
-    return false;
+    // Decoded on the ingress thread, whichever thread Veyon delivers on
+    messagesIn().increment(message.command());
+    m_masterIngress->submit(message);
+    return true;
 }
 
 bool ChatFeaturePlugin::handleFeatureMessage(VeyonWorkerInterface& worker, const FeatureMessage& message)
 {
-    if (message.featureUid() != chatFeatureUid()) {
+    if (!m_clientCommands.accepts(message.featureUid())) {
         return false;
     }
 
-    // Initialize service client if not already done
-    if (!m_serviceClient) {
-        m_serviceClient = new ChatServiceClient(this);
-        connect(m_serviceClient, &ChatServiceClient::sendMessage,
-                this, [this](const ChatMessage& chatMessage) {
-                    if (!m_workerInterface) {
-                        return;
-                    }
-
-                    FeatureMessage featureMessage(chatFeatureUid(), ReceiveMessage);
-                    featureMessage.addArgument(QStringLiteral("message"), chatMessage.toJson());
-                    m_workerInterface->sendFeatureMessage(featureMessage);
-                });
-
-        connect(m_serviceClient, &ChatServiceClient::statusChanged,
-                this, [this](ChatSession::ClientStatus status) {
-                    if (!m_workerInterface) {
-                        return;
-                    }
-
-                    FeatureMessage featureMessage(chatFeatureUid(), UpdateStatus);
-                    featureMessage.addArgument(QStringLiteral("clientId"), m_serviceClient->clientId());
-                    featureMessage.addArgument(QStringLiteral("status"), static_cast<int>(status));
-                    m_workerInterface->sendFeatureMessage(featureMessage);
-                });
+    if (!m_clientCommands.handles(message.command())) {
+        return false;
     }
 
-    m_workerInterface = &worker;
+    // Everything else happens on the GUI thread, see connectWorker()
+    m_deliveringWorker.store(&worker);
+    messagesIn().increment(message.command());
+    m_clientIngress->submit(message);
+    return true;
+}
 
-    const auto command = static_cast<Commands>(message.command());
+void ChatFeaturePlugin::initializeServiceClient()
+{
+    m_serviceClient = new ChatServiceClient(this);
+    if (!m_metricsServer) {
+        m_metricsServer = new ChatMetricsServer(CLIENT_APPLICATION_NAME, QStringLiteral("veyon-chat-client-metrics"), this);
+    }
+    connect(m_serviceClient, &ChatServiceClient::sendMessage,
+            this, [this](const ChatMessage& chatMessage) {
+                sendToMaster(ReceiveMessage, {{chatArgumentKey(ChatArgumentId::Message), chatMessage.toJson()}});
+            });
+
+    connect(m_serviceClient, &ChatServiceClient::statusChanged,
+            this, [this](ChatSession::ClientStatus status) {
+                QJsonObject arguments{
+                    {chatArgumentKey(ChatArgumentId::ClientId), m_serviceClient->clientId()},
+                    {chatArgumentKey(ChatArgumentId::Status), static_cast<int>(status)}
+                };
+                if (status == ChatSession::ClientStatus::Typing) {
+                    arguments.insert(chatArgumentKey(ChatArgumentId::Lease), ChatSession::TypingLease);
+                }
+                sendToMaster(UpdateStatus, arguments);
+            });
 
-    switch (command) {
-        case SendMessage: {
-            const auto chatMessage = ChatMessage::fromJson(message.argument("message").toJsonObject());
-            m_serviceClient->receiveMessage(chatMessage);
-            return true;
-        }
+    connect(m_serviceClient, &ChatServiceClient::heartbeat,
+            this, [this]() {
+                if (m_workerInterface && m_masterHeartbeats && m_masterContact.hasExpired(MASTER_TIMEOUT)) {
+                    disconnectWorker();
+                }
 
-        case GlobalBroadcast: {
-            const auto chatMessage = ChatMessage::fromJson(message.argument("message").toJsonObject());
-            m_serviceClient->receiveMessage(chatMessage);
-            return true;
-        }
+                // Heartbeats are worthless once stale, the flushed batch
+                // counts as one anyway
+                if (m_workerInterface) {
+                    sendToMaster(Heartbeat, {{chatArgumentKey(ChatArgumentId::ClientId), m_serviceClient->clientId()}});
+                }
+            });
+
+    connect(m_serviceClient, &ChatServiceClient::acknowledge,
+            this, [this](quint32 delivered, quint32 read) {
+                sendToMaster(Acknowledge, {
+                    {chatArgumentKey(ChatArgumentId::ClientId), m_serviceClient->clientId()},
+                    {chatArgumentKey(ChatArgumentId::Delivered), static_cast<qint64>(delivered)},
+                    {chatArgumentKey(ChatArgumentId::Read), static_cast<qint64>(read)}
+                });
+            });
+
+    connect(m_serviceClient, &ChatServiceClient::resyncRequested,
+            this, [this](quint32 first, quint32 last) {
+                sendToMaster(ResyncRequest, {
+                    {chatArgumentKey(ChatArgumentId::ClientId), m_serviceClient->clientId()},
+                    {chatArgumentKey(ChatArgumentId::First), static_cast<qint64>(first)},
+                    {chatArgumentKey(ChatArgumentId::Last), static_cast<qint64>(last)}
+                });
+            });
+
+    m_fileReceiver = new ChatFileReceiver(this);
+    connect(m_fileReceiver, &ChatFileReceiver::acknowledge,
+            this, [this](const QString& transferId, quint32 next) {
+                // Not queued while disconnected, the master repeats its
+                // offer and the answer to that resumes the transfer
+                if (m_workerInterface) {
+                    sendToMaster(FileAck, {
+                        {chatArgumentKey(ChatArgumentId::ClientId), m_serviceClient->clientId()},
+                        {chatArgumentKey(ChatArgumentId::Transfer), transferId},
+                        {chatArgumentKey(ChatArgumentId::Next), static_cast<qint64>(next)}
+                    });
+                }
+            });
 
-        case ClearChat: {
-            m_serviceClient->clearChat();
-            return true;
-        }
+    connect(m_fileReceiver, &ChatFileReceiver::fileReceived,
+            this, [this](const QString& fileName, const QString& filePath) {
+                m_serviceClient->receiveMessage(ChatMessage(QStringLiteral("master"), m_serviceClient->clientId(),
+                                                            tr("File %1 saved to %2").arg(fileName, filePath)));
+            });
+}
 
-        default:
-            break;
+void ChatFeaturePlugin::connectWorker(bool heartbeat)
+{
+    if (!m_serviceClient) {
+        initializeServiceClient();
     }
 
-    return false;
+    // Any message from the master proves the connection
+    m_workerInterface = m_deliveringWorker.load();
+    m_masterContact.start();
+    if (heartbeat) {
+        m_masterHeartbeats = true;
+    }
+    flushOutbox();
 }
 
 void ChatFeaturePlugin::openChatWindow()
 {
+    ensureSignalListener();
+
     if (!m_masterWidget) {
         m_masterWidget = new ChatMasterWidget();
+        if (!m_metricsServer) {
+            m_metricsServer = new ChatMetricsServer(MASTER_APPLICATION_NAME, QStringLiteral("veyon-chat-master-metrics"), this);
+        }
 
         // Connect signals for message handling
         connect(m_masterWidget, &ChatMasterWidget::sendMessage,
                 this, [this](const ChatMessage& message) {
+                    const ChatMetricsTimer fanOutTimer(fanOutTime());
+
+                    FeatureMessage featureMessage(chatFeatureUid(), SendMessage);
+                    {
+                        const ChatMetricsTimer encodeTimer(encodeTime());
+                        featureMessage.addArgument(chatArgumentKey(ChatArgumentId::Message), message.toJson());
+                    }
+
                     for (auto* controlInterface : m_activeControlInterfaces) {
-                        if (!controlInterface) {
-                            continue;
+                        if (controlInterface) {
+                            send(controlInterface, featureMessage);
                         }
-
-                        FeatureMessage featureMessage(chatFeatureUid(), SendMessage);
-                        featureMessage.addArgument(QStringLiteral("message"), message.toJson());
-                        controlInterface->sendFeatureMessage(featureMessage, false);
                     }
                 });
 
         connect(m_masterWidget, &ChatMasterWidget::sendGlobalMessage,
                 this, [this](const QString& content, ChatMessage::Priority priority) {
-                    ChatMessage broadcast(QStringLiteral("master"), QStringLiteral("all"), content, priority);
+                    const ChatMetricsTimer fanOutTimer(fanOutTime());
+
+                    FeatureMessage featureMessage(chatFeatureUid(), GlobalBroadcast);
+                    {
+                        const ChatMetricsTimer encodeTimer(encodeTime());
+                        const ChatMessage broadcast(QStringLiteral("master"), QStringLiteral("all"), content, priority);
+                        featureMessage.addArgument(chatArgumentKey(ChatArgumentId::Message), broadcast.toJson());
+                    }
 
                     for (auto* controlInterface : m_activeControlInterfaces) {
-                        if (!controlInterface) {
-                            continue;
+                        if (controlInterface) {
+                            send(controlInterface, featureMessage);
                         }
-
-                        FeatureMessage featureMessage(chatFeatureUid(), GlobalBroadcast);
-                        featureMessage.addArgument(QStringLiteral("message"), broadcast.toJson());
-                        controlInterface->sendFeatureMessage(featureMessage, false);
                     }
                 });
 
-        connect(m_masterWidget, &ChatMasterWidget::clearClientChat,
-                this, [this](const QString& clientId) {
-                    for (auto* controlInterface : m_activeControlInterfaces) {
-                        if (!controlInterface) {
-                            continue;
-                        }
+        connect(m_masterWidget, &ChatMasterWidget::sendGroupMessage,
+                this, [this](const ChatMessage& message, const QStringList& clientIds) {
+                    const ChatMetricsTimer fanOutTimer(fanOutTime());
 
-                        if (!clientId.isEmpty() && controlInterface->computer().hostAddress() != clientId) {
-                            continue;
-                        }
+                    FeatureMessage featureMessage(chatFeatureUid(), SendMessage);
+                    {
+                        const ChatMetricsTimer encodeTimer(encodeTime());
+                        featureMessage.addArgument(chatArgumentKey(ChatArgumentId::Message), message.toJson());
+                    }
 
-                        FeatureMessage featureMessage(chatFeatureUid(), ClearChat);
-                        featureMessage.addArgument(QStringLiteral("clientId"), clientId);
-                        controlInterface->sendFeatureMessage(featureMessage, false);
+                    for (const auto& clientId : clientIds) {
+                        if (auto* controlInterface = m_controlInterfaceByClient.value(clientId)) {
+                            send(controlInterface, featureMessage);
+                        }
                     }
                 });
+
+        // Lets clients notice a lost connection while the teacher is silent
+        m_heartbeatTimer = new QTimer(this);
+        m_heartbeatTimer->setInterval(ChatSession::HeartbeatInterval);
+        connect(m_heartbeatTimer, &QTimer::timeout, this, [this]() {
+            sendToClients(Heartbeat, {});
+        });
+        m_heartbeatTimer->start();
+
+        connect(m_masterWidget, &ChatMasterWidget::resyncRequested,
+                this, [this](const QString& clientId, quint32 first, quint32 last) {
+                    sendToClient(clientId, ResyncRequest, {
+                        {chatArgumentKey(ChatArgumentId::ClientId), clientId},
+                        {chatArgumentKey(ChatArgumentId::First), static_cast<qint64>(first)},
+                        {chatArgumentKey(ChatArgumentId::Last), static_cast<qint64>(last)}
+                    });
+                });
+
+        // Sessions shared with other masters in the room, if configured
+        m_replicator = new ChatReplicator(this);
+        if (m_replicator->isEnabled()) {
+            connect(m_masterWidget, &ChatMasterWidget::messageRecorded, m_replicator, &ChatReplicator::recordMessage);
+            connect(m_masterWidget, &ChatMasterWidget::sessionRead, m_replicator, &ChatReplicator::recordRead);
+            connect(m_masterWidget, &ChatMasterWidget::sessionCleared, m_replicator, &ChatReplicator::recordClear);
+            connect(m_replicator, &ChatReplicator::messageMerged, m_masterWidget, &ChatMasterWidget::mergeMessage);
+            connect(m_replicator, &ChatReplicator::readMerged, m_masterWidget, &ChatMasterWidget::mergeRead);
+            connect(m_replicator, &ChatReplicator::clearMerged, m_masterWidget, &ChatMasterWidget::mergeClear);
+        }
+
+        m_fileSender = new ChatFileSender(this);
+        connect(m_masterWidget, &ChatMasterWidget::sendFile, m_fileSender, &ChatFileSender::send);
+
+        connect(m_fileSender, &ChatFileSender::sendOffer,
+                this, [this](const QString& clientId, const ChatFileOffer& offer) {
+                    FeatureMessage featureMessage(chatFeatureUid(), FileOffer);
+                    featureMessage.addArgument(chatArgumentKey(ChatArgumentId::Transfer), offer.transferId);
+                    featureMessage.addArgument(chatArgumentKey(ChatArgumentId::FileName), offer.fileName);
+                    featureMessage.addArgument(chatArgumentKey(ChatArgumentId::Size), offer.size);
+                    featureMessage.addArgument(chatArgumentKey(ChatArgumentId::ChunkSize), offer.chunkSize);
+                    sendToClient(clientId, featureMessage);
+                });
+
+        connect(m_fileSender, &ChatFileSender::sendChunk,
+                this, [this](const QString& clientId, const ChatFileChunk& chunk) {
+                    // Built once, whether it goes to one student or the class
+                    FeatureMessage featureMessage(chatFeatureUid(), FileChunk);
+                    featureMessage.addArgument(chatArgumentKey(ChatArgumentId::Transfer), chunk.transferId);
+                    featureMessage.addArgument(chatArgumentKey(ChatArgumentId::Index), chunk.index);
+                    featureMessage.addArgument(chatArgumentKey(ChatArgumentId::Checksum), chunk.checksum);
+                    featureMessage.addArgument(chatArgumentKey(ChatArgumentId::Data), chunk.data);
+                    sendToClient(clientId, featureMessage);
+                });
+
+        connect(m_masterWidget, &ChatMasterWidget::chatRequestResolved,
+                m_requestIntake, &ChatRequestIntake::resolve);
+
+        connect(m_masterWidget, &ChatMasterWidget::clearClientChat,
+                this, [this](const QString& clientId) {
+                    FeatureMessage featureMessage(chatFeatureUid(), ClearChat);
+                    featureMessage.addArgument(chatArgumentKey(ChatArgumentId::ClientId), clientId);
+                    sendToClient(clientId, featureMessage);
+                });
     }
 
     m_masterWidget->show();
@@ -333,14 +507,164 @@ void ChatFeaturePlugin::openChatWindow()
     m_masterWidget->activateWindow();
 }
 
-void ChatFeaturePlugin::openOrFocusChatForHost(const QString& hostName)
+void ChatFeaturePlugin::ensureSignalListener()
 {
-    openChatWindow();
+    if (m_signalListener) {
+        return;
+    }
 
-    if (!m_masterWidget) {
+    m_signalListener = new ChatSignalListener(this);
+    connect(m_signalListener, &ChatSignalListener::requestFromHost, this, &ChatFeaturePlugin::queueChatRequest);
+}
+
+void ChatFeaturePlugin::postToMaster(std::function<void()>&& action)
+{
+    // m_masterWidget is only ever touched on the GUI thread
+    m_masterIngress->post([this, action = std::move(action)]() {
+        if (m_masterWidget) {
+            action();
+        }
+    });
+}
+
+void ChatFeaturePlugin::sendToMaster(Commands command, const QJsonObject& arguments)
+{
+    // Only the latest status and receipt matter
+    const bool supersede = command == UpdateStatus || command == Acknowledge;
+
+    if (!m_workerInterface) {
+        outbox().enqueue(command, arguments, supersede);
+        outboxDepth().set(outbox().size());
         return;
     }
 
+    // Keep the order: anything still queued goes out first
+    if (!outbox().isEmpty()) {
+        outbox().enqueue(command, arguments, supersede);
+        flushOutbox();
+        return;
+    }
+
+    FeatureMessage featureMessage(chatFeatureUid(), command);
+    {
+        const ChatMetricsTimer encodeTimer(encodeTime());
+        addArguments(featureMessage, arguments);
+    }
+    messagesOut().increment(command);
+    if (!m_workerInterface->sendFeatureMessage(featureMessage)) {
+        disconnectWorker();
+        outbox().enqueue(command, arguments, supersede);
+        outboxDepth().set(outbox().size());
+    }
+}
+
+void ChatFeaturePlugin::sendToClients(Commands command, const QJsonObject& arguments)
+{
+    const ChatMetricsTimer fanOutTimer(fanOutTime());
+
+    // Addressed by the clientId argument, which clients compare with their own
+    FeatureMessage featureMessage(chatFeatureUid(), command);
+    {
+        const ChatMetricsTimer encodeTimer(encodeTime());
+        addArguments(featureMessage, arguments);
+    }
+
+    for (auto* controlInterface : m_activeControlInterfaces) {
+        if (controlInterface) {
+            send(controlInterface, featureMessage);
+        }
+    }
+}
+
+void ChatFeaturePlugin::sendToClient(const QString& clientId, Commands command, const QJsonObject& arguments)
+{
+    FeatureMessage featureMessage(chatFeatureUid(), command);
+    {
+        const ChatMetricsTimer encodeTimer(encodeTime());
+        addArguments(featureMessage, arguments);
+    }
+    sendToClient(clientId, featureMessage);
+}
+
+void ChatFeaturePlugin::sendToClient(const QString& clientId, const FeatureMessage& featureMessage)
+{
+    const ChatMetricsTimer fanOutTimer(fanOutTime());
+
+    // An empty client id addresses every student
+    if (!clientId.isEmpty()) {
+        if (auto* controlInterface = m_controlInterfaceByClient.value(clientId)) {
+            send(controlInterface, featureMessage);
+        }
+        return;
+    }
+
+    for (auto* controlInterface : m_activeControlInterfaces) {
+        if (controlInterface) {
+            send(controlInterface, featureMessage);
+        }
+    }
+}
+
+void ChatFeaturePlugin::send(ComputerControlInterface* controlInterface, const FeatureMessage& featureMessage)
+{
+    messagesOut().increment(featureMessage.command());
+    controlInterface->sendFeatureMessage(featureMessage, false);
+}
+
+void ChatFeaturePlugin::flushOutbox()
+{
+    // Also picks up what was queued before a worker restart
+    if (!m_workerInterface || outbox().isEmpty()) {
+        return;
+    }
+
+    FeatureMessage featureMessage(chatFeatureUid(), Batch);
+    featureMessage.addArgument(chatArgumentKey(ChatArgumentId::Messages), outbox().batch());
+    messagesOut().increment(Batch);
+
+    // Kept for the next connection if the batch cannot be sent
+    if (!m_workerInterface->sendFeatureMessage(featureMessage)) {
+        disconnectWorker();
+        return;
+    }
+
+    outbox().clear();
+    outboxDepth().set(0);
+}
+
+void ChatFeaturePlugin::disconnectWorker()
+{
+    // Everything sent until the next message from the master is queued
+    m_workerInterface = nullptr;
+}
+
+ChatOutbox& ChatFeaturePlugin::outbox()
+{
+    if (!m_outbox) {
+        QDir directory(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation));
+        directory.mkpath(QStringLiteral("."));
+        m_outbox = new ChatOutbox(directory.filePath(QStringLiteral("chat-outbox.json")));
+    }
+
+    return *m_outbox;
+}
+
+void ChatFeaturePlugin::addArguments(FeatureMessage& message, const QJsonObject& arguments)
+{
+    for (auto it = arguments.constBegin(); it != arguments.constEnd(); ++it) {
+        // Receivers read nested objects such as chat messages via toJsonObject()
+        message.addArgument(it.key(), it.value().isObject() ? QVariant(it.value().toObject())
+                                                            : it.value().toVariant());
+    }
+}
+
+void ChatFeaturePlugin::queueChatRequest(const QString& hostName)
+{
+    m_requestIntake->submit(resolveClientId(hostName));
+}
+
+QString ChatFeaturePlugin::resolveClientId(const QString& hostName) const
+{
     QString targetId = hostName;
 
     for (ComputerControlInterface* controlInterface : m_activeControlInterfaces) {
@@ -355,9 +679,7 @@ void ChatFeaturePlugin::openOrFocusChatForHost(const QString& hostName)
         }
     }
 
-    if (!targetId.isEmpty()) {
-        m_masterWidget->focusClient(targetId);
-    }
+    return targetId;
 }
 
 void ChatFeaturePlugin::initializeFeatures()
@@ -365,6 +687,199 @@ void ChatFeaturePlugin::initializeFeatures()
     m_features = { m_chatFeature };
 }
 
+void ChatFeaturePlugin::initializeCommands()
+{
+    using namespace ChatArguments;
+
+    // Sent by the master UI through controlFeature()
+    m_controlCommands.add<Message>(SendMessage,
+        [this](const ComputerControlInterfaceList& computerControlInterfaces, const ChatMessage& message) {
+            for (const auto& controlInterface : computerControlInterfaces) {
+                FeatureMessage featureMessage(chatFeatureUid(), SendMessage);
+                featureMessage.addArgument(chatArgumentKey(ChatArgumentId::Message), message.toJson());
+                send(controlInterface, featureMessage);
+            }
+        });
+
+    m_controlCommands.add<Content, Priority>(GlobalBroadcast,
+        [this](const ComputerControlInterfaceList& computerControlInterfaces,
+               const QString& content, ChatMessage::Priority priority) {
+            ChatMessage message("master", "all", content, priority);
+
+            for (const auto& controlInterface : computerControlInterfaces) {
+                FeatureMessage featureMessage(chatFeatureUid(), GlobalBroadcast);
+                featureMessage.addArgument(chatArgumentKey(ChatArgumentId::Message), message.toJson());
+                send(controlInterface, featureMessage);
+            }
+        });
+
+    m_controlCommands.add<ClientId>(ClearChat,
+        [this](const ComputerControlInterfaceList& computerControlInterfaces, const QString& clientId) {
+            for (const auto& controlInterface : computerControlInterfaces) {
+                if (controlInterface->computer().hostAddress() == clientId) {
+                    FeatureMessage featureMessage(chatFeatureUid(), ClearChat);
+                    send(controlInterface, featureMessage);
+                    break;
+                }
+            }
+        });
+
+    // Received by the master from clients. The handlers run on the ingress
+    // thread and only hand decoded values to the GUI thread, where they are
+    // dropped unless a chat window exists.
+    m_masterCommands.add<Message>(ReceiveMessage, [this](const ChatMessage& message) {
+        if (m_masterIngress->acceptMessage(message)) {
+            postToMaster([this, message]() { m_masterWidget->receiveMessage(message); });
+        }
+    });
+
+    m_masterCommands.add<ClientId, Status, Lease>(UpdateStatus,
+        [this](const QString& clientId, ChatSession::ClientStatus status, int lease) {
+            postToMaster([=]() { m_masterWidget->updateClientStatus(clientId, status, lease); });
+        });
+
+    m_masterCommands.add<ClientId>(Heartbeat, [this](const QString& clientId) {
+        postToMaster([this, clientId]() { m_masterWidget->touchClient(clientId); });
+    });
+
+    // A client noticed a gap in the master's messages to it
+    m_masterCommands.add<ClientId, First, Last>(ResyncRequest,
+        [this](const QString& clientId, quint32 first, quint32 last) {
+            // Another student's history must never reach the whole class
+            if (clientId.isEmpty()) {
+                return;
+            }
+            postToMaster([=]() {
+                sendToClient(clientId, Resync, {
+                    {chatArgumentKey(ChatArgumentId::ClientId), clientId},
+                    {chatArgumentKey(ChatArgumentId::Last), static_cast<qint64>(last)},
+                    {chatArgumentKey(ChatArgumentId::Messages), messagesToJson(m_masterWidget->sentMessages(clientId, first, last))}
+                });
+            });
+        });
+
+    m_masterCommands.add<ClientId, Messages, Last>(Resync,
+        [this](const QString& clientId, const QList<ChatMessage>& messages, quint32 last) {
+            // Resent messages may have arrived late after all
+            QList<ChatMessage> missing;
+            for (const auto& message : messages) {
+                if (m_masterIngress->acceptMessage(message)) {
+                    missing.append(message);
+                }
+            }
+            postToMaster([=]() { m_masterWidget->receiveResync(clientId, missing, last); });
+        });
+
+    m_masterCommands.add<ClientId, Delivered, Read>(Acknowledge,
+        [this](const QString& clientId, quint32 delivered, quint32 read) {
+            postToMaster([=]() { m_masterWidget->acknowledgeMessages(clientId, delivered, read); });
+        });
+
+    m_masterCommands.add<ClientId, Transfer, Next>(FileAck,
+        [this](const QString& clientId, const QString& transferId, quint32 next) {
+            postToMaster([=]() { m_fileSender->acknowledge(transferId, clientId, next); });
+        });
+
+    // Messages queued by a client while it was disconnected, in sequence order
+    m_masterCommands.add<Entries>(Batch, [this](const QJsonArray& entries) {
+        for (const auto& value : entries) {
+            const auto entry = value.toObject();
+            const auto entryCommand = entry.value(QStringLiteral("command")).toInt();
+            if (entryCommand == Batch) {
+                continue;
+            }
+
+            FeatureMessage entryMessage(chatFeatureUid(), entryCommand);
+            addArguments(entryMessage, entry.value(QStringLiteral("arguments")).toObject());
+            m_masterCommands.dispatch(entryCommand, entryMessage);
+        }
+    });
+
+    // Received by a client's worker from the master, on the ingress thread.
+    // The service client is created and used on the GUI thread only, so
+    // everything touching it is posted.
+    m_clientCommands.add<Message>(SendMessage, [this](const ChatMessage& message) {
+        if (m_clientIngress->acceptMessage(message)) {
+            m_clientIngress->post([this, message]() { m_serviceClient->receiveMessage(message); });
+        }
+    });
+
+    m_clientCommands.add<Message>(GlobalBroadcast, [this](const ChatMessage& message) {
+        if (m_clientIngress->acceptMessage(message)) {
+            m_clientIngress->post([this, message]() { m_serviceClient->receiveMessage(message); });
+        }
+    });
+
+    // Only proves the connection, see connectWorker()
+    m_clientCommands.add<>(Heartbeat, []() {});
+
+    m_clientCommands.add<>(ClearChat, [this]() {
+        m_clientIngress->post([this]() { m_serviceClient->clearChat(); });
+    });
+
+    // The master noticed a gap in this client's messages
+    m_clientCommands.add<ClientId, First, Last>(ResyncRequest,
+        [this](const QString& clientId, quint32 first, quint32 last) {
+            m_clientIngress->post([=]() {
+                if (clientId != m_serviceClient->clientId()) {
+                    return;
+                }
+                sendToMaster(Resync, {
+                    {chatArgumentKey(ChatArgumentId::ClientId), clientId},
+                    {chatArgumentKey(ChatArgumentId::Last), static_cast<qint64>(last)},
+                    {chatArgumentKey(ChatArgumentId::Messages), messagesToJson(m_serviceClient->sentMessages(first, last))}
+                });
+            });
+        });
+
+    m_clientCommands.add<ClientId, Messages, Last>(Resync,
+        [this](const QString& clientId, const QList<ChatMessage>& messages, quint32 last) {
+            QList<ChatMessage> missing;
+            for (const auto& message : messages) {
+                if (m_clientIngress->acceptMessage(message)) {
+                    missing.append(message);
+                }
+            }
+            m_clientIngress->post([=]() {
+                if (clientId == m_serviceClient->clientId()) {
+                    m_serviceClient->receiveResync(missing, last);
+                }
+            });
+        });
+
+    m_clientCommands.add<Transfer, FileName, Size, ChunkSize>(FileOffer,
+        [this](const QString& transferId, const QString& fileName, qint64 size, int chunkSize) {
+            ChatFileOffer offer;
+            offer.transferId = transferId;
+            offer.fileName = fileName;
+            offer.size = size;
+            offer.chunkSize = chunkSize;
+            m_clientIngress->post([this, offer]() { m_fileReceiver->receiveOffer(offer); });
+        });
+
+    // Checksums are verified here, a corrupted chunk is treated as lost
+    m_clientCommands.add<Transfer, Index, Checksum, Data>(FileChunk,
+        [this](const QString& transferId, quint32 index, quint32 checksum, const QByteArray& data) {
+            ChatFileChunk chunk;
+            chunk.transferId = transferId;
+            chunk.index = index;
+            chunk.checksum = checksum;
+            chunk.data = data;
+            if (chunk.isValid()) {
+                m_clientIngress->post([this, chunk]() { m_fileReceiver->receiveChunk(chunk); });
+            }
+        });
+
+    m_masterIngress->setDecoder([this](const FeatureMessage& message) {
+        m_masterCommands.dispatch(message.command(), message);
+    });
+    m_clientIngress->setDecoder([this](const FeatureMessage& message) {
+        const bool heartbeat = message.command() == Heartbeat;
+        m_clientIngress->post([this, heartbeat]() { connectWorker(heartbeat); });
+        m_clientCommands.dispatch(message.command(), message);
+    });
+}
+
 void ChatFeaturePlugin::setupKeyboardShortcuts()
 {
     // Global F10 shortcut will be handled by the individual widgets
@@ -30,9 +30,23 @@
 #include "ChatMasterWidget.h"
 #include "ChatServiceClient.h"
 #include "ComputerControlInterface.h"
+#include "ChatCommandDispatcher.h"
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <atomic>
+#include <functional>
 
 class VeyonWorkerInterface;
+class ChatFileReceiver;
+class ChatFileSender;
+class ChatIngressPipeline;
+class ChatMetricsServer;
+class ChatOutbox;
+class ChatReplicator;
+class ChatRequestIntake;
 class ChatSignalListener;
+class QTimer;
 
 class ChatFeaturePlugin : public QObject, FeatureProviderInterface, PluginInterface
 {
@@ -42,7 +56,7 @@ class ChatFeaturePlugin : public QObject, FeatureProviderInterface, PluginInterf
 
 public:
     ChatFeaturePlugin(QObject* parent = nullptr);
-    ~ChatFeaturePlugin() override = default;
+    ~ChatFeaturePlugin() override;
 
     // PluginInterface
     Plugin::Uid uid() const override;
@@ -76,7 +90,15 @@ private:
         ReceiveMessage,
         UpdateStatus,
         ClearChat,
-        GlobalBroadcast
+        GlobalBroadcast,
+        Heartbeat,
+        Batch,
+        Acknowledge,
+        ResyncRequest,
+        Resync,
+        FileOffer,
+        FileChunk,
+        FileAck
     };
 
     const Feature m_chatFeature;
@@ -84,11 +106,49 @@ private:
     
     ChatMasterWidget* m_masterWidget;
     ChatServiceClient* m_serviceClient;
+    // Cleared when a send fails or a master that sends heartbeats has been
+    // silent for too long, messages are queued in the outbox meanwhile
     VeyonWorkerInterface* m_workerInterface;
+    // Set by whichever thread Veyon delivers the master's messages on
+    std::atomic<VeyonWorkerInterface*> m_deliveringWorker;
+    QElapsedTimer m_masterContact;
+    bool m_masterHeartbeats;
     ChatSignalListener* m_signalListener;
+    ChatRequestIntake* m_requestIntake;
+    ChatOutbox* m_outbox;
+    ChatIngressPipeline* m_masterIngress;
+    ChatIngressPipeline* m_clientIngress;
+    ChatFileSender* m_fileSender;
+    ChatFileReceiver* m_fileReceiver;
+    ChatReplicator* m_replicator;
+    ChatMetricsServer* m_metricsServer;
+    QTimer* m_heartbeatTimer;
     ComputerControlInterfaceList m_activeControlInterfaces;
+    // The same by client id, so sends to some students skip the rest
+    QHash<QString, ComputerControlInterface*> m_controlInterfaceByClient;
+
+    // Command handlers: master UI commands, messages from clients to the
+    // master, and messages from the master to a client
+    ChatCommandDispatcher<QVariantMap, const ComputerControlInterfaceList&> m_controlCommands;
+    ChatCommandDispatcher<FeatureMessage> m_masterCommands;
+    ChatCommandDispatcher<FeatureMessage> m_clientCommands;
 
     void initializeFeatures();
+    void initializeCommands();
     void setupKeyboardShortcuts();
-    void openOrFocusChatForHost(const QString& hostName);
+    void initializeServiceClient();
+    void connectWorker(bool heartbeat);
+    void ensureSignalListener();
+    void queueChatRequest(const QString& hostName);
+    void postToMaster(std::function<void()>&& action);
+    void sendToMaster(Commands command, const QJsonObject& arguments);
+    void sendToClients(Commands command, const QJsonObject& arguments);
+    void sendToClient(const QString& clientId, Commands command, const QJsonObject& arguments);
+    void sendToClient(const QString& clientId, const FeatureMessage& featureMessage);
+    static void send(ComputerControlInterface* controlInterface, const FeatureMessage& featureMessage);
+    void flushOutbox();
+    void disconnectWorker();
+    ChatOutbox& outbox();
+    static void addArguments(FeatureMessage& message, const QJsonObject& arguments);
+    QString resolveClientId(const QString& hostName) const;
 };
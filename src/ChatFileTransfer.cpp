@@ -0,0 +1,363 @@
+/*
+ * ChatFileTransfer.cpp - implementation of ChatFileSender and ChatFileReceiver classes
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include "ChatFileTransfer.h"
+
+#include <QDateTime>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <QTimer>
+#include <QUuid>
+
+namespace {
+constexpr int RETRY_INTERVAL = 1000;
+constexpr int OFFER_DELAY_INITIAL = 2000;
+constexpr int OFFER_DELAY_MAX = 30000;
+// Transfers nobody answered for this long are dropped
+constexpr qint64 TRANSFER_EXPIRY = 10 * 60 * 1000;
+// Repeated acks for the same missing chunk only rewind once per interval
+constexpr qint64 REWIND_INTERVAL = 500;
+constexpr quint32 ACK_INTERVAL = 4;
+constexpr int MAX_CHUNK_SIZE = 1024 * 1024;
+
+QVector<quint32> makeCrcTable()
+{
+    QVector<quint32> table(256);
+    for (quint32 i = 0; i < 256; ++i) {
+        quint32 value = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            value = (value & 1) ? (value >> 1) ^ 0xEDB88320u : value >> 1;
+        }
+        table[int(i)] = value;
+    }
+    return table;
+}
+}
+
+quint32 chatCrc32(const char* data, int size)
+{
+    static const QVector<quint32> table = makeCrcTable();
+
+    quint32 crc = 0xFFFFFFFFu;
+    for (int i = 0; i < size; ++i) {
+        crc = table[int((crc ^ quint8(data[i])) & 0xFF)] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+ChatFileSender::ChatFileSender(QObject* parent) :
+    QObject(parent),
+    m_retryTimer(new QTimer(this))
+{
+    m_retryTimer->setInterval(RETRY_INTERVAL);
+    connect(m_retryTimer, &QTimer::timeout, this, &ChatFileSender::onRetryTimer);
+}
+
+ChatFileSender::~ChatFileSender()
+{
+    qDeleteAll(m_transfers);
+}
+
+QString ChatFileSender::send(const QString& filePath, const QString& clientId)
+{
+    auto* transfer = new Transfer;
+    transfer->file.setFileName(filePath);
+    if (!transfer->file.open(QIODevice::ReadOnly)) {
+        delete transfer;
+        return QString();
+    }
+
+    // Empty files cannot be mapped, they consist of the offer only
+    if (transfer->file.size() > 0) {
+        transfer->data = transfer->file.map(0, transfer->file.size());
+        if (!transfer->data) {
+            delete transfer;
+            return QString();
+        }
+    }
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+    transfer->offer.transferId = QUuid::createUuid().toString(QUuid::WithoutBraces);
+    transfer->offer.fileName = QFileInfo(filePath).fileName();
+    transfer->offer.size = transfer->file.size();
+    transfer->offer.chunkSize = ChunkSize;
+    transfer->clientId = clientId;
+    transfer->lastActivity = now;
+    transfer->offerDelay = OFFER_DELAY_INITIAL;
+    transfer->nextOffer = now + transfer->offerDelay;
+
+    m_transfers.insert(transfer->offer.transferId, transfer);
+    if (!m_retryTimer->isActive()) {
+        m_retryTimer->start();
+    }
+
+    // Chunks only go out once a recipient answered with its resume point
+    emit sendOffer(clientId, transfer->offer);
+
+    return transfer->offer.transferId;
+}
+
+void ChatFileSender::acknowledge(const QString& transferId, const QString& clientId, quint32 next)
+{
+    auto* transfer = m_transfers.value(transferId);
+    if (!transfer) {
+        return;
+    }
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    const quint32 chunkCount = transfer->offer.chunkCount();
+    next = qMin(next, chunkCount);
+
+    transfer->lastActivity = now;
+    transfer->offerDelay = OFFER_DELAY_INITIAL;
+    transfer->nextOffer = now + transfer->offerDelay;
+
+    auto it = transfer->recipients.find(clientId);
+    if (it == transfer->recipients.end()) {
+        // New or resuming recipient, it needs everything from its own point
+        transfer->recipients.insert(clientId, next);
+        if (next < transfer->cursor) {
+            rewind(*transfer, next, now);
+        }
+    } else if (next > *it) {
+        *it = next;
+    } else if (next < chunkCount && next < transfer->cursor) {
+        // Unchanged ack: the chunk after it was lost or corrupted
+        if (now - transfer->lastRewind >= REWIND_INTERVAL) {
+            rewind(*transfer, next, now);
+        }
+        return;
+    } else {
+        return;
+    }
+
+    if (next == chunkCount) {
+        emit transferFinished(transfer->offer.fileName, clientId);
+
+        if (!transfer->clientId.isEmpty()) {
+            remove(transferId);
+            return;
+        }
+    }
+
+    pump(*transfer);
+}
+
+void ChatFileSender::onRetryTimer()
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+    const auto transferIds = m_transfers.keys();
+    for (const auto& transferId : transferIds) {
+        auto* transfer = m_transfers.value(transferId);
+
+        if (now - transfer->lastActivity > TRANSFER_EXPIRY) {
+            remove(transferId);
+            continue;
+        }
+
+        if (now < transfer->nextOffer) {
+            continue;
+        }
+
+        // No progress: repeat the offer, so recipients that reconnected or
+        // lost the tail of the window report where to continue
+        transfer->offerDelay = qMin(transfer->offerDelay * 2, OFFER_DELAY_MAX);
+        transfer->nextOffer = now + transfer->offerDelay;
+        emit sendOffer(transfer->clientId, transfer->offer);
+    }
+}
+
+void ChatFileSender::pump(Transfer& transfer)
+{
+    const quint32 chunkCount = transfer.offer.chunkCount();
+
+    // Nothing is sent before a recipient answered the offer
+    if (transfer.recipients.isEmpty()) {
+        return;
+    }
+
+    quint32 lowest = chunkCount;
+    for (const auto next : qAsConst(transfer.recipients)) {
+        lowest = qMin(lowest, next);
+    }
+
+    const quint32 limit = qMin(chunkCount, lowest + Window);
+    while (transfer.cursor < limit) {
+        emit sendChunk(transfer.clientId, chunk(transfer, transfer.cursor));
+        ++transfer.cursor;
+    }
+}
+
+void ChatFileSender::rewind(Transfer& transfer, quint32 index, qint64 now)
+{
+    transfer.cursor = qMin(transfer.cursor, index);
+    transfer.lastRewind = now;
+    pump(transfer);
+}
+
+ChatFileChunk ChatFileSender::chunk(Transfer& transfer, quint32 index)
+{
+    const qint64 offset = qint64(index) * transfer.offer.chunkSize;
+    const int size = int(qMin<qint64>(transfer.offer.chunkSize, transfer.offer.size - offset));
+    const char* data = reinterpret_cast<const char*>(transfer.data + offset);
+
+    ChatFileChunk result;
+    result.transferId = transfer.offer.transferId;
+    result.index = index;
+    result.data = QByteArray(data, size);
+
+    // Chunks are first sent in order, repeated ones reuse the checksum
+    if (index < quint32(transfer.checksums.size())) {
+        result.checksum = transfer.checksums[int(index)];
+    } else {
+        result.checksum = chatCrc32(data, size);
+        transfer.checksums.append(result.checksum);
+    }
+
+    return result;
+}
+
+void ChatFileSender::remove(const QString& transferId)
+{
+    delete m_transfers.take(transferId);
+
+    if (m_transfers.isEmpty()) {
+        m_retryTimer->stop();
+    }
+}
+
+ChatFileReceiver::ChatFileReceiver(QObject* parent) :
+    QObject(parent),
+    m_directory(QStandardPaths::writableLocation(QStandardPaths::DownloadLocation))
+{
+    m_directory.mkpath(QStringLiteral("."));
+}
+
+ChatFileReceiver::~ChatFileReceiver()
+{
+    // Partial files stay for the next offer
+    qDeleteAll(m_incoming);
+}
+
+void ChatFileReceiver::receiveOffer(const ChatFileOffer& offer)
+{
+    // The transfer id names the partial file, it must not be a path. The
+    // chunk count divides by the chunk size, even for a repeated offer.
+    if (QUuid(offer.transferId).isNull() || offer.size < 0 ||
+        offer.chunkSize <= 0 || offer.chunkSize > MAX_CHUNK_SIZE) {
+        return;
+    }
+
+    if (m_completed.contains(offer.transferId)) {
+        emit acknowledge(offer.transferId, offer.chunkCount());
+        return;
+    }
+
+    if (auto* incoming = m_incoming.value(offer.transferId)) {
+        emit acknowledge(offer.transferId, incoming->next);
+        return;
+    }
+
+    auto* incoming = new Incoming;
+    incoming->offer = offer;
+    incoming->offer.fileName = QFileInfo(offer.fileName).fileName();
+    incoming->file.setFileName(m_directory.filePath(QStringLiteral(".%1.part").arg(offer.transferId)));
+    if (!incoming->file.open(QIODevice::ReadWrite)) {
+        delete incoming;
+        return;
+    }
+
+    // Only whole chunks count, a chunk cut short by a crash is received again
+    incoming->next = qMin(quint32(incoming->file.size() / offer.chunkSize), offer.chunkCount());
+    incoming->file.resize(qint64(incoming->next) * offer.chunkSize);
+    incoming->file.seek(incoming->file.size());
+
+    m_incoming.insert(offer.transferId, incoming);
+
+    if (incoming->next == offer.chunkCount()) {
+        complete(incoming);
+    } else {
+        emit acknowledge(offer.transferId, incoming->next);
+    }
+}
+
+void ChatFileReceiver::receiveChunk(const ChatFileChunk& chunk)
+{
+    auto* incoming = m_incoming.value(chunk.transferId);
+    if (!incoming) {
+        return;
+    }
+
+    const auto& offer = incoming->offer;
+    const qint64 offset = qint64(chunk.index) * offer.chunkSize;
+    const qint64 expectedSize = qMin<qint64>(offer.chunkSize, offer.size - offset);
+
+    // Everything after a lost chunk is dropped and the gap reported, the
+    // sender goes back to it
+    if (chunk.index != incoming->next || chunk.data.size() != expectedSize) {
+        if (chunk.index > incoming->next) {
+            emit acknowledge(chunk.transferId, incoming->next);
+        }
+        return;
+    }
+
+    if (incoming->file.write(chunk.data) != chunk.data.size()) {
+        return;
+    }
+    ++incoming->next;
+
+    if (incoming->next == offer.chunkCount()) {
+        complete(incoming);
+    } else if (incoming->next % ACK_INTERVAL == 0) {
+        emit acknowledge(chunk.transferId, incoming->next);
+    }
+}
+
+void ChatFileReceiver::complete(Incoming* incoming)
+{
+    const auto offer = incoming->offer;
+    m_incoming.remove(offer.transferId);
+
+    incoming->file.close();
+
+    const QFileInfo fileInfo(offer.fileName.isEmpty() ? offer.transferId : offer.fileName);
+    QString filePath = m_directory.filePath(fileInfo.fileName());
+    for (int i = 1; QFile::exists(filePath); ++i) {
+        const QString suffix = fileInfo.completeSuffix().isEmpty() ? QString()
+                                                                  : QLatin1Char('.') + fileInfo.completeSuffix();
+        filePath = m_directory.filePath(QStringLiteral("%1 (%2)%3").arg(fileInfo.baseName()).arg(i).arg(suffix));
+    }
+
+    const bool renamed = incoming->file.rename(filePath);
+    delete incoming;
+
+    m_completed.insert(offer.transferId);
+    emit acknowledge(offer.transferId, offer.chunkCount());
+
+    if (renamed) {
+        emit fileReceived(offer.fileName, filePath);
+    }
+}
@@ -0,0 +1,149 @@
+/*
+ * ChatFileTransfer.h - declaration of ChatFileSender and ChatFileReceiver classes
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#pragma once
+
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QVector>
+
+class QTimer;
+
+quint32 chatCrc32(const char* data, int size);
+
+// Announces a file, sent again until the recipients answer. A client
+// answers with the index of the first chunk it is missing, which is how
+// transfers resume after a reconnect.
+struct ChatFileOffer
+{
+    QString transferId;
+    QString fileName;
+    qint64 size = 0;
+    int chunkSize = 0;
+
+    quint32 chunkCount() const { return size > 0 ? quint32((size + chunkSize - 1) / chunkSize) : 0; }
+};
+
+struct ChatFileChunk
+{
+    QString transferId;
+    quint32 index = 0;
+    quint32 checksum = 0;
+    QByteArray data;
+
+    bool isValid() const { return chatCrc32(data.constData(), data.size()) == checksum; }
+};
+
+// Master side. Files are memory mapped and sent as fixed-size chunks with a
+// window of unacknowledged chunks per transfer. A transfer to the whole
+// class shares one send cursor, so each chunk is read and checksummed once
+// and the same message goes out to every recipient; a recipient reporting
+// a lost chunk rewinds the cursor (go-back-N) and the others drop the
+// repeated chunks.
+class ChatFileSender : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int ChunkSize = 32 * 1024;
+    static constexpr quint32 Window = 16;
+
+    explicit ChatFileSender(QObject* parent = nullptr);
+    ~ChatFileSender() override;
+
+    // An empty client id sends the file to the whole class. Returns the
+    // transfer id, or an empty string when the file cannot be read.
+    QString send(const QString& filePath, const QString& clientId);
+    void acknowledge(const QString& transferId, const QString& clientId, quint32 next);
+
+signals:
+    void sendOffer(const QString& clientId, const ChatFileOffer& offer);
+    void sendChunk(const QString& clientId, const ChatFileChunk& chunk);
+    void transferFinished(const QString& fileName, const QString& clientId);
+
+private slots:
+    void onRetryTimer();
+
+private:
+    struct Transfer
+    {
+        ChatFileOffer offer;
+        QString clientId;
+        QFile file;
+        const uchar* data = nullptr;
+        QVector<quint32> checksums;
+        // Next chunk expected by each recipient that answered
+        QHash<QString, quint32> recipients;
+        quint32 cursor = 0;
+        qint64 lastActivity = 0;
+        qint64 lastRewind = 0;
+        qint64 nextOffer = 0;
+        int offerDelay = 0;
+    };
+
+    void pump(Transfer& transfer);
+    void rewind(Transfer& transfer, quint32 index, qint64 now);
+    ChatFileChunk chunk(Transfer& transfer, quint32 index);
+    void remove(const QString& transferId);
+
+    QHash<QString, Transfer*> m_transfers;
+    QTimer* m_retryTimer;
+};
+
+// Client side. Chunks are appended to a partial file in the download
+// location, named after the transfer, so an offer repeated after a worker
+// restart continues where the file ends. Checksums are verified by the
+// caller, off the GUI thread.
+class ChatFileReceiver : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ChatFileReceiver(QObject* parent = nullptr);
+    ~ChatFileReceiver() override;
+
+    void receiveOffer(const ChatFileOffer& offer);
+    void receiveChunk(const ChatFileChunk& chunk);
+
+signals:
+    void acknowledge(const QString& transferId, quint32 next);
+    void fileReceived(const QString& fileName, const QString& filePath);
+
+private:
+    struct Incoming
+    {
+        ChatFileOffer offer;
+        QFile file;
+        quint32 next = 0;
+    };
+
+    void complete(Incoming* incoming);
+
+    QDir m_directory;
+    QHash<QString, Incoming*> m_incoming;
+    QSet<QString> m_completed;
+};
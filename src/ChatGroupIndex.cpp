@@ -0,0 +1,201 @@
+/*
+ * ChatGroupIndex.cpp - implementation of ChatGroupIndex class
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include "ChatGroupIndex.h"
+
+#include <algorithm>
+
+void ChatHandleSet::insert(int handle)
+{
+    if (handle < 0) {
+        return;
+    }
+
+    const int word = handle / 64;
+    if (word >= m_words.size()) {
+        m_words.resize(word + 1);
+    }
+    m_words[word] |= quint64(1) << (handle % 64);
+}
+
+void ChatHandleSet::remove(int handle)
+{
+    const int word = handle / 64;
+    if (handle >= 0 && word < m_words.size()) {
+        m_words[word] &= ~(quint64(1) << (handle % 64));
+    }
+}
+
+bool ChatHandleSet::contains(int handle) const
+{
+    const int word = handle / 64;
+    return handle >= 0 && word < m_words.size() && (m_words[word] & (quint64(1) << (handle % 64)));
+}
+
+int ChatHandleSet::count() const
+{
+    int result = 0;
+    for (const auto word : m_words) {
+        result += int(qPopulationCount(word));
+    }
+    return result;
+}
+
+ChatHandleSet ChatHandleSet::operator&(const ChatHandleSet& other) const
+{
+    ChatHandleSet result;
+    const int size = qMin(m_words.size(), other.m_words.size());
+    result.m_words.resize(size);
+    for (int i = 0; i < size; ++i) {
+        result.m_words[i] = m_words[i] & other.m_words[i];
+    }
+    return result;
+}
+
+void ChatGroupIndex::registerSession(int handle, const QString& clientId)
+{
+    if (handle < 0) {
+        return;
+    }
+
+    if (handle >= m_clientIds.size()) {
+        m_clientIds.resize(handle + 1);
+    }
+    m_clientIds[handle] = clientId;
+    m_online.insert(handle);
+}
+
+void ChatGroupIndex::unregisterSession(int handle)
+{
+    if (handle < 0 || handle >= m_clientIds.size()) {
+        return;
+    }
+
+    m_clientIds[handle].clear();
+    m_online.remove(handle);
+    for (auto& group : m_groups) {
+        group.members.remove(handle);
+    }
+}
+
+void ChatGroupIndex::setOnline(int handle, bool online)
+{
+    if (online) {
+        m_online.insert(handle);
+    } else {
+        m_online.remove(handle);
+    }
+}
+
+bool ChatGroupIndex::addGroup(const QString& name)
+{
+    if (name.isEmpty() || m_groups.contains(name)) {
+        return false;
+    }
+
+    m_groups.insert(name, Group());
+    return true;
+}
+
+void ChatGroupIndex::removeGroup(const QString& name)
+{
+    m_groups.remove(name);
+}
+
+void ChatGroupIndex::addMember(const QString& name, int handle)
+{
+    auto it = m_groups.find(name);
+    if (it != m_groups.end()) {
+        it->members.insert(handle);
+    }
+}
+
+void ChatGroupIndex::removeMember(const QString& name, int handle)
+{
+    auto it = m_groups.find(name);
+    if (it != m_groups.end()) {
+        it->members.remove(handle);
+    }
+}
+
+bool ChatGroupIndex::isMember(const QString& name, int handle) const
+{
+    const auto it = m_groups.constFind(name);
+    return it != m_groups.constEnd() && it->members.contains(handle);
+}
+
+QStringList ChatGroupIndex::members(const QString& name) const
+{
+    const auto it = m_groups.constFind(name);
+    return it != m_groups.constEnd() ? clientIds(it->members) : QStringList();
+}
+
+QStringList ChatGroupIndex::resolve(const QString& name) const
+{
+    const auto it = m_groups.constFind(name);
+    return it != m_groups.constEnd() ? clientIds(it->members & m_online) : QStringList();
+}
+
+void ChatGroupIndex::addToHistory(const QString& name, const ChatMessage& message)
+{
+    auto it = m_groups.find(name);
+    if (it != m_groups.end()) {
+        it->history.append(message);
+    }
+}
+
+QList<ChatMessage> ChatGroupIndex::history(const QString& name) const
+{
+    return m_groups.value(name).history;
+}
+
+bool ChatGroupIndex::removeExpired(const QString& name, const QDateTime& now)
+{
+    auto it = m_groups.find(name);
+    if (it == m_groups.end()) {
+        return false;
+    }
+
+    const auto end = std::remove_if(it->history.begin(), it->history.end(), [&now](const ChatMessage& message) {
+        return message.expiresAt().isValid() && message.expiresAt() <= now;
+    });
+    if (end == it->history.end()) {
+        return false;
+    }
+
+    it->history.erase(end, it->history.end());
+    return true;
+}
+
+QStringList ChatGroupIndex::clientIds(const ChatHandleSet& handles) const
+{
+    QStringList result;
+    result.reserve(handles.count());
+    handles.forEach([this, &result](int handle) {
+        if (handle < m_clientIds.size() && !m_clientIds[handle].isEmpty()) {
+            result.append(m_clientIds[handle]);
+        }
+    });
+    return result;
+}
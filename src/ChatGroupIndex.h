@@ -0,0 +1,106 @@
+/*
+ * ChatGroupIndex.h - declaration of ChatGroupIndex class
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#pragma once
+
+#include <QList>
+#include <QMap>
+#include <QStringList>
+#include <QVector>
+#include <QtAlgorithms>
+
+#include "ChatMessage.h"
+
+// Set of session handles as a bitset. Handles are dense, so 1000 sessions
+// fit into 16 words and set operations touch nothing else.
+class ChatHandleSet
+{
+public:
+    void insert(int handle);
+    void remove(int handle);
+    bool contains(int handle) const;
+    int count() const;
+
+    ChatHandleSet operator&(const ChatHandleSet& other) const;
+
+    template<typename Function>
+    void forEach(Function function) const
+    {
+        for (int i = 0; i < m_words.size(); ++i) {
+            quint64 word = m_words[i];
+            while (word) {
+                function(i * 64 + int(qCountTrailingZeroBits(word)));
+                word &= word - 1;
+            }
+        }
+    }
+
+private:
+    QVector<quint64> m_words;
+};
+
+// Named groups of students, e.g. the tables of a classroom. Membership is a
+// handle set per group; sending to a group intersects it with the set of
+// reachable sessions. Messages sent to a group are kept once, in the
+// group's own history.
+class ChatGroupIndex
+{
+public:
+    // Sessions and their reachability
+    void registerSession(int handle, const QString& clientId);
+    void unregisterSession(int handle);
+    void setOnline(int handle, bool online);
+
+    // Groups
+    bool addGroup(const QString& name);
+    void removeGroup(const QString& name);
+    bool contains(const QString& name) const { return m_groups.contains(name); }
+    QStringList groupNames() const { return m_groups.keys(); }
+    void addMember(const QString& name, int handle);
+    void removeMember(const QString& name, int handle);
+    bool isMember(const QString& name, int handle) const;
+    QStringList members(const QString& name) const;
+
+    // Client ids of the members which are currently reachable
+    QStringList resolve(const QString& name) const;
+
+    void addToHistory(const QString& name, const ChatMessage& message);
+    QList<ChatMessage> history(const QString& name) const;
+    // Drops messages of the group's history which expired by now, returns
+    // whether there were any
+    bool removeExpired(const QString& name, const QDateTime& now);
+
+private:
+    struct Group
+    {
+        ChatHandleSet members;
+        QList<ChatMessage> history;
+    };
+
+    QStringList clientIds(const ChatHandleSet& handles) const;
+
+    QMap<QString, Group> m_groups;
+    QVector<QString> m_clientIds;
+    ChatHandleSet m_online;
+};
@@ -0,0 +1,121 @@
+/*
+ * ChatHistoryCompactor.cpp - implementation of ChatHistoryCompactor class
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include "ChatHistoryCompactor.h"
+#include <QSet>
+#include <QSettings>
+#include <QTimer>
+
+namespace {
+constexpr auto ORGANIZATION_NAME = "Veyon";
+constexpr auto SETTINGS_NORMAL = "messageTtl/normal";
+constexpr auto SETTINGS_URGENT = "messageTtl/urgent";
+constexpr auto SETTINGS_ANNOUNCEMENT = "messageTtl/announcement";
+}
+
+QDateTime ChatRetentionPolicy::expiry(const ChatMessage& message) const
+{
+    if (message.expiresAt().isValid()) {
+        return message.expiresAt();
+    }
+
+    int timeToLive = normal;
+    switch (message.priority()) {
+    case ChatMessage::Priority::Urgent:
+        timeToLive = urgent;
+        break;
+    case ChatMessage::Priority::Announcement:
+        timeToLive = announcement;
+        break;
+    default:
+        break;
+    }
+
+    return timeToLive > 0 ? message.timestamp().addSecs(timeToLive) : QDateTime();
+}
+
+ChatRetentionPolicy ChatRetentionPolicy::load(const char* applicationName)
+{
+    const QSettings settings(ORGANIZATION_NAME, applicationName);
+
+    ChatRetentionPolicy result;
+    result.normal = qMax(0, settings.value(SETTINGS_NORMAL, 0).toInt());
+    result.urgent = qMax(0, settings.value(SETTINGS_URGENT, 0).toInt());
+    result.announcement = qMax(0, settings.value(SETTINGS_ANNOUNCEMENT, 0).toInt());
+    return result;
+}
+
+ChatHistoryCompactor::ChatHistoryCompactor(QObject* parent) :
+    QObject(parent),
+    m_timer(new QTimer(this))
+{
+    m_timer->setSingleShot(true);
+    connect(m_timer, &QTimer::timeout, this, &ChatHistoryCompactor::onTimeout);
+}
+
+void ChatHistoryCompactor::track(const QString& key, const QDateTime& expiry)
+{
+    if (!expiry.isValid()) {
+        return;
+    }
+
+    const qint64 due = expiry.toMSecsSinceEpoch();
+    const bool earliest = m_heap.isEmpty() || due < m_heap.top().due;
+
+    m_heap.push(key, due);
+
+    if (earliest) {
+        m_heap.arm(m_timer);
+    }
+}
+
+void ChatHistoryCompactor::clear()
+{
+    m_heap.clear();
+    m_timer->stop();
+}
+
+void ChatHistoryCompactor::onTimeout()
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+    // Histories with several expired messages are compacted once; the bound
+    // counts entries so a history with many of them cannot stall a tick
+    QStringList keys;
+    QSet<QString> seen;
+    for (int popped = 0; popped < EntriesPerTick && !m_heap.isEmpty() && m_heap.top().due <= now; ++popped) {
+        const QString key = m_heap.pop().key;
+
+        if (!seen.contains(key)) {
+            seen.insert(key);
+            keys.append(key);
+        }
+    }
+
+    if (!keys.isEmpty()) {
+        emit compact(keys);
+    }
+
+    m_heap.arm(m_timer);
+}
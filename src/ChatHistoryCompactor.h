@@ -0,0 +1,75 @@
+/*
+ * ChatHistoryCompactor.h - declaration of ChatHistoryCompactor class
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#pragma once
+
+#include <QDateTime>
+#include <QObject>
+#include <QStringList>
+
+#include "ChatDueHeap.h"
+#include "ChatMessage.h"
+
+class QTimer;
+
+// Time to live per priority, in seconds; 0 keeps messages. A message's own
+// expiry, set by its sender, takes precedence.
+struct ChatRetentionPolicy
+{
+    int normal = 0;
+    int urgent = 0;
+    int announcement = 0;
+
+    QDateTime expiry(const ChatMessage& message) const;
+
+    // Reads the messageTtl group of the given Veyon chat settings application
+    static ChatRetentionPolicy load(const char* applicationName);
+};
+
+// Removes expired messages in the background. Expiry times are kept in a
+// due-time heap driven by one timer; when it fires, at most EntriesPerTick
+// expiries are taken off and the rest follows on the next event loop
+// iteration, so a burst of expiring messages never blocks the GUI.
+class ChatHistoryCompactor : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int EntriesPerTick = 16;
+
+    explicit ChatHistoryCompactor(QObject* parent = nullptr);
+
+    void track(const QString& key, const QDateTime& expiry);
+    void clear();
+
+signals:
+    void compact(const QStringList& keys);
+
+private slots:
+    void onTimeout();
+
+private:
+    QTimer* m_timer;
+    ChatDueHeap m_heap;
+};
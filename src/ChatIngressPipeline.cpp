@@ -0,0 +1,161 @@
+/*
+ * ChatIngressPipeline.cpp - implementation of ChatIngressPipeline class
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include "ChatIngressPipeline.h"
+#include "ChatMetrics.h"
+#include <QMutexLocker>
+#include <QThread>
+#include <QTimer>
+
+namespace {
+// Decoded messages reach the GUI thread at most once per frame
+constexpr int DRAIN_INTERVAL = 16;
+}
+
+ChatIngressPipeline::ChatIngressPipeline(const QString& name, QObject* parent) :
+    QObject(parent),
+    m_thread(new QThread(this)),
+    m_decoderContext(new QObject()),
+    m_drainTimer(new QTimer(this)),
+    m_decodePending(false),
+    m_drainPending(false),
+    m_inputDepth(ChatMetrics::instance().gauge(
+        QStringLiteral("chat_ingress_input_depth"), QStringLiteral("Feature messages waiting for the decoder thread"),
+        QStringLiteral("pipeline=\"%1\"").arg(name))),
+    m_outputDepth(ChatMetrics::instance().gauge(
+        QStringLiteral("chat_ingress_output_depth"), QStringLiteral("Decoded actions waiting for the GUI thread"),
+        QStringLiteral("pipeline=\"%1\"").arg(name))),
+    m_decodeTime(ChatMetrics::instance().histogram(
+        QStringLiteral("chat_decode_seconds"), QStringLiteral("Time to decode and validate one incoming feature message"),
+        QStringLiteral("pipeline=\"%1\"").arg(name))),
+    m_drainTime(ChatMetrics::instance().histogram(
+        QStringLiteral("chat_ingress_drain_seconds"), QStringLiteral("GUI thread time spent applying decoded messages per frame"),
+        QStringLiteral("pipeline=\"%1\"").arg(name)))
+{
+    m_drainTimer->setSingleShot(true);
+    m_drainTimer->setInterval(DRAIN_INTERVAL);
+    connect(m_drainTimer, &QTimer::timeout, this, &ChatIngressPipeline::drain);
+
+    m_decoderContext->moveToThread(m_thread);
+    connect(m_thread, &QThread::finished, m_decoderContext, &QObject::deleteLater);
+    m_thread->setObjectName(name);
+}
+
+ChatIngressPipeline::~ChatIngressPipeline()
+{
+    m_thread->quit();
+    m_thread->wait();
+
+    // The thread may never have been started
+    if (!m_thread->isFinished()) {
+        delete m_decoderContext;
+    }
+}
+
+void ChatIngressPipeline::submit(const FeatureMessage& message)
+{
+    // Plugins are loaded in every Veyon process, most never need the thread
+    std::call_once(m_started, [this]() { m_thread->start(); });
+
+    {
+        QMutexLocker locker(&m_inputMutex);
+        m_input.append(message);
+    }
+    m_inputDepth.add(1);
+
+    // Only the first message after a decode run wakes the decoder thread
+    if (!m_decodePending.exchange(true)) {
+        QMetaObject::invokeMethod(m_decoderContext, [this]() { decode(); }, Qt::QueuedConnection);
+    }
+}
+
+void ChatIngressPipeline::post(Action&& action)
+{
+    m_decoded.append(std::move(action));
+}
+
+bool ChatIngressPipeline::acceptMessage(const ChatMessage& message)
+{
+    if (message.messageId().isEmpty() || message.senderId().isEmpty()) {
+        return false;
+    }
+    return m_seenMessages.insert(message.messageId());
+}
+
+void ChatIngressPipeline::decode()
+{
+    m_decodePending.store(false);
+
+    QVector<FeatureMessage> input;
+    {
+        QMutexLocker locker(&m_inputMutex);
+        input.swap(m_input);
+    }
+    m_inputDepth.add(-input.size());
+
+    for (const auto& message : qAsConst(input)) {
+        const ChatMetricsTimer timer(m_decodeTime);
+        m_decoder(message);
+    }
+
+    if (m_decoded.isEmpty()) {
+        return;
+    }
+
+    m_outputDepth.add(m_decoded.size());
+    {
+        QMutexLocker locker(&m_outputMutex);
+        if (m_output.isEmpty()) {
+            m_output.swap(m_decoded);
+        } else {
+            m_output.append(m_decoded);
+            m_decoded.clear();
+        }
+    }
+
+    if (!m_drainPending.exchange(true)) {
+        QMetaObject::invokeMethod(this, [this]() {
+            if (!m_drainTimer->isActive()) {
+                m_drainTimer->start();
+            }
+        }, Qt::QueuedConnection);
+    }
+}
+
+void ChatIngressPipeline::drain()
+{
+    m_drainPending.store(false);
+    const ChatMetricsTimer timer(m_drainTime);
+
+    QVector<Action> actions;
+    {
+        QMutexLocker locker(&m_outputMutex);
+        actions.swap(m_output);
+    }
+    m_outputDepth.add(-actions.size());
+
+    for (const auto& action : qAsConst(actions)) {
+        action();
+    }
+}
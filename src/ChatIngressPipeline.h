@@ -0,0 +1,99 @@
+/*
+ * ChatIngressPipeline.h - declaration of ChatIngressPipeline class
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#pragma once
+
+#include <QMutex>
+#include <QObject>
+#include <QVector>
+#include <atomic>
+#include <functional>
+#include <mutex>
+
+#include "ChatMessage.h"
+#include "ChatMessageDedup.h"
+#include "FeatureMessage.h"
+
+class ChatGauge;
+class ChatHistogram;
+class QThread;
+class QTimer;
+
+// Moves the handling of incoming feature messages off the GUI thread.
+// Messages may be submitted from any thread; a decoder thread parses,
+// validates and deduplicates them and turns each into an action, and the
+// GUI thread runs the collected actions at most once per frame from a
+// single queued invocation.
+class ChatIngressPipeline : public QObject
+{
+    Q_OBJECT
+
+public:
+    using Action = std::function<void()>;
+    using Decoder = std::function<void(const FeatureMessage&)>;
+
+    explicit ChatIngressPipeline(const QString& name, QObject* parent = nullptr);
+    ~ChatIngressPipeline() override;
+
+    // Runs on the decoder thread, must be set before the first submit()
+    void setDecoder(const Decoder& decoder) { m_decoder = decoder; }
+
+    // Thread-safe
+    void submit(const FeatureMessage& message);
+
+    // Decoder thread only: queue an action for the GUI thread, and drop
+    // malformed or already seen chat messages
+    void post(Action&& action);
+    bool acceptMessage(const ChatMessage& message);
+
+private slots:
+    void drain();
+
+private:
+    void decode();
+
+    QThread* m_thread;
+    QObject* m_decoderContext;
+    QTimer* m_drainTimer;
+    std::once_flag m_started;
+    Decoder m_decoder;
+
+    QMutex m_inputMutex;
+    QVector<FeatureMessage> m_input;
+    std::atomic<bool> m_decodePending;
+
+    // Decoder thread state
+    QVector<Action> m_decoded;
+    ChatMessageDedup m_seenMessages;
+
+    QMutex m_outputMutex;
+    QVector<Action> m_output;
+    std::atomic<bool> m_drainPending;
+
+    // Metrics, labelled with the pipeline name
+    ChatGauge& m_inputDepth;
+    ChatGauge& m_outputDepth;
+    ChatHistogram& m_decodeTime;
+    ChatHistogram& m_drainTime;
+};
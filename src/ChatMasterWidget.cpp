@@ -1,22 +1,36 @@
 #include "ChatMasterWidget.h"
+#include "ChatAnnouncementDialog.h"
+#include "ChatAnnouncementScheduler.h"
+#include "ChatClientListModel.h"
+#include "ChatMetrics.h"
+#include "ChatNotificationAggregator.h"
+#include "ChatTimerWheel.h"
+#include "ChatTriageProxyModel.h"
 
 #include <QApplication>
 #include <QAbstractItemView>
 #include <QAction>
+#include <QCheckBox>
 #include <QtCore/qobjectdefs.h>
 #include <QComboBox>
 #include <QDateTime>
+#include <QDir>
+#include <QFileDialog>
 #include <QHBoxLayout>
 #include <QIcon>
+#include <QInputDialog>
+#include <QItemSelectionModel>
 #include <QLabel>
 #include <QLineEdit>
-#include <QListWidget>
+#include <QListView>
 #include <QMenu>
 #include <QMessageBox>
 #include <QPushButton>
 #include <QSettings>
 #include <QShortcut>
+#include <QSortFilterProxyModel>
 #include <QSplitter>
+#include <QStandardPaths>
 #include <QSystemTrayIcon>
 #include <QTextCursor>
 #include <QTextEdit>
@@ -24,12 +38,33 @@
 #include <QUrl>
 #include <QVBoxLayout>
 
+#include <limits>
+
 namespace {
 constexpr auto ORGANIZATION_NAME = "Veyon";
 constexpr auto APPLICATION_NAME = "ChatMaster";
 constexpr auto SETTINGS_GEOMETRY = "geometry";
 constexpr auto SETTINGS_SOUND = "soundEnabled";
+constexpr auto SETTINGS_TRIAGE = "triageMode";
+constexpr auto SETTINGS_GROUPS = "groups";
+constexpr auto GROUP_RECEIVER_PREFIX = "group:";
 constexpr auto MASTER_ID = "master";
+constexpr int SEEN_MESSAGES_CAPACITY = 16384;
+
+ChatGauge& sessionCount()
+{
+    static auto& gauge = ChatMetrics::instance().gauge(
+        QStringLiteral("chat_sessions"), QStringLiteral("Client sessions known to the master"));
+    return gauge;
+}
+
+ChatHistogram& refreshTime()
+{
+    static auto& histogram = ChatMetrics::instance().histogram(
+        QStringLiteral("chat_ui_refresh_seconds"), QStringLiteral("Time to rebuild or extend a chat display"),
+        QStringLiteral("view=\"master\""));
+    return histogram;
+}
 
 ChatMessage::Priority priorityFromIndex(int index)
 {
@@ -46,54 +81,81 @@ ChatMasterWidget::ChatMasterWidget(QWidget* parent) :
     QWidget(parent),
     m_splitter(nullptr),
     m_clientList(nullptr),
+    m_triageCheck(nullptr),
+    m_clientModel(new ChatClientListModel(m_sessions, this)),
+    m_sortedClientModel(new QSortFilterProxyModel(this)),
+    m_triageClientModel(new ChatTriageProxyModel(this)),
     m_chatDisplay(nullptr),
     m_messageInput(nullptr),
     m_sendButton(nullptr),
     m_clearButton(nullptr),
     m_globalButton(nullptr),
+    m_fileButton(nullptr),
+    m_groupButton(nullptr),
+    m_groupMenu(nullptr),
+    m_scheduleButton(nullptr),
+    m_requestsButton(nullptr),
     m_priorityCombo(nullptr),
+    m_ttlCombo(nullptr),
     m_quickReplies(nullptr),
     m_statusLabel(nullptr),
     m_trayIcon(nullptr),
     m_f10Shortcut(nullptr),
     m_sendShortcut(nullptr),
     m_typingTimer(new QTimer(this)),
+    m_typingLeases(new ChatTimerWheel(250, 64, 1, this)),
+    m_presence(new ChatPresenceTracker(this)),
     m_notificationSound(new QSoundEffect(this)),
-    m_soundEnabled(true)
+    m_notifications(new ChatNotificationAggregator(this)),
+    m_announcements(nullptr),
+    m_compactor(new ChatHistoryCompactor(this)),
+    m_nextSessionHandle(0),
+    m_soundEnabled(true),
+    m_triageMode(false),
+    m_seenMessages(SEEN_MESSAGES_CAPACITY)
 {
     setObjectName(QStringLiteral("ChatMasterWidget"));
     setupUI();
     setupTrayIcon();
     setupShortcuts();
     setupQuickReplies();
+    setupSound();
     loadSettings();
 
     m_typingTimer->setInterval(2000);
     m_typingTimer->setSingleShot(true);
     connect(m_typingTimer, &QTimer::timeout, this, &ChatMasterWidget::onTypingTimer);
+    connect(m_typingLeases, &ChatTimerWheel::expired, this, &ChatMasterWidget::onTypingLeasesExpired);
+    connect(m_presence, &ChatPresenceTracker::statusesChanged, this, &ChatMasterWidget::onPresenceChanged);
 
     connect(m_sendButton, &QPushButton::clicked, this, &ChatMasterWidget::onSendButtonClicked);
     connect(m_clearButton, &QPushButton::clicked, this, &ChatMasterWidget::onClearChatClicked);
     connect(m_globalButton, &QPushButton::clicked, this, &ChatMasterWidget::onGlobalBroadcastClicked);
+    connect(m_requestsButton, &QPushButton::clicked, this, &ChatMasterWidget::onNextRequestClicked);
 
     connect(m_messageInput, &QLineEdit::textChanged, this, &ChatMasterWidget::onMessageInputChanged);
 
-    connect(m_clientList, &QListWidget::currentRowChanged, this, [this](int) {
-        onClientSelectionChanged();
-    });
+    connect(m_triageCheck, &QCheckBox::toggled, this, &ChatMasterWidget::onTriageModeToggled);
+    onTriageModeToggled(m_triageMode);
 
     if (m_trayIcon) {
         connect(m_trayIcon, &QSystemTrayIcon::activated,
                 this, &ChatMasterWidget::onTrayIconActivated);
     }
 
-    connect(m_notificationSound, &QSoundEffect::statusChanged, this, [this]() {
-        const auto status = m_notificationSound->status();
+    connect(m_notifications, &ChatNotificationAggregator::digestReady,
+            this, &ChatMasterWidget::onNotificationDigest);
 
-        if (status == QSoundEffect::Ready || status == QSoundEffect::Null) {
-            playNotificationSound();
-        }
-    });
+    QDir dataDirectory(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation));
+    dataDirectory.mkpath(QStringLiteral("."));
+    m_announcements = new ChatAnnouncementScheduler(dataDirectory.filePath(QStringLiteral("chat-announcements.json")), this);
+    connect(m_scheduleButton, &QPushButton::clicked, this, &ChatMasterWidget::onScheduleClicked);
+    connect(m_announcements, &ChatAnnouncementScheduler::announcementDue,
+            this, [this](const QString& content, ChatMessage::Priority priority) {
+                broadcastMessage(content, priority);
+            });
+
+    connect(m_compactor, &ChatHistoryCompactor::compact, this, &ChatMasterWidget::onCompact);
 
     setWindowTitle(tr("Veyon Chat - Master"));
     resize(900, 600);
@@ -106,35 +168,52 @@ ChatMasterWidget::~ChatMasterWidget()
 
 void ChatMasterWidget::addClient(const QString& clientId, const QString& clientName)
 {
-    if (!m_sessions.contains(clientId)) {
-        m_sessions.insert(clientId, ChatSession(clientId));
-    }
-
-    ChatSession& session = m_sessions[clientId];
+    ChatSession& session = ensureSession(clientId);
     session.setClientName(clientName);
-    updateClientList();
+    refreshClient(clientId);
 }
 
 void ChatMasterWidget::removeClient(const QString& clientId)
 {
+    // The model still needs the session to resolve its handle while the row goes away
+    m_clientModel->removeSession(clientId);
+    m_groups.unregisterSession(m_sessions.value(clientId).handle());
     m_sessions.remove(clientId);
+    sessionCount().set(m_sessions.size());
+    resolveChatRequest(clientId);
+    m_typingLeases->cancel(clientId);
+    m_presence->forget(clientId);
+    forgetSequences(clientId, std::numeric_limits<quint32>::max());
 
     if (m_currentClientId == clientId) {
         m_currentClientId.clear();
         m_chatDisplay->clear();
     }
 
-    updateClientList();
+    updateStatusLabel();
 }
 
-void ChatMasterWidget::updateClientStatus(const QString& clientId, ChatSession::ClientStatus status)
+void ChatMasterWidget::updateClientStatus(const QString& clientId, ChatSession::ClientStatus status, int lease)
 {
-    if (!m_sessions.contains(clientId)) {
-        m_sessions.insert(clientId, ChatSession(clientId));
+    m_presence->touch(clientId);
+
+    if (status == ChatSession::ClientStatus::Typing) {
+        // Clients without lease support still send an explicit stop
+        if (lease > 0) {
+            m_typingLeases->schedule(clientId, lease);
+        }
+    } else {
+        m_typingLeases->cancel(clientId);
+    }
+
+    ChatSession& session = ensureSession(clientId);
+    m_groups.setOnline(session.handle(), status != ChatSession::ClientStatus::Offline);
+    if (session.status() == status) {
+        return;
     }
 
-    m_sessions[clientId].setStatus(status);
-    updateClientList();
+    session.setStatus(status);
+    refreshClient(clientId);
 }
 
 void ChatMasterWidget::focusClient(const QString& clientId)
@@ -143,36 +222,70 @@ void ChatMasterWidget::focusClient(const QString& clientId)
         return;
     }
 
-    if (!m_sessions.contains(clientId)) {
-        ChatSession session(clientId);
-        session.setClientName(clientId);
-        m_sessions.insert(clientId, session);
+    QString targetId = clientId;
+    for (auto it = m_sessions.constBegin(); it != m_sessions.constEnd(); ++it) {
+        if (it.key().compare(clientId, Qt::CaseInsensitive) == 0) {
+            targetId = it.key();
+            break;
+        }
     }
 
-    m_currentClientId = clientId;
-    updateClientList();
+    ensureSession(targetId);
 
-    for (int i = 0; i < m_clientList->count(); ++i) {
-        if (QListWidgetItem* item = m_clientList->item(i)) {
-            if (item->data(Qt::UserRole).toString().compare(clientId, Qt::CaseInsensitive) == 0) {
-                m_clientList->setCurrentItem(item);
-                break;
-            }
-        }
+    m_currentClientId = targetId;
+    selectClient(targetId);
+    updateStatusLabel();
+    updateChatDisplay();
+}
+
+void ChatMasterWidget::touchClient(const QString& clientId)
+{
+    if (!clientId.isEmpty()) {
+        m_presence->touch(clientId);
     }
+}
 
-    updateChatDisplay();
+void ChatMasterWidget::addChatRequest(const QString& clientId)
+{
+    if (clientId.isEmpty() || m_chatRequests.contains(clientId)) {
+        return;
+    }
+
+    // Requests are queued for the teacher instead of switching the selected client
+    ChatSession& session = ensureSession(clientId);
+    m_chatRequests.append(clientId);
+    updateRequestsButton();
+
+    m_notifications->notify(session.clientName(), ChatMessage::Priority::Normal);
 }
 
 void ChatMasterWidget::receiveMessage(const ChatMessage& message)
 {
+    // Retries have been dropped by the ingress pipeline. A student sends to
+    // every master though, so the copy may already have been merged from
+    // another one, or be merged later.
+    if (!m_seenMessages.insert(message.messageId())) {
+        return;
+    }
+
     const QString clientId = message.senderId();
-    if (!m_sessions.contains(clientId)) {
-        m_sessions.insert(clientId, ChatSession(clientId));
+    ChatSession& session = ensureSession(clientId);
+    ChatMessage retained(message);
+    retain(clientId, retained);
+    session.addMessage(retained);
+    m_presence->touch(clientId);
+    emit messageRecorded(clientId, message);
+
+    const auto gap = session.receivedSequences().receive(message.sequence());
+    if (!gap.isEmpty()) {
+        emit resyncRequested(clientId, gap.first, gap.last);
     }
 
-    ChatSession& session = m_sessions[clientId];
-    session.addMessage(message);
+    // A message ends the sender's typing lease without a separate status update
+    if (session.status() == ChatSession::ClientStatus::Typing) {
+        m_typingLeases->cancel(clientId);
+        session.setStatus(ChatSession::ClientStatus::Online);
+    }
 
     if (m_currentClientId.isEmpty()) {
         m_currentClientId = clientId;
@@ -180,41 +293,139 @@ void ChatMasterWidget::receiveMessage(const ChatMessage& message)
 
     if (m_currentClientId == clientId) {
         addMessageToDisplay(message);
-        session.markAllAsRead();
+        markSessionRead(session);
     }
 
-    if (m_trayIcon && !isActiveWindow()) {
-        m_trayIcon->showMessage(tr("New message"),
-                                tr("Message from %1").arg(session.clientName()),
-                                QIcon(QStringLiteral(":/chat/icons/chat.png")));
+    m_notifications->notify(session.clientName(), message.priority());
+    refreshClient(clientId);
+}
+
+void ChatMasterWidget::updateMessageStatus(const QString& messageId, ChatMessage::Status status)
+{
+    const auto it = m_messageSequences.constFind(messageId);
+    if (it == m_messageSequences.constEnd()) {
+        return;
     }
 
-    playNotificationSound();
-    updateClientList();
+    // Acknowledgements are cumulative, so this covers all earlier messages too
+    const quint32 sequence = it->second;
+    switch (status) {
+    case ChatMessage::Status::Read:
+        acknowledgeMessages(it->first, sequence, sequence);
+        break;
+    case ChatMessage::Status::Delivered:
+        acknowledgeMessages(it->first, sequence, 0);
+        break;
+    case ChatMessage::Status::Sent:
+        break;
+    }
 }
 
-void ChatMasterWidget::updateMessageStatus(const QString& messageId, ChatMessage::Status status)
+void ChatMasterWidget::acknowledgeMessages(const QString& clientId, quint32 delivered, quint32 read)
 {
-    for (auto it = m_sessions.begin(); it != m_sessions.end(); ++it) {
-        auto history = it->history();
-        bool updated = false;
-        for (auto& message : history) {
-            if (message.messageId() == messageId) {
-                message.setStatus(status);
-                updated = true;
-            }
+    auto it = m_sessions.find(clientId);
+    if (it == m_sessions.end()) {
+        return;
+    }
+
+    if (!it->acknowledge(delivered, read)) {
+        return;
+    }
+
+    // Nothing changes for a message once it has been read
+    forgetSequences(clientId, it->readSequence());
+
+    if (clientId == m_currentClientId) {
+        updateStatusLabel();
+    }
+}
+
+QList<ChatMessage> ChatMasterWidget::sentMessages(const QString& clientId, quint32 first, quint32 last) const
+{
+    const auto it = m_sessions.constFind(clientId);
+    if (it == m_sessions.constEnd()) {
+        return {};
+    }
+    return it->sentMessages(first, last);
+}
+
+void ChatMasterWidget::receiveResync(const QString& clientId, const QList<ChatMessage>& messages, quint32 last)
+{
+    for (const auto& message : messages) {
+        receiveMessage(message);
+    }
+
+    auto it = m_sessions.find(clientId);
+    if (it != m_sessions.end()) {
+        it->receivedSequences().settle(last);
+    }
+}
+
+void ChatMasterWidget::mergeMessage(const QString& clientId, const ChatMessage& message)
+{
+    if (!m_seenMessages.insert(message.messageId())) {
+        return;
+    }
+
+    // The other master numbers its messages on its own, they are no part of
+    // this master's sequence
+    ChatMessage merged(message);
+    if (merged.senderId() == MASTER_ID) {
+        merged.setSequence(0);
+    }
+
+    const QStringList clientIds = clientId.isEmpty() ? m_sessions.keys() : QStringList{clientId};
+    for (const auto& id : clientIds) {
+        ChatSession& session = ensureSession(id);
+        retain(id, merged);
+        session.mergeMessage(merged);
+
+        // The client's copy to this master is now dropped as a duplicate, its
+        // number still counts; gaps are left to the direct messages
+        if (merged.senderId() == id) {
+            session.receivedSequences().receive(merged.sequence());
         }
-        if (updated) {
-            it->clearHistory();
-            for (const auto& msg : history) {
-                it->addMessage(msg);
+
+        if (id == m_currentClientId) {
+            if (session.history().constLast().messageId() == merged.messageId()) {
+                addMessageToDisplay(merged);
+            } else {
+                updateChatDisplay();
             }
+            markSessionRead(session);
         }
     }
 
-    if (!m_currentClientId.isEmpty()) {
+    if (clientId.isEmpty()) {
+        refreshAllClients();
+    } else {
+        refreshClient(clientId);
+    }
+}
+
+void ChatMasterWidget::mergeRead(const QString& clientId, const QStringList& messageIds)
+{
+    auto it = m_sessions.find(clientId);
+    if (it == m_sessions.end()) {
+        return;
+    }
+
+    it->markRead(messageIds);
+    refreshClient(clientId);
+}
+
+void ChatMasterWidget::mergeClear(const QString& clientId, const QStringList& messageIds)
+{
+    auto it = m_sessions.find(clientId);
+    if (it == m_sessions.end()) {
+        return;
+    }
+
+    it->removeMessages(messageIds);
+    if (clientId == m_currentClientId) {
         updateChatDisplay();
     }
+    refreshClient(clientId);
 }
 
 void ChatMasterWidget::setMasterName(const QString& name)
@@ -245,13 +456,43 @@ void ChatMasterWidget::onClientSelectionChanged()
     }
 
     m_currentClientId = newClientId;
+    resolveChatRequest(newClientId);
 
     if (ChatSession* session = getCurrentSession()) {
-        session->markAllAsRead();
+        markSessionRead(*session);
     }
 
     updateChatDisplay();
-    updateClientList();
+    refreshClient(m_currentClientId);
+}
+
+void ChatMasterWidget::onNextRequestClicked()
+{
+    if (m_chatRequests.isEmpty()) {
+        return;
+    }
+
+    const QString clientId = m_chatRequests.first();
+    resolveChatRequest(clientId);
+    focusClient(clientId);
+    m_messageInput->setFocus();
+}
+
+void ChatMasterWidget::onTriageModeToggled(bool enabled)
+{
+    m_triageMode = enabled;
+
+    QItemSelectionModel* previousSelection = m_clientList->selectionModel();
+    m_clientList->setModel(activeClientModel());
+    delete previousSelection;
+
+    connect(m_clientList->selectionModel(), &QItemSelectionModel::currentChanged, this, [this]() {
+        onClientSelectionChanged();
+    });
+
+    if (!m_currentClientId.isEmpty()) {
+        selectClient(m_currentClientId);
+    }
 }
 
 void ChatMasterWidget::onSendButtonClicked()
@@ -267,21 +508,26 @@ void ChatMasterWidget::onSendButtonClicked()
         return;
     }
 
+    ChatSession& session = ensureSession(clientId);
+
     ChatMessage message(MASTER_ID, clientId, content, priorityFromIndex(m_priorityCombo->currentIndex()));
+    message.setTimeToLive(m_ttlCombo->currentData().toInt());
+    retain(clientId, message);
+    message.setSequence(session.nextSequence());
+    m_messageSequences.insert(message.messageId(), qMakePair(clientId, message.sequence()));
+    m_unreadSequences[clientId].insert(message.sequence(), message.messageId());
     addMessageToDisplay(message);
 
-    if (!m_sessions.contains(clientId)) {
-        m_sessions.insert(clientId, ChatSession(clientId));
-    }
-
-    m_sessions[clientId].addMessage(message);
-    m_sessions[clientId].markAllAsRead();
+    session.addMessage(message);
+    emit messageRecorded(clientId, message);
+    markSessionRead(session);
 
     emit sendMessage(message);
 
     m_messageInput->clear();
     m_typingTimer->stop();
-    updateClientList();
+    refreshClient(clientId);
+    updateStatusLabel();
 }
 
 void ChatMasterWidget::onClearChatClicked()
@@ -293,11 +539,13 @@ void ChatMasterWidget::onClearChatClicked()
 
     if (auto* session = getCurrentSession()) {
         session->clearHistory();
+        forgetSequences(clientId, std::numeric_limits<quint32>::max());
+        emit sessionCleared(clientId);
     }
 
     m_chatDisplay->clear();
     emit clearClientChat(clientId);
-    updateClientList();
+    refreshClient(clientId);
 }
 
 void ChatMasterWidget::onGlobalBroadcastClicked()
@@ -307,18 +555,185 @@ void ChatMasterWidget::onGlobalBroadcastClicked()
         return;
     }
 
-    const auto priority = priorityFromIndex(m_priorityCombo->currentIndex());
+    broadcastMessage(content, priorityFromIndex(m_priorityCombo->currentIndex()), m_ttlCombo->currentData().toInt());
+    m_messageInput->clear();
+}
+
+void ChatMasterWidget::broadcastMessage(const QString& content, ChatMessage::Priority priority, int timeToLive)
+{
     emit sendGlobalMessage(content, priority);
 
     ChatMessage broadcast(MASTER_ID, QStringLiteral("*"), content, priority);
+    broadcast.setTimeToLive(timeToLive);
     addMessageToDisplay(broadcast);
 
     for (auto it = m_sessions.begin(); it != m_sessions.end(); ++it) {
+        retain(it.key(), broadcast);
         it->addMessage(broadcast);
     }
+    emit messageRecorded(QString(), broadcast);
+
+    refreshAllClients();
+}
+
+void ChatMasterWidget::retain(const QString& key, ChatMessage& message)
+{
+    message.setExpiresAt(m_retention.expiry(message));
+    m_compactor->track(key, message.expiresAt());
+}
+
+void ChatMasterWidget::onCompact(const QStringList& keys)
+{
+    const QDateTime now = QDateTime::currentDateTime();
+
+    for (const auto& key : keys) {
+        // Group histories are tracked under their receiver id
+        if (key.startsWith(QLatin1String(GROUP_RECEIVER_PREFIX))) {
+            const QString name = key.mid(int(qstrlen(GROUP_RECEIVER_PREFIX)));
+            if (m_groups.removeExpired(name, now) && name == m_shownGroup) {
+                showGroupHistory(name);
+            }
+            continue;
+        }
+
+        const QString& clientId = key;
+        auto it = m_sessions.find(clientId);
+        if (it == m_sessions.end()) {
+            continue;
+        }
+
+        const QStringList removed = it->removeExpired(now);
+        if (removed.isEmpty()) {
+            continue;
+        }
+
+        for (const auto& messageId : removed) {
+            const auto sequence = m_messageSequences.take(messageId);
+            if (!sequence.first.isEmpty()) {
+                m_unreadSequences[sequence.first].remove(sequence.second);
+            }
+        }
+
+        if (clientId == m_currentClientId) {
+            updateChatDisplay();
+        }
+
+        // Unread counts changed, which also moves the client in the triage order
+        m_clientModel->sessionChanged(clientId);
+    }
+
+    updateStatusLabel();
+}
+
+void ChatMasterWidget::onScheduleClicked()
+{
+    ChatAnnouncementDialog dialog(m_announcements, this);
+    dialog.exec();
+}
+
+void ChatMasterWidget::onSendFileTriggered(bool toClass)
+{
+    const QString clientId = toClass ? QString() : getSelectedClientId();
+    if (!toClass && clientId.isEmpty()) {
+        return;
+    }
+
+    const QString filePath = QFileDialog::getOpenFileName(this, tr("Send File"));
+    if (!filePath.isEmpty()) {
+        emit sendFile(filePath, clientId);
+    }
+}
+
+void ChatMasterWidget::updateGroupMenu()
+{
+    m_groupMenu->clear();
+
+    const QString clientId = getSelectedClientId();
+    const int handle = m_sessions.contains(clientId) ? m_sessions.value(clientId).handle() : -1;
+    const bool hasText = !m_messageInput->text().trimmed().isEmpty();
+
+    const auto groupNames = m_groups.groupNames();
+    for (const auto& name : groupNames) {
+        auto* groupMenu = m_groupMenu->addMenu(tr("%1 (%2 online of %3)")
+                                               .arg(name)
+                                               .arg(m_groups.resolve(name).size())
+                                               .arg(m_groups.members(name).size()));
+
+        auto* sendAction = groupMenu->addAction(tr("Send Message"), this, [this, name]() { sendToGroup(name); });
+        sendAction->setEnabled(hasText);
+        groupMenu->addAction(tr("Show Sent Messages"), this, [this, name]() { showGroupHistory(name); });
+        groupMenu->addSeparator();
+
+        if (handle >= 0 && m_groups.isMember(name, handle)) {
+            groupMenu->addAction(tr("Remove %1").arg(clientId), this, [this, name, handle]() {
+                m_groups.removeMember(name, handle);
+            });
+        } else if (handle >= 0) {
+            groupMenu->addAction(tr("Add %1").arg(clientId), this, [this, name, handle]() {
+                m_groups.addMember(name, handle);
+            });
+        }
+
+        groupMenu->addAction(tr("Delete Group"), this, [this, name]() { m_groups.removeGroup(name); });
+    }
+
+    if (!groupNames.isEmpty()) {
+        m_groupMenu->addSeparator();
+    }
+    m_groupMenu->addAction(tr("New Group..."), this, &ChatMasterWidget::onNewGroupTriggered);
+}
+
+void ChatMasterWidget::onNewGroupTriggered()
+{
+    const QString name = QInputDialog::getText(this, tr("New Group"), tr("Group name:")).trimmed();
+    if (!m_groups.addGroup(name)) {
+        return;
+    }
+
+    // Start the group with the selected student
+    const QString clientId = getSelectedClientId();
+    if (m_sessions.contains(clientId)) {
+        m_groups.addMember(name, m_sessions.value(clientId).handle());
+    }
+}
+
+void ChatMasterWidget::sendToGroup(const QString& name)
+{
+    const QString content = m_messageInput->text().trimmed();
+    if (content.isEmpty()) {
+        return;
+    }
+
+    const QStringList recipients = m_groups.resolve(name);
+    if (recipients.isEmpty()) {
+        QMessageBox::information(this, tr("Send to group"), tr("No member of %1 is online.").arg(name));
+        return;
+    }
+
+    ChatMessage message(MASTER_ID, GROUP_RECEIVER_PREFIX + name, content,
+                        priorityFromIndex(m_priorityCombo->currentIndex()));
+
+    // One history entry for the group instead of one per member
+    retain(GROUP_RECEIVER_PREFIX + name, message);
+    m_groups.addToHistory(name, message);
+    addMessageToDisplay(message);
+
+    emit sendGroupMessage(message, recipients);
 
     m_messageInput->clear();
-    updateClientList();
+    m_typingTimer->stop();
+}
+
+void ChatMasterWidget::showGroupHistory(const QString& name)
+{
+    m_shownGroup = name;
+    m_chatDisplay->clear();
+    m_chatDisplay->append(tr("Messages sent to %1:").arg(name));
+
+    const auto history = m_groups.history(name);
+    for (const auto& message : history) {
+        addMessageToDisplay(message);
+    }
 }
 
 void ChatMasterWidget::onMessageInputChanged()
@@ -330,7 +745,7 @@ void ChatMasterWidget::onMessageInputChanged()
     if (hasText) {
         if (auto* session = getCurrentSession()) {
             session->setStatus(ChatSession::ClientStatus::Typing);
-            updateClientList();
+            refreshClient(m_currentClientId);
         }
         m_typingTimer->start();
     }
@@ -352,21 +767,69 @@ void ChatMasterWidget::onTypingTimer()
 {
     if (auto* session = getCurrentSession()) {
         session->setStatus(ChatSession::ClientStatus::Online);
-        updateClientList();
+        refreshClient(m_currentClientId);
     }
 }
 
-void ChatMasterWidget::playNotificationSound()
+void ChatMasterWidget::onTypingLeasesExpired(const QStringList& clientIds)
 {
-    if (!m_soundEnabled) {
-        return;
+    for (const QString& clientId : clientIds) {
+        auto it = m_sessions.find(clientId);
+        if (it != m_sessions.end() && it->status() == ChatSession::ClientStatus::Typing) {
+            it->setStatus(ChatSession::ClientStatus::Online);
+            m_clientModel->sessionChanged(clientId);
+        }
     }
 
-    if (m_notificationSound->status() == QSoundEffect::Ready) {
-        m_notificationSound->play();
-    } else if (m_notificationSound->status() == QSoundEffect::Null) {
-        m_notificationSound->setSource(QUrl(QStringLiteral("qrc:/chat/sounds/notification.wav")));
-        m_notificationSound->setVolume(0.6);
+    updateStatusLabel();
+}
+
+void ChatMasterWidget::onPresenceChanged(const ChatPresenceTracker::StatusChanges& changes)
+{
+    for (auto it = changes.constBegin(); it != changes.constEnd(); ++it) {
+        ChatSession& session = ensureSession(it.key());
+        m_groups.setOnline(session.handle(), it.value() != ChatSession::ClientStatus::Offline);
+
+        if (it.value() == ChatSession::ClientStatus::Online) {
+            // Being heard of again must not override a running typing lease
+            if (session.status() != ChatSession::ClientStatus::Away &&
+                session.status() != ChatSession::ClientStatus::Offline) {
+                continue;
+            }
+        } else {
+            m_typingLeases->cancel(it.key());
+        }
+
+        session.setStatus(it.value());
+        m_clientModel->sessionChanged(it.key());
+    }
+
+    updateStatusLabel();
+}
+
+void ChatMasterWidget::onNotificationDigest(int messageCount, const QStringList& senders, bool urgent)
+{
+    if (m_trayIcon && !isActiveWindow()) {
+        QString text;
+        if (messageCount == 1) {
+            text = urgent ? tr("Urgent message from %1").arg(senders.value(0))
+                          : tr("Message from %1").arg(senders.value(0));
+        } else if (senders.size() == 1) {
+            text = tr("%1 new messages from %2").arg(messageCount).arg(senders.first());
+        } else {
+            text = tr("%1 new messages from %2 students").arg(messageCount).arg(senders.size());
+        }
+
+        m_trayIcon->showMessage(tr("New message"), text, QIcon(QStringLiteral(":/chat/icons/chat.png")));
+    }
+
+    playNotificationSound();
+}
+
+void ChatMasterWidget::playNotificationSound()
+{
+    // The sound is loaded once at startup, alerts arriving before it is ready stay silent
+    if (m_soundEnabled && m_notificationSound->status() == QSoundEffect::Ready) {
         m_notificationSound->play();
     }
 }
@@ -385,8 +848,20 @@ void ChatMasterWidget::setupUI()
     auto* leftLayout = new QVBoxLayout(leftWidget);
     leftLayout->setContentsMargins(0, 0, 0, 0);
 
-    m_clientList = new QListWidget(leftWidget);
+    m_triageCheck = new QCheckBox(tr("Waiting clients first"), leftWidget);
+    m_triageCheck->setToolTip(tr("Order clients by unread messages, urgency and waiting time"));
+    leftLayout->addWidget(m_triageCheck);
+
+    m_sortedClientModel->setSourceModel(m_clientModel);
+    m_sortedClientModel->setSortRole(ChatClientListModel::ClientIdRole);
+    m_sortedClientModel->setDynamicSortFilter(true);
+    m_sortedClientModel->sort(0);
+
+    m_triageClientModel->setSourceModel(m_clientModel);
+
+    m_clientList = new QListView(leftWidget);
     m_clientList->setSelectionMode(QAbstractItemView::SingleSelection);
+    m_clientList->setEditTriggers(QAbstractItemView::NoEditTriggers);
     leftLayout->addWidget(m_clientList);
 
     auto* rightWidget = new QWidget(this);
@@ -407,10 +882,21 @@ void ChatMasterWidget::setupUI()
     m_priorityCombo->addItem(tr("Urgent"));
     m_priorityCombo->addItem(tr("Announcement"));
     quickLayout->addWidget(m_priorityCombo);
+
+    // Seconds, 0 falls back to the configured time to live of the priority
+    m_ttlCombo = new QComboBox(rightWidget);
+    m_ttlCombo->setToolTip(tr("Remove the message after"));
+    m_ttlCombo->addItem(tr("Keep"), 0);
+    m_ttlCombo->addItem(tr("1 minute"), 60);
+    m_ttlCombo->addItem(tr("5 minutes"), 5 * 60);
+    m_ttlCombo->addItem(tr("15 minutes"), 15 * 60);
+    m_ttlCombo->addItem(tr("1 hour"), 60 * 60);
+    quickLayout->addWidget(m_ttlCombo);
     rightLayout->addLayout(quickLayout);
 
     auto* inputLayout = new QHBoxLayout();
     m_messageInput = new QLineEdit(rightWidget);
+    m_messageInput->setObjectName(QStringLiteral("messageInput"));
     m_messageInput->setPlaceholderText(tr("Type a message"));
     inputLayout->addWidget(m_messageInput, 1);
 
@@ -425,6 +911,33 @@ void ChatMasterWidget::setupUI()
     m_globalButton->setEnabled(false);
     inputLayout->addWidget(m_globalButton);
 
+    m_fileButton = new QPushButton(tr("Send File"), rightWidget);
+    auto* fileMenu = new QMenu(m_fileButton);
+    auto* fileToStudentAction = fileMenu->addAction(tr("To Selected Student..."));
+    auto* fileToClassAction = fileMenu->addAction(tr("To Whole Class..."));
+    connect(fileToStudentAction, &QAction::triggered, this, [this]() { onSendFileTriggered(false); });
+    connect(fileToClassAction, &QAction::triggered, this, [this]() { onSendFileTriggered(true); });
+    connect(fileMenu, &QMenu::aboutToShow, this, [this, fileToStudentAction]() {
+        fileToStudentAction->setEnabled(!getSelectedClientId().isEmpty());
+    });
+    m_fileButton->setMenu(fileMenu);
+    inputLayout->addWidget(m_fileButton);
+
+    m_groupButton = new QPushButton(tr("Groups"), rightWidget);
+    m_groupMenu = new QMenu(m_groupButton);
+    connect(m_groupMenu, &QMenu::aboutToShow, this, &ChatMasterWidget::updateGroupMenu);
+    m_groupButton->setMenu(m_groupMenu);
+    inputLayout->addWidget(m_groupButton);
+
+    m_scheduleButton = new QPushButton(tr("Schedule..."), rightWidget);
+    m_scheduleButton->setToolTip(tr("Announce something to the class at a given time"));
+    inputLayout->addWidget(m_scheduleButton);
+
+    m_requestsButton = new QPushButton(rightWidget);
+    m_requestsButton->setToolTip(tr("Open the chat of the next student who pressed F10"));
+    inputLayout->addWidget(m_requestsButton);
+    updateRequestsButton();
+
     rightLayout->addLayout(inputLayout);
 
     m_splitter->addWidget(leftWidget);
@@ -493,6 +1006,12 @@ void ChatMasterWidget::setupQuickReplies()
     m_quickReplies->addItem(tr("Do you need any help?"));
 }
 
+void ChatMasterWidget::setupSound()
+{
+    m_notificationSound->setSource(QUrl(QStringLiteral("qrc:/chat/sounds/notification.wav")));
+    m_notificationSound->setVolume(0.6);
+}
+
 void ChatMasterWidget::loadSettings()
 {
     QSettings settings(ORGANIZATION_NAME, APPLICATION_NAME);
@@ -500,6 +1019,22 @@ void ChatMasterWidget::loadSettings()
         restoreGeometry(settings.value(SETTINGS_GEOMETRY).toByteArray());
     }
     m_soundEnabled = settings.value(SETTINGS_SOUND, true).toBool();
+    m_triageMode = settings.value(SETTINGS_TRIAGE, false).toBool();
+
+    m_retention = ChatRetentionPolicy::load(APPLICATION_NAME);
+
+    const QSignalBlocker blocker(m_triageCheck);
+    m_triageCheck->setChecked(m_triageMode);
+
+    // Memberships are stored by client id, handles only exist per run
+    const auto groups = settings.value(SETTINGS_GROUPS).toMap();
+    for (auto it = groups.constBegin(); it != groups.constEnd(); ++it) {
+        m_groups.addGroup(it.key());
+        const auto clientIds = it.value().toStringList();
+        for (const auto& clientId : clientIds) {
+            m_pendingGroupMembers[clientId].append(it.key());
+        }
+    }
 }
 
 void ChatMasterWidget::saveSettings()
@@ -507,51 +1042,153 @@ void ChatMasterWidget::saveSettings()
     QSettings settings(ORGANIZATION_NAME, APPLICATION_NAME);
     settings.setValue(SETTINGS_GEOMETRY, saveGeometry());
     settings.setValue(SETTINGS_SOUND, m_soundEnabled);
+    settings.setValue(SETTINGS_TRIAGE, m_triageMode);
+
+    QVariantMap groups;
+    const auto groupNames = m_groups.groupNames();
+    for (const auto& name : groupNames) {
+        groups.insert(name, m_groups.members(name));
+    }
+    for (auto it = m_pendingGroupMembers.constBegin(); it != m_pendingGroupMembers.constEnd(); ++it) {
+        for (const auto& name : it.value()) {
+            if (groups.contains(name)) {
+                groups[name] = groups.value(name).toStringList() << it.key();
+            }
+        }
+    }
+    settings.setValue(SETTINGS_GROUPS, groups);
 }
 
-void ChatMasterWidget::updateClientList()
+ChatSession& ChatMasterWidget::ensureSession(const QString& clientId)
 {
-    const QString previousSelection = getSelectedClientId();
+    auto it = m_sessions.find(clientId);
+    if (it == m_sessions.end()) {
+        ChatSession session(clientId);
+        session.setHandle(m_nextSessionHandle++);
+        it = m_sessions.insert(clientId, session);
 
-    m_clientList->clear();
-    for (auto it = m_sessions.constBegin(); it != m_sessions.constEnd(); ++it) {
-        const ChatSession& session = it.value();
-        QString label = session.clientName();
-        if (session.hasUnreadMessages()) {
-            label += tr(" (%1 new)").arg(session.unreadCount());
-        }
-        QListWidgetItem* item = new QListWidgetItem(label, m_clientList);
-        item->setData(Qt::UserRole, it.key());
-        item->setToolTip(session.statusString());
-        if (it.key() == m_currentClientId) {
-            item->setSelected(true);
+        m_groups.registerSession(session.handle(), clientId);
+        const auto groupNames = m_pendingGroupMembers.take(clientId);
+        for (const auto& name : groupNames) {
+            m_groups.addMember(name, session.handle());
         }
+        m_clientModel->addSession(clientId);
+        sessionCount().set(m_sessions.size());
     }
 
-    if (!previousSelection.isEmpty()) {
-        for (int i = 0; i < m_clientList->count(); ++i) {
-            QListWidgetItem* item = m_clientList->item(i);
-            if (item->data(Qt::UserRole).toString() == previousSelection) {
-                m_clientList->setCurrentItem(item);
+    return it.value();
+}
+
+void ChatMasterWidget::refreshClient(const QString& clientId)
+{
+    m_clientModel->sessionChanged(clientId);
+
+    if (m_currentClientId.isEmpty() && m_clientList->model()->rowCount() > 0) {
+        m_clientList->setCurrentIndex(m_clientList->model()->index(0, 0));
+    }
+
+    updateStatusLabel();
+}
+
+void ChatMasterWidget::refreshAllClients()
+{
+    m_clientModel->allSessionsChanged();
+    updateStatusLabel();
+}
+
+void ChatMasterWidget::updateStatusLabel()
+{
+    if (auto* session = getCurrentSession()) {
+        QString text = tr("Selected: %1 (%2)").arg(session->clientName(), session->statusString());
+        if (session->lastSequence() != 0) {
+            switch (session->deliveryStatus(session->lastSequence())) {
+            case ChatMessage::Status::Read:
+                text += tr(" - seen");
+                break;
+            case ChatMessage::Status::Delivered:
+                text += tr(" - delivered");
+                break;
+            case ChatMessage::Status::Sent:
                 break;
             }
         }
+        m_statusLabel->setText(text);
+    } else {
+        m_statusLabel->setText(tr("No client selected"));
     }
+}
+
+void ChatMasterWidget::updateRequestsButton()
+{
+    m_requestsButton->setText(tr("Requests (%1)").arg(m_chatRequests.size()));
+    m_requestsButton->setEnabled(!m_chatRequests.isEmpty());
+}
 
-    if (m_currentClientId.isEmpty() && m_clientList->count() > 0) {
-        m_clientList->setCurrentRow(0);
+void ChatMasterWidget::resolveChatRequest(const QString& clientId)
+{
+    if (m_chatRequests.removeOne(clientId)) {
+        updateRequestsButton();
+        emit chatRequestResolved(clientId);
     }
+}
 
-    if (auto* session = getCurrentSession()) {
-        m_statusLabel->setText(tr("Selected: %1 (%2)")
-                                   .arg(session->clientName(), session->statusString()));
-    } else {
-        m_statusLabel->setText(tr("No client selected"));
+// Drops the messages to a client up to the given sequence from the lookup
+// by message id
+void ChatMasterWidget::forgetSequences(const QString& clientId, quint32 until)
+{
+    auto it = m_unreadSequences.find(clientId);
+    if (it == m_unreadSequences.end()) {
+        return;
+    }
+
+    auto& sequences = it.value();
+    while (!sequences.isEmpty() && sequences.firstKey() <= until) {
+        m_messageSequences.remove(sequences.first());
+        sequences.erase(sequences.begin());
+    }
+
+    if (sequences.isEmpty()) {
+        m_unreadSequences.erase(it);
     }
 }
 
+void ChatMasterWidget::selectClient(const QString& clientId)
+{
+    const QModelIndex sourceIndex = m_clientModel->indexOf(clientId);
+    if (!sourceIndex.isValid()) {
+        return;
+    }
+
+    const QModelIndex index = activeClientModel()->mapFromSource(sourceIndex);
+    if (index.isValid() && index != m_clientList->currentIndex()) {
+        m_clientList->setCurrentIndex(index);
+    }
+}
+
+QAbstractProxyModel* ChatMasterWidget::activeClientModel() const
+{
+    if (m_triageMode) {
+        return m_triageClientModel;
+    }
+    return m_sortedClientModel;
+}
+
+void ChatMasterWidget::markSessionRead(ChatSession& session)
+{
+    if (!session.hasUnreadMessages()) {
+        session.markAllAsRead();
+        return;
+    }
+
+    session.markAllAsRead();
+    emit sessionRead(session.clientId());
+}
+
 void ChatMasterWidget::updateChatDisplay()
 {
+    const ChatMetricsTimer timer(refreshTime());
+
+    m_shownGroup.clear();
     m_chatDisplay->clear();
     if (auto* session = getCurrentSession()) {
         const auto history = session->history();
@@ -585,8 +1222,9 @@ QString ChatMasterWidget::formatMessage(const ChatMessage& message) const
 
 QString ChatMasterWidget::getSelectedClientId() const
 {
-    if (QListWidgetItem* item = m_clientList->currentItem()) {
-        return item->data(Qt::UserRole).toString();
+    const QModelIndex index = m_clientList->currentIndex();
+    if (index.isValid()) {
+        return index.data(ChatClientListModel::ClientIdRole).toString();
     }
     return m_currentClientId;
 }
@@ -24,6 +24,9 @@
 
 #pragma once
 
+#include <QHash>
+#include <QMap>
+#include <QPair>
 #include <QWidget>
 #include <QSystemTrayIcon>
 #include <QTimer>
@@ -31,18 +34,32 @@
 #include <QSoundEffect>
 #include "ChatSession.h"
 #include "ChatMessage.h"
+#include "ChatMessageDedup.h"
+#include "ChatGroupIndex.h"
+#include "ChatHistoryCompactor.h"
+#include "ChatPresenceTracker.h"
 
 QT_BEGIN_NAMESPACE
-class QListWidget;
-class QListWidgetItem;
+class QAbstractProxyModel;
+class QCheckBox;
+class QListView;
+class QModelIndex;
+class QSortFilterProxyModel;
 class QTextEdit;
 class QLineEdit;
 class QPushButton;
 class QComboBox;
 class QLabel;
+class QMenu;
 class QSplitter;
 QT_END_NAMESPACE
 
+class ChatAnnouncementScheduler;
+class ChatClientListModel;
+class ChatNotificationAggregator;
+class ChatTimerWheel;
+class ChatTriageProxyModel;
+
 class ChatMasterWidget : public QWidget
 {
     Q_OBJECT
@@ -54,12 +71,29 @@ public:
     // Session management
     void addClient(const QString& clientId, const QString& clientName);
     void removeClient(const QString& clientId);
-    void updateClientStatus(const QString& clientId, ChatSession::ClientStatus status);
+    void updateClientStatus(const QString& clientId, ChatSession::ClientStatus status, int lease = 0);
     void focusClient(const QString& clientId);
+    void touchClient(const QString& clientId);
+    void addChatRequest(const QString& clientId);
     
     // Message handling
     void receiveMessage(const ChatMessage& message);
     void updateMessageStatus(const QString& messageId, ChatMessage::Status status);
+    void acknowledgeMessages(const QString& clientId, quint32 delivered, quint32 read);
+
+    // Delta resync: messages a client reported missing, and the answer to
+    // a gap detected here
+    QList<ChatMessage> sentMessages(const QString& clientId, quint32 first, quint32 last) const;
+    void receiveResync(const QString& clientId, const QList<ChatMessage>& messages, quint32 last);
+
+    // Changes replicated from another master, an empty client id stands for
+    // all sessions. Nothing is sent to clients.
+    void mergeMessage(const QString& clientId, const ChatMessage& message);
+    void mergeRead(const QString& clientId, const QStringList& messageIds);
+    void mergeClear(const QString& clientId, const QStringList& messageIds);
+
+    // Sends to all clients and records the message in every session
+    void broadcastMessage(const QString& content, ChatMessage::Priority priority, int timeToLive = 0);
     
     // Settings
     void setMasterName(const QString& name);
@@ -68,7 +102,17 @@ public:
 signals:
     void sendMessage(const ChatMessage& message);
     void sendGlobalMessage(const QString& content, ChatMessage::Priority priority);
+    // Encoded once and sent to the reachable members only
+    void sendGroupMessage(const ChatMessage& message, const QStringList& clientIds);
     void clearClientChat(const QString& clientId);
+    void chatRequestResolved(const QString& clientId);
+    void resyncRequested(const QString& clientId, quint32 first, quint32 last);
+    // An empty client id sends the file to the whole class
+    void sendFile(const QString& filePath, const QString& clientId);
+    // Local session changes for replication to other masters
+    void messageRecorded(const QString& clientId, const ChatMessage& message);
+    void sessionRead(const QString& clientId);
+    void sessionCleared(const QString& clientId);
 
 protected:
     void closeEvent(QCloseEvent* event) override;
@@ -76,12 +120,22 @@ protected:
 
 private slots:
     void onClientSelectionChanged();
+    void onTriageModeToggled(bool enabled);
+    void onNextRequestClicked();
     void onSendButtonClicked();
     void onClearChatClicked();
     void onGlobalBroadcastClicked();
+    void onSendFileTriggered(bool toClass);
+    void onScheduleClicked();
+    void onCompact(const QStringList& keys);
+    void updateGroupMenu();
+    void onNewGroupTriggered();
     void onMessageInputChanged();
     void onTrayIconActivated(QSystemTrayIcon::ActivationReason reason);
     void onTypingTimer();
+    void onTypingLeasesExpired(const QStringList& clientIds);
+    void onPresenceChanged(const ChatPresenceTracker::StatusChanges& changes);
+    void onNotificationDigest(int messageCount, const QStringList& senders, bool urgent);
     void playNotificationSound();
 
 private:
@@ -89,10 +143,23 @@ private:
     void setupTrayIcon();
     void setupShortcuts();
     void setupQuickReplies();
+    void setupSound();
     void loadSettings();
     void saveSettings();
     
-    void updateClientList();
+    ChatSession& ensureSession(const QString& clientId);
+    void refreshClient(const QString& clientId);
+    void refreshAllClients();
+    void updateStatusLabel();
+    void markSessionRead(ChatSession& session);
+    void sendToGroup(const QString& name);
+    void retain(const QString& key, ChatMessage& message);
+    void showGroupHistory(const QString& name);
+    void updateRequestsButton();
+    void resolveChatRequest(const QString& clientId);
+    void forgetSequences(const QString& clientId, quint32 until);
+    void selectClient(const QString& clientId);
+    QAbstractProxyModel* activeClientModel() const;
     void updateChatDisplay();
     void addMessageToDisplay(const ChatMessage& message);
     void scrollToBottom();
@@ -103,13 +170,23 @@ private:
     
     // UI components
     QSplitter* m_splitter;
-    QListWidget* m_clientList;
+    QListView* m_clientList;
+    QCheckBox* m_triageCheck;
+    ChatClientListModel* m_clientModel;
+    QSortFilterProxyModel* m_sortedClientModel;
+    ChatTriageProxyModel* m_triageClientModel;
     QTextEdit* m_chatDisplay;
     QLineEdit* m_messageInput;
     QPushButton* m_sendButton;
     QPushButton* m_clearButton;
     QPushButton* m_globalButton;
+    QPushButton* m_fileButton;
+    QPushButton* m_groupButton;
+    QMenu* m_groupMenu;
+    QPushButton* m_scheduleButton;
+    QPushButton* m_requestsButton;
     QComboBox* m_priorityCombo;
+    QComboBox* m_ttlCombo;
     QComboBox* m_quickReplies;
     QLabel* m_statusLabel;
     
@@ -122,13 +199,38 @@ private:
     
     // Timers
     QTimer* m_typingTimer;
+    ChatTimerWheel* m_typingLeases;
+    ChatPresenceTracker* m_presence;
     
-    // Sound
+    // Notifications
     QSoundEffect* m_notificationSound;
+    ChatNotificationAggregator* m_notifications;
+
+    // Announcements
+    ChatAnnouncementScheduler* m_announcements;
+
+    // Expiry of transient messages
+    ChatRetentionPolicy m_retention;
+    ChatHistoryCompactor* m_compactor;
     
     // Data
     QMap<QString, ChatSession> m_sessions;
+    QStringList m_chatRequests;
     QString m_masterName;
     QString m_currentClientId;
+    // Group whose sent messages are on display instead of a client's chat
+    QString m_shownGroup;
+    int m_nextSessionHandle;
     bool m_soundEnabled;
+    bool m_triageMode;
+    // Ids of received and merged messages, a student's message reaches
+    // every master in the room but is shown once
+    ChatMessageDedup m_seenMessages;
+    ChatGroupIndex m_groups;
+    // Saved memberships of clients which have not shown up yet
+    QHash<QString, QStringList> m_pendingGroupMembers;
+    // Session and sequence number of each message sent to a single client
+    // which has not been read yet, and the same by client and sequence
+    QHash<QString, QPair<QString, quint32>> m_messageSequences;
+    QHash<QString, QMap<quint32, QString>> m_unreadSequences;
 };
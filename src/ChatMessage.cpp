@@ -29,7 +29,8 @@
 ChatMessage::ChatMessage() :
     m_priority(Priority::Normal),
     m_status(Status::Sent),
-    m_timestamp(QDateTime::currentDateTime())
+    m_timestamp(QDateTime::currentDateTime()),
+    m_sequence(0)
 {
     generateMessageId();
 }
@@ -41,7 +42,8 @@ ChatMessage::ChatMessage(const QString& senderId, const QString& receiverId,
     m_content(content),
     m_priority(priority),
     m_status(Status::Sent),
-    m_timestamp(QDateTime::currentDateTime())
+    m_timestamp(QDateTime::currentDateTime()),
+    m_sequence(0)
 {
     generateMessageId();
 }
@@ -61,6 +63,12 @@ QJsonObject ChatMessage::toJson() const
     json["timestamp"] = m_timestamp.toMSecsSinceEpoch();
     json["priority"] = static_cast<int>(m_priority);
     json["status"] = static_cast<int>(m_status);
+    if (m_sequence != 0) {
+        json["seq"] = static_cast<qint64>(m_sequence);
+    }
+    if (m_expiresAt.isValid()) {
+        json["expires"] = m_expiresAt.toMSecsSinceEpoch();
+    }
     return json;
 }
 
@@ -74,6 +82,10 @@ ChatMessage ChatMessage::fromJson(const QJsonObject& json)
     message.m_timestamp = QDateTime::fromMSecsSinceEpoch(json["timestamp"].toVariant().toLongLong());
     message.m_priority = static_cast<Priority>(json["priority"].toInt());
     message.m_status = static_cast<Status>(json["status"].toInt());
+    message.m_sequence = json["seq"].toVariant().toUInt();
+    if (json.contains("expires")) {
+        message.m_expiresAt = QDateTime::fromMSecsSinceEpoch(json["expires"].toVariant().toLongLong());
+    }
     return message;
 }
 
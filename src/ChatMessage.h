@@ -57,10 +57,17 @@ public:
     QDateTime timestamp() const { return m_timestamp; }
     Priority priority() const { return m_priority; }
     Status status() const { return m_status; }
+    // Position among the master's messages to one client, 0 if unnumbered
+    quint32 sequence() const { return m_sequence; }
+    // Invalid for messages which are kept
+    QDateTime expiresAt() const { return m_expiresAt; }
     
     // Setters
     void setStatus(Status status) { m_status = status; }
+    void setSequence(quint32 sequence) { m_sequence = sequence; }
     void setContent(const QString& content) { m_content = content; }
+    void setExpiresAt(const QDateTime& expiresAt) { m_expiresAt = expiresAt; }
+    void setTimeToLive(int seconds) { m_expiresAt = seconds > 0 ? m_timestamp.addSecs(seconds) : QDateTime(); }
     
     // Serialization
     QJsonObject toJson() const;
@@ -79,6 +86,8 @@ private:
     QDateTime m_timestamp;
     Priority m_priority;
     Status m_status;
+    quint32 m_sequence;
+    QDateTime m_expiresAt;
     
     void generateMessageId();
 };
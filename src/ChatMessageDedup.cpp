@@ -0,0 +1,102 @@
+/*
+ * ChatMessageDedup.cpp - implementation of ChatMessageDedup class
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include "ChatMessageDedup.h"
+#include <cmath>
+
+namespace {
+// FNV-1a over the UTF-16 code units, split into two halves for double hashing
+quint64 hashId(const QString& id)
+{
+    quint64 hash = 14695981039346656037ULL;
+    for (const QChar c : id) {
+        hash ^= c.unicode();
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+}
+
+ChatMessageDedup::ChatMessageDedup(int capacity, double falsePositiveRate) :
+    m_capacity(qMax(capacity, 1)),
+    m_currentCount(0)
+{
+    // A lookup tests both filters, so each gets half of the budget
+    const double rate = qBound(1e-9, falsePositiveRate / 2, 0.5);
+    const double ln2 = std::log(2.0);
+
+    const double bits = -m_capacity * std::log(rate) / (ln2 * ln2);
+    m_bitCount = int(qMin(std::ceil(bits / 64) * 64, double(1 << 30)));
+    m_hashCount = qBound(1, int(std::round(m_bitCount / double(m_capacity) * ln2)), 32);
+
+    m_current.fill(0, m_bitCount / 64);
+    m_previous.fill(0, m_bitCount / 64);
+}
+
+bool ChatMessageDedup::insert(const QString& messageId)
+{
+    if (messageId.isEmpty()) {
+        return true;
+    }
+
+    const quint64 hash = hashId(messageId);
+    const quint32 h1 = quint32(hash);
+    const quint32 h2 = quint32(hash >> 32) | 1;
+
+    if (contains(m_current, h1, h2) || contains(m_previous, h1, h2)) {
+        return false;
+    }
+
+    if (m_currentCount >= m_capacity) {
+        m_previous.swap(m_current);
+        m_current.fill(0);
+        m_currentCount = 0;
+    }
+
+    for (int i = 0; i < m_hashCount; ++i) {
+        const quint32 bit = (h1 + quint32(i) * h2) % quint32(m_bitCount);
+        m_current[int(bit / 64)] |= quint64(1) << (bit % 64);
+    }
+    ++m_currentCount;
+
+    return true;
+}
+
+void ChatMessageDedup::clear()
+{
+    m_current.fill(0);
+    m_previous.fill(0);
+    m_currentCount = 0;
+}
+
+bool ChatMessageDedup::contains(const QVector<quint64>& filter, quint32 h1, quint32 h2) const
+{
+    for (int i = 0; i < m_hashCount; ++i) {
+        const quint32 bit = (h1 + quint32(i) * h2) % quint32(m_bitCount);
+        if ((filter[int(bit / 64)] & (quint64(1) << (bit % 64))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,59 @@
+/*
+ * ChatMessageDedup.h - declaration of ChatMessageDedup class
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#pragma once
+
+#include <QString>
+#include <QVector>
+
+// Remembers recently seen message ids in two rotating Bloom filters so that
+// retried or replayed messages are dropped in O(1) with bounded memory.
+// Once the current filter holds its capacity it becomes the previous one
+// and a cleared filter takes over, so at least the last capacity ids are
+// always remembered. A fresh id is wrongly reported as seen with a
+// probability of at most the given false positive rate.
+class ChatMessageDedup
+{
+public:
+    explicit ChatMessageDedup(int capacity = 4096, double falsePositiveRate = 1e-4);
+
+    // Returns false if the id has (probably) been seen before. Empty ids
+    // are never considered duplicates.
+    bool insert(const QString& messageId);
+    void clear();
+
+    int capacity() const { return m_capacity; }
+    int hashCount() const { return m_hashCount; }
+    int bitCount() const { return m_bitCount; }
+
+private:
+    bool contains(const QVector<quint64>& filter, quint32 h1, quint32 h2) const;
+
+    int m_capacity;
+    int m_bitCount;
+    int m_hashCount;
+    int m_currentCount;
+    QVector<quint64> m_current;
+    QVector<quint64> m_previous;
+};
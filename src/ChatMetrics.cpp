@@ -0,0 +1,278 @@
+/*
+ * ChatMetrics.cpp - implementation of ChatMetrics class
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include "ChatMetrics.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+
+#include <algorithm>
+
+namespace {
+constexpr double QUANTILES[] = { 0.5, 0.9, 0.99, 0.999 };
+
+QString seconds(quint64 nanoseconds)
+{
+    return QString::number(double(nanoseconds) / 1e9, 'g', 6);
+}
+
+// Prometheus labels of a metric with an optional extra label
+QString labelSet(const QString& labels, const QString& extra = QString())
+{
+    QStringList parts;
+    if (!labels.isEmpty()) {
+        parts.append(labels);
+    }
+    if (!extra.isEmpty()) {
+        parts.append(extra);
+    }
+    return parts.isEmpty() ? QString() : QLatin1Char('{') + parts.join(QLatin1Char(',')) + QLatin1Char('}');
+}
+}
+
+void ChatHistogram::record(quint64 nanoseconds)
+{
+    m_buckets[size_t(bucketIndex(nanoseconds))].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(nanoseconds, std::memory_order_relaxed);
+}
+
+quint64 ChatHistogram::percentile(double fraction) const
+{
+    const quint64 total = count();
+    if (total == 0) {
+        return 0;
+    }
+
+    // Buckets keep counting meanwhile, the snapshot is close enough
+    const auto rank = quint64(qMax(1.0, fraction * double(total) + 0.5));
+    quint64 seen = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        seen += m_buckets[size_t(i)].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            return bucketUpperBound(i);
+        }
+    }
+    return bucketUpperBound(BucketCount - 1);
+}
+
+int ChatHistogram::bucketIndex(quint64 value)
+{
+    value = qMin(value, (quint64(1) << MaxValueBits) - 1);
+    if (value < quint64(2 * SubBuckets)) {
+        return int(value);
+    }
+
+    // The top SubBucketBits + 1 bits select the bucket within the magnitude
+    const int shift = 63 - qCountLeadingZeroBits(value) - SubBucketBits;
+    return SubBuckets * (shift + 1) + int(value >> shift) - SubBuckets;
+}
+
+quint64 ChatHistogram::bucketUpperBound(int index)
+{
+    if (index < 2 * SubBuckets) {
+        return quint64(index);
+    }
+
+    const int shift = index / SubBuckets - 1;
+    const quint64 mantissa = quint64(index % SubBuckets + SubBuckets);
+    return ((mantissa + 1) << shift) - 1;
+}
+
+ChatMetrics& ChatMetrics::instance()
+{
+    static ChatMetrics metrics;
+    return metrics;
+}
+
+ChatMetrics::Entry& ChatMetrics::entry(Type type, const QString& name, const QString& help, const QString& labels)
+{
+    for (const auto& existing : m_entries) {
+        if (existing->type == type && existing->name == name && existing->labels == labels) {
+            return *existing;
+        }
+    }
+
+    auto created = std::make_unique<Entry>();
+    created->type = type;
+    created->name = name;
+    created->help = help;
+    created->labels = labels;
+    m_entries.push_back(std::move(created));
+    return *m_entries.back();
+}
+
+ChatCounter& ChatMetrics::counter(const QString& name, const QString& help, const QString& labels)
+{
+    QMutexLocker locker(&m_mutex);
+    auto& result = entry(Type::Counter, name, help, labels);
+    if (!result.counter) {
+        result.counter = std::make_unique<ChatCounter>();
+    }
+    return *result.counter;
+}
+
+ChatCounterFamily& ChatMetrics::counterFamily(const QString& name, const QString& help,
+                                              const QString& label, const QStringList& values)
+{
+    QMutexLocker locker(&m_mutex);
+    auto& result = entry(Type::CounterFamily, name, help, QString());
+    if (!result.family) {
+        result.label = label;
+        result.family = std::make_unique<ChatCounterFamily>(values);
+    }
+    return *result.family;
+}
+
+ChatGauge& ChatMetrics::gauge(const QString& name, const QString& help, const QString& labels)
+{
+    QMutexLocker locker(&m_mutex);
+    auto& result = entry(Type::Gauge, name, help, labels);
+    if (!result.gauge) {
+        result.gauge = std::make_unique<ChatGauge>();
+    }
+    return *result.gauge;
+}
+
+ChatHistogram& ChatMetrics::histogram(const QString& name, const QString& help, const QString& labels)
+{
+    QMutexLocker locker(&m_mutex);
+    auto& result = entry(Type::Histogram, name, help, labels);
+    if (!result.histogram) {
+        result.histogram = std::make_unique<ChatHistogram>();
+    }
+    return *result.histogram;
+}
+
+QByteArray ChatMetrics::toJson() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    QJsonArray metrics;
+    for (const auto& entry : m_entries) {
+        QJsonObject metric{
+            {QStringLiteral("name"), entry->name},
+            {QStringLiteral("labels"), entry->labels}
+        };
+
+        switch (entry->type) {
+        case Type::Counter:
+            metric.insert(QStringLiteral("type"), QStringLiteral("counter"));
+            metric.insert(QStringLiteral("value"), QString::number(entry->counter->value()));
+            break;
+        case Type::CounterFamily: {
+            QJsonObject values;
+            for (int i = 0; i < entry->family->size(); ++i) {
+                if (entry->family->value(i) > 0) {
+                    values.insert(entry->family->valueName(i), QString::number(entry->family->value(i)));
+                }
+            }
+            metric.insert(QStringLiteral("type"), QStringLiteral("counter"));
+            metric.insert(QStringLiteral("label"), entry->label);
+            metric.insert(QStringLiteral("values"), values);
+            break;
+        }
+        case Type::Gauge:
+            metric.insert(QStringLiteral("type"), QStringLiteral("gauge"));
+            metric.insert(QStringLiteral("value"), entry->gauge->value());
+            break;
+        case Type::Histogram: {
+            const auto& histogram = *entry->histogram;
+            QJsonObject quantiles;
+            for (const double quantile : QUANTILES) {
+                quantiles.insert(QString::number(quantile), double(histogram.percentile(quantile)) / 1e9);
+            }
+            metric.insert(QStringLiteral("type"), QStringLiteral("summary"));
+            metric.insert(QStringLiteral("count"), QString::number(histogram.count()));
+            metric.insert(QStringLiteral("sum"), double(histogram.sum()) / 1e9);
+            metric.insert(QStringLiteral("quantiles"), quantiles);
+            break;
+        }
+        }
+
+        metrics.append(metric);
+    }
+
+    // 64 bit counters are strings, JSON numbers would lose precision
+    return QJsonDocument(QJsonObject{{QStringLiteral("metrics"), metrics}}).toJson(QJsonDocument::Compact);
+}
+
+QByteArray ChatMetrics::toPrometheus() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    // Metrics with several label sets are written together under one header
+    std::vector<const Entry*> entries;
+    for (const auto& entry : m_entries) {
+        const auto position = std::find_if(entries.rbegin(), entries.rend(),
+                                           [&entry](const Entry* other) { return other->name == entry->name; });
+        entries.insert(position == entries.rend() ? entries.end() : position.base(), entry.get());
+    }
+
+    QString output;
+    QString lastName;
+    for (const auto* entry : entries) {
+        if (entry->name != lastName) {
+            const char* type = entry->type == Type::Gauge ? "gauge"
+                               : entry->type == Type::Histogram ? "summary" : "counter";
+            output += QStringLiteral("# HELP %1 %2\n# TYPE %1 %3\n").arg(entry->name, entry->help, QLatin1String(type));
+            lastName = entry->name;
+        }
+
+        switch (entry->type) {
+        case Type::Counter:
+            output += entry->name + labelSet(entry->labels) + QLatin1Char(' ') +
+                      QString::number(entry->counter->value()) + QLatin1Char('\n');
+            break;
+        case Type::CounterFamily:
+            for (int i = 0; i < entry->family->size(); ++i) {
+                const QString label = QStringLiteral("%1=\"%2\"").arg(entry->label, entry->family->valueName(i));
+                output += entry->name + labelSet(entry->labels, label) + QLatin1Char(' ') +
+                          QString::number(entry->family->value(i)) + QLatin1Char('\n');
+            }
+            break;
+        case Type::Gauge:
+            output += entry->name + labelSet(entry->labels) + QLatin1Char(' ') +
+                      QString::number(entry->gauge->value()) + QLatin1Char('\n');
+            break;
+        case Type::Histogram: {
+            const auto& histogram = *entry->histogram;
+            for (const double quantile : QUANTILES) {
+                const QString label = QStringLiteral("quantile=\"%1\"").arg(quantile);
+                output += entry->name + labelSet(entry->labels, label) + QLatin1Char(' ') +
+                          seconds(histogram.percentile(quantile)) + QLatin1Char('\n');
+            }
+            output += entry->name + QStringLiteral("_sum") + labelSet(entry->labels) + QLatin1Char(' ') +
+                      seconds(histogram.sum()) + QLatin1Char('\n');
+            output += entry->name + QStringLiteral("_count") + labelSet(entry->labels) + QLatin1Char(' ') +
+                      QString::number(histogram.count()) + QLatin1Char('\n');
+            break;
+        }
+        }
+    }
+
+    return output.toUtf8();
+}
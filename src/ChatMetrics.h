@@ -0,0 +1,185 @@
+/*
+ * ChatMetrics.h - declaration of ChatMetrics class
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+// Monotonic event count. Updates are single relaxed atomic additions.
+class ChatCounter
+{
+public:
+    void increment(quint64 count = 1) { m_value.fetch_add(count, std::memory_order_relaxed); }
+    quint64 value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<quint64> m_value{0};
+};
+
+// Counters of one metric told apart by a label with a fixed set of values,
+// e.g. feature messages by command. Indices outside the set count as "other".
+class ChatCounterFamily
+{
+public:
+    static constexpr int MaxValues = 32;
+
+    explicit ChatCounterFamily(const QStringList& values) :
+        m_values(values.mid(0, MaxValues - 1))
+    {
+    }
+
+    void increment(int index, quint64 count = 1)
+    {
+        m_counters[size_t(index >= 0 && index < m_values.size() ? index : m_values.size())].increment(count);
+    }
+
+    int size() const { return m_values.size() + 1; }
+    QString valueName(int index) const { return index < m_values.size() ? m_values[index] : QStringLiteral("other"); }
+    quint64 value(int index) const { return m_counters[size_t(index)].value(); }
+
+private:
+    const QStringList m_values;
+    std::array<ChatCounter, MaxValues> m_counters;
+};
+
+// Current level, e.g. a queue depth
+class ChatGauge
+{
+public:
+    void set(qint64 value) { m_value.store(value, std::memory_order_relaxed); }
+    void add(qint64 delta) { m_value.fetch_add(delta, std::memory_order_relaxed); }
+    qint64 value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<qint64> m_value{0};
+};
+
+// Durations in nanoseconds, kept HDR-style in log-linear buckets: each
+// power of two is split into 16 linear buckets, so any recorded value is
+// reported within 1/16 of its magnitude, from 1 ns up to about 18 minutes,
+// with a fixed array of atomic counters and no allocation when recording.
+class ChatHistogram
+{
+public:
+    static constexpr int SubBucketBits = 4;
+    static constexpr int SubBuckets = 1 << SubBucketBits;
+    static constexpr int MaxValueBits = 40;
+    static constexpr int BucketCount = SubBuckets * (MaxValueBits - SubBucketBits + 1);
+
+    void record(quint64 nanoseconds);
+
+    quint64 count() const { return m_count.load(std::memory_order_relaxed); }
+    quint64 sum() const { return m_sum.load(std::memory_order_relaxed); }
+    // Upper bound of the bucket holding the given fraction of all values
+    quint64 percentile(double fraction) const;
+
+private:
+    static int bucketIndex(quint64 value);
+    static quint64 bucketUpperBound(int index);
+
+    std::array<std::atomic<quint64>, BucketCount> m_buckets{};
+    std::atomic<quint64> m_count{0};
+    std::atomic<quint64> m_sum{0};
+};
+
+// Records the time from construction to destruction into a histogram
+class ChatMetricsTimer
+{
+public:
+    explicit ChatMetricsTimer(ChatHistogram& histogram) :
+        m_histogram(histogram),
+        m_start(std::chrono::steady_clock::now())
+    {
+    }
+
+    ~ChatMetricsTimer()
+    {
+        m_histogram.record(quint64(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                       std::chrono::steady_clock::now() - m_start).count()));
+    }
+
+    Q_DISABLE_COPY(ChatMetricsTimer)
+
+private:
+    ChatHistogram& m_histogram;
+    const std::chrono::steady_clock::time_point m_start;
+};
+
+// Process-wide registry. Metrics are registered once, usually into a
+// function-local static reference at the place they are updated, and stay
+// valid for the lifetime of the process; updating them takes no lock.
+// Registering the same name and labels again returns the same metric.
+// Labels are given in Prometheus syntax, e.g. pipeline="master".
+class ChatMetrics
+{
+public:
+    static ChatMetrics& instance();
+
+    ChatCounter& counter(const QString& name, const QString& help, const QString& labels = QString());
+    ChatCounterFamily& counterFamily(const QString& name, const QString& help,
+                                     const QString& label, const QStringList& values);
+    ChatGauge& gauge(const QString& name, const QString& help, const QString& labels = QString());
+    ChatHistogram& histogram(const QString& name, const QString& help, const QString& labels = QString());
+
+    // Snapshots; histograms are exported as summaries in seconds
+    QByteArray toJson() const;
+    QByteArray toPrometheus() const;
+
+private:
+    enum class Type
+    {
+        Counter,
+        CounterFamily,
+        Gauge,
+        Histogram
+    };
+
+    struct Entry
+    {
+        Type type;
+        QString name;
+        QString help;
+        QString labels;
+        QString label;
+        std::unique_ptr<ChatCounter> counter;
+        std::unique_ptr<ChatCounterFamily> family;
+        std::unique_ptr<ChatGauge> gauge;
+        std::unique_ptr<ChatHistogram> histogram;
+    };
+
+    ChatMetrics() = default;
+
+    Entry& entry(Type type, const QString& name, const QString& help, const QString& labels);
+
+    mutable QMutex m_mutex;
+    std::vector<std::unique_ptr<Entry>> m_entries;
+};
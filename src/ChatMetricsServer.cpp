@@ -0,0 +1,107 @@
+/*
+ * ChatMetricsServer.cpp - implementation of ChatMetricsServer class
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include "ChatMetricsServer.h"
+#include "ChatMetrics.h"
+
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QSettings>
+#include <QTimer>
+
+namespace {
+constexpr auto ORGANIZATION_NAME = "Veyon";
+constexpr auto SETTINGS_SOCKET = "metricsSocket";
+// Requests are single short lines
+constexpr qint64 MAX_REQUEST_SIZE = 64;
+constexpr int REQUEST_TIMEOUT = 500;
+constexpr int PROBE_TIMEOUT = 200;
+}
+
+ChatMetricsServer::ChatMetricsServer(const char* applicationName, const QString& defaultName, QObject* parent) :
+    QObject(parent),
+    m_server(new QLocalServer(this))
+{
+    const QSettings settings(ORGANIZATION_NAME, applicationName);
+    const QString name = settings.value(SETTINGS_SOCKET, defaultName).toString();
+    if (name.isEmpty()) {
+        return;
+    }
+
+    // Snapshots are readable by the user running the process only
+    m_server->setSocketOptions(QLocalServer::UserAccessOption);
+    connect(m_server, &QLocalServer::newConnection, this, &ChatMetricsServer::onNewConnection);
+
+    // A socket file left behind by a crashed process blocks the name. One
+    // that still answers belongs to a running process and is left alone.
+    if (!m_server->listen(name) && m_server->serverError() == QAbstractSocket::AddressInUseError) {
+        QLocalSocket probe;
+        probe.connectToServer(name);
+        if (probe.waitForConnected(PROBE_TIMEOUT)) {
+            probe.abort();
+            return;
+        }
+
+        QLocalServer::removeServer(name);
+        m_server->listen(name);
+    }
+}
+
+bool ChatMetricsServer::isListening() const
+{
+    return m_server->isListening();
+}
+
+QString ChatMetricsServer::serverName() const
+{
+    return m_server->fullServerName();
+}
+
+void ChatMetricsServer::onNewConnection()
+{
+    while (auto* socket = m_server->nextPendingConnection()) {
+        connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+
+        connect(socket, &QLocalSocket::readyRead, this, [this, socket]() {
+            if (socket->canReadLine() || socket->bytesAvailable() >= MAX_REQUEST_SIZE) {
+                respond(socket, socket->readLine(MAX_REQUEST_SIZE).trimmed());
+            }
+        });
+
+        QTimer::singleShot(REQUEST_TIMEOUT, socket, [this, socket]() {
+            respond(socket, QByteArray());
+        });
+    }
+}
+
+void ChatMetricsServer::respond(QLocalSocket* socket, const QByteArray& request)
+{
+    // Answered once, by whichever of request and timeout comes first
+    if (socket->state() != QLocalSocket::ConnectedState) {
+        return;
+    }
+
+    socket->write(request == "json" ? ChatMetrics::instance().toJson() : ChatMetrics::instance().toPrometheus());
+    socket->disconnectFromServer();
+}
@@ -0,0 +1,58 @@
+/*
+ * ChatMetricsServer.h - declaration of ChatMetricsServer class
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QString>
+
+class QLocalServer;
+class QLocalSocket;
+
+// Serves snapshots of the metrics registry on a local socket. A client
+// sends one line, "json" or "prometheus", and receives the snapshot in
+// that format before the connection is closed; clients which send nothing
+// get Prometheus text after a short wait, e.g.
+//
+//   socat - UNIX-CONNECT:/tmp/veyon-chat-master-metrics
+class ChatMetricsServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    // The socket name is read from the metricsSocket setting of the given
+    // application, an empty setting disables the server
+    ChatMetricsServer(const char* applicationName, const QString& defaultName, QObject* parent = nullptr);
+
+    bool isListening() const;
+    QString serverName() const;
+
+private slots:
+    void onNewConnection();
+
+private:
+    void respond(QLocalSocket* socket, const QByteArray& request);
+
+    QLocalServer* m_server;
+};
@@ -0,0 +1,82 @@
+/*
+ * ChatNotificationAggregator.cpp - implementation of ChatNotificationAggregator class
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include "ChatNotificationAggregator.h"
+#include <QTimer>
+
+namespace {
+constexpr int DEFAULT_WINDOW = 2000;
+}
+
+ChatNotificationAggregator::ChatNotificationAggregator(QObject* parent) :
+    QObject(parent),
+    m_windowTimer(new QTimer(this)),
+    m_messageCount(0)
+{
+    m_windowTimer->setSingleShot(true);
+    m_windowTimer->setInterval(DEFAULT_WINDOW);
+    connect(m_windowTimer, &QTimer::timeout, this, &ChatNotificationAggregator::flush);
+}
+
+void ChatNotificationAggregator::setWindow(int window)
+{
+    m_windowTimer->setInterval(window);
+}
+
+void ChatNotificationAggregator::notify(const QString& sender, ChatMessage::Priority priority)
+{
+    if (priority == ChatMessage::Priority::Urgent) {
+        emit digestReady(1, QStringList{sender}, true);
+        return;
+    }
+
+    ++m_messageCount;
+    m_senders.insert(sender);
+
+    // The window opens with the first message and is not extended by later
+    // ones, so a steady stream still produces a digest every window
+    if (!m_windowTimer->isActive()) {
+        m_windowTimer->start();
+    }
+}
+
+void ChatNotificationAggregator::clear()
+{
+    m_windowTimer->stop();
+    m_messageCount = 0;
+    m_senders.clear();
+}
+
+void ChatNotificationAggregator::flush()
+{
+    if (m_messageCount == 0) {
+        return;
+    }
+
+    const int messageCount = m_messageCount;
+    const QStringList senders = m_senders.values();
+    clear();
+
+    emit digestReady(messageCount, senders, false);
+}
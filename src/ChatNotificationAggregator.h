@@ -0,0 +1,58 @@
+/*
+ * ChatNotificationAggregator.h - declaration of ChatNotificationAggregator class
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include "ChatMessage.h"
+
+class QTimer;
+
+// Coalesces message alerts arriving within a short window into a single
+// digest so that a burst of messages causes one tray popup and one sound.
+// Urgent messages are reported immediately.
+class ChatNotificationAggregator : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ChatNotificationAggregator(QObject* parent = nullptr);
+
+    void setWindow(int window);
+    void notify(const QString& sender, ChatMessage::Priority priority);
+    void clear();
+
+signals:
+    void digestReady(int messageCount, const QStringList& senders, bool urgent);
+
+private slots:
+    void flush();
+
+private:
+    QTimer* m_windowTimer;
+    int m_messageCount;
+    QSet<QString> m_senders;
+};
@@ -0,0 +1,122 @@
+/*
+ * ChatOutbox.cpp - implementation of ChatOutbox class
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include "ChatOutbox.h"
+#include <QFile>
+#include <QJsonDocument>
+#include <QSaveFile>
+
+#include <algorithm>
+
+namespace {
+constexpr auto KEY_SEQUENCE = "sequence";
+constexpr auto KEY_COMMAND = "command";
+constexpr auto KEY_ARGUMENTS = "arguments";
+
+QJsonObject toJson(const ChatOutbox::Entry& entry)
+{
+    return QJsonObject{
+        {QLatin1String(KEY_SEQUENCE), QString::number(entry.sequence)},
+        {QLatin1String(KEY_COMMAND), entry.command},
+        {QLatin1String(KEY_ARGUMENTS), entry.arguments}
+    };
+}
+}
+
+ChatOutbox::ChatOutbox(const QString& fileName) :
+    m_fileName(fileName),
+    m_nextSequence(1)
+{
+    load();
+}
+
+quint64 ChatOutbox::enqueue(int command, const QJsonObject& arguments, bool supersede)
+{
+    if (supersede) {
+        m_entries.erase(std::remove_if(m_entries.begin(), m_entries.end(),
+                                       [command](const Entry& entry) { return entry.command == command; }),
+                        m_entries.end());
+    }
+
+    const quint64 sequence = m_nextSequence++;
+    m_entries.append(Entry{sequence, command, arguments});
+    save();
+
+    return sequence;
+}
+
+QJsonArray ChatOutbox::batch() const
+{
+    QJsonArray entries;
+    for (const auto& entry : m_entries) {
+        entries.append(toJson(entry));
+    }
+
+    return entries;
+}
+
+void ChatOutbox::clear()
+{
+    m_entries.clear();
+    QFile::remove(m_fileName);
+}
+
+void ChatOutbox::load()
+{
+    QFile file(m_fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    const QJsonArray entries = QJsonDocument::fromJson(file.readAll()).array();
+    for (const auto& value : entries) {
+        const QJsonObject object = value.toObject();
+
+        // Sequence numbers are stored as strings, JSON numbers are doubles
+        Entry entry{object.value(QLatin1String(KEY_SEQUENCE)).toString().toULongLong(),
+                    object.value(QLatin1String(KEY_COMMAND)).toInt(),
+                    object.value(QLatin1String(KEY_ARGUMENTS)).toObject()};
+        if (entry.sequence == 0) {
+            continue;
+        }
+
+        m_entries.append(entry);
+        m_nextSequence = qMax(m_nextSequence, entry.sequence + 1);
+    }
+}
+
+void ChatOutbox::save() const
+{
+    QJsonArray entries;
+    for (const auto& entry : m_entries) {
+        entries.append(toJson(entry));
+    }
+
+    // Never leave a half written queue behind
+    QSaveFile file(m_fileName);
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(QJsonDocument(entries).toJson(QJsonDocument::Compact));
+        file.commit();
+    }
+}
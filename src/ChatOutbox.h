@@ -0,0 +1,67 @@
+/*
+ * ChatOutbox.h - declaration of ChatOutbox class
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#pragma once
+
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QString>
+#include <QVector>
+
+// Store-and-forward queue for feature messages a student sends while there
+// is no connection to the master. Entries are numbered, written through to
+// a local file so they survive a worker restart, and handed out in one
+// batch once the connection is back.
+class ChatOutbox
+{
+public:
+    struct Entry
+    {
+        quint64 sequence;
+        int command;
+        QJsonObject arguments;
+    };
+
+    explicit ChatOutbox(const QString& fileName);
+
+    bool isEmpty() const { return m_entries.isEmpty(); }
+    int size() const { return m_entries.size(); }
+
+    // With supersede set, queued entries of the same command are dropped,
+    // e.g. for status updates where only the latest one matters
+    quint64 enqueue(int command, const QJsonObject& arguments, bool supersede = false);
+
+    // All entries, serialized as {sequence, command, arguments} objects. They
+    // stay queued until clear() is called once the batch has been sent.
+    QJsonArray batch() const;
+    void clear();
+
+private:
+    void load();
+    void save() const;
+
+    QString m_fileName;
+    QVector<Entry> m_entries;
+    quint64 m_nextSequence;
+};
@@ -0,0 +1,118 @@
+/*
+ * ChatPresenceTracker.cpp - implementation of ChatPresenceTracker class
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include "ChatPresenceTracker.h"
+#include "ChatTimerWheel.h"
+#include <QTimer>
+
+namespace {
+// 250 ms ticks, 64 slots per level: 16 s, 17 min and 18 h spans
+constexpr int WHEEL_TICK = 250;
+constexpr int WHEEL_SLOTS = 64;
+constexpr int WHEEL_LEVELS = 3;
+// Batch touches arriving in a burst into one status update
+constexpr int FLUSH_DELAY = 100;
+}
+
+ChatPresenceTracker::ChatPresenceTracker(QObject* parent) :
+    QObject(parent),
+    m_deadlines(new ChatTimerWheel(WHEEL_TICK, WHEEL_SLOTS, WHEEL_LEVELS, this)),
+    m_flushTimer(new QTimer(this)),
+    m_awayTimeout(3 * ChatSession::HeartbeatInterval),
+    m_offlineTimeout(9 * ChatSession::HeartbeatInterval)
+{
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(FLUSH_DELAY);
+
+    connect(m_deadlines, &ChatTimerWheel::expired, this, &ChatPresenceTracker::onDeadlinesExpired);
+    connect(m_flushTimer, &QTimer::timeout, this, &ChatPresenceTracker::flush);
+}
+
+void ChatPresenceTracker::touch(const QString& clientId)
+{
+    m_deadlines->schedule(clientId, m_awayTimeout);
+    setStatus(clientId, ChatSession::ClientStatus::Online);
+
+    if (!m_pendingChanges.isEmpty() && !m_flushTimer->isActive()) {
+        m_flushTimer->start();
+    }
+}
+
+void ChatPresenceTracker::forget(const QString& clientId)
+{
+    m_deadlines->cancel(clientId);
+    m_states.remove(clientId);
+    m_pendingChanges.remove(clientId);
+}
+
+void ChatPresenceTracker::setTimeouts(int awayTimeout, int offlineTimeout)
+{
+    m_awayTimeout = awayTimeout;
+    m_offlineTimeout = qMax(awayTimeout, offlineTimeout);
+}
+
+ChatSession::ClientStatus ChatPresenceTracker::status(const QString& clientId) const
+{
+    return m_states.value(clientId, ChatSession::ClientStatus::Offline);
+}
+
+void ChatPresenceTracker::onDeadlinesExpired(const QStringList& clientIds)
+{
+    for (const QString& clientId : clientIds) {
+        if (status(clientId) == ChatSession::ClientStatus::Online) {
+            setStatus(clientId, ChatSession::ClientStatus::Away);
+            m_deadlines->schedule(clientId, m_offlineTimeout - m_awayTimeout);
+        } else {
+            setStatus(clientId, ChatSession::ClientStatus::Offline);
+        }
+    }
+
+    // Expiries already arrive batched per wheel tick
+    flush();
+}
+
+void ChatPresenceTracker::flush()
+{
+    m_flushTimer->stop();
+
+    if (m_pendingChanges.isEmpty()) {
+        return;
+    }
+
+    const StatusChanges changes = m_pendingChanges;
+    m_pendingChanges.clear();
+
+    emit statusesChanged(changes);
+}
+
+void ChatPresenceTracker::setStatus(const QString& clientId, ChatSession::ClientStatus status)
+{
+    const auto it = m_states.find(clientId);
+    if (it != m_states.end() && it.value() == status) {
+        return;
+    }
+
+    m_states.insert(clientId, status);
+    m_pendingChanges.insert(clientId, status);
+}
@@ -0,0 +1,69 @@
+/*
+ * ChatPresenceTracker.h - declaration of ChatPresenceTracker class
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#pragma once
+
+#include <QHash>
+#include <QObject>
+#include "ChatSession.h"
+
+class ChatTimerWheel;
+class QTimer;
+
+// Tracks when each client was last heard of. Every heartbeat or other
+// incoming traffic moves a client back to Online, silence moves it to Away
+// and later to Offline. All deadlines share one hierarchical timer wheel and
+// transitions are reported in batches.
+class ChatPresenceTracker : public QObject
+{
+    Q_OBJECT
+
+public:
+    using StatusChanges = QHash<QString, ChatSession::ClientStatus>;
+
+    explicit ChatPresenceTracker(QObject* parent = nullptr);
+
+    void touch(const QString& clientId);
+    void forget(const QString& clientId);
+
+    void setTimeouts(int awayTimeout, int offlineTimeout);
+    ChatSession::ClientStatus status(const QString& clientId) const;
+
+signals:
+    void statusesChanged(const ChatPresenceTracker::StatusChanges& changes);
+
+private slots:
+    void onDeadlinesExpired(const QStringList& clientIds);
+    void flush();
+
+private:
+    void setStatus(const QString& clientId, ChatSession::ClientStatus status);
+
+    ChatTimerWheel* m_deadlines;
+    QTimer* m_flushTimer;
+    int m_awayTimeout;
+    int m_offlineTimeout;
+    QHash<QString, ChatSession::ClientStatus> m_states;
+    StatusChanges m_pendingChanges;
+};
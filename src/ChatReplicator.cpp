@@ -0,0 +1,447 @@
+/*
+ * ChatReplicator.cpp - implementation of ChatReplicator class
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include "ChatReplicator.h"
+
+#include <QHostAddress>
+#include <QHostInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSettings>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QUuid>
+#include <QtEndian>
+
+namespace {
+constexpr auto ORGANIZATION_NAME = "Veyon";
+constexpr auto APPLICATION_NAME = "ChatMaster";
+constexpr auto SETTINGS_PORT = "replicationPort";
+constexpr auto SETTINGS_PEERS = "replicationPeers";
+constexpr auto PORT_VARIABLE = "VEYON_CHAT_REPLICATION_PORT";
+constexpr auto PEERS_VARIABLE = "VEYON_CHAT_REPLICATION_PEERS";
+constexpr quint16 DEFAULT_PORT = 29666;
+constexpr int RECONNECT_INTERVAL = 5000;
+// Also repairs anything lost in flight when a connection dropped
+constexpr int ANTI_ENTROPY_INTERVAL = 30000;
+constexpr quint32 MAX_FRAME_SIZE = 16 * 1024 * 1024;
+// Peers further behind than the log reaches miss the trimmed operations
+constexpr int MAX_LOG_SIZE = 50000;
+constexpr int LOG_TRIM = 10000;
+// A replay answering the first request is usually still on its way
+constexpr int GAP_REQUEST_INTERVAL = 1000;
+
+const QString TYPE_KEY = QStringLiteral("type");
+const QString HELLO_TYPE = QStringLiteral("hello");
+const QString MESSAGE_TYPE = QStringLiteral("message");
+const QString READ_TYPE = QStringLiteral("read");
+const QString CLEAR_TYPE = QStringLiteral("clear");
+const QString ORIGIN_KEY = QStringLiteral("origin");
+const QString COUNTER_KEY = QStringLiteral("counter");
+const QString CLIENT_ID_KEY = QStringLiteral("clientId");
+const QString MESSAGE_KEY = QStringLiteral("message");
+const QString REPLICA_KEY = QStringLiteral("replica");
+const QString VECTOR_KEY = QStringLiteral("vector");
+}
+
+ChatReplicator::ChatReplicator(QObject* parent) :
+    QObject(parent),
+    m_enabled(false),
+    m_replicaId(QUuid::createUuid().toString(QUuid::WithoutBraces)),
+    m_counter(0),
+    m_server(nullptr),
+    m_connectTimer(new QTimer(this)),
+    m_antiEntropyTimer(new QTimer(this))
+{
+    m_connectTimer->setInterval(RECONNECT_INTERVAL);
+    connect(m_connectTimer, &QTimer::timeout, this, &ChatReplicator::connectPeers);
+
+    m_antiEntropyTimer->setInterval(ANTI_ENTROPY_INTERVAL);
+    connect(m_antiEntropyTimer, &QTimer::timeout, this, &ChatReplicator::exchangeVectors);
+
+    loadSettings();
+}
+
+ChatReplicator::~ChatReplicator()
+{
+    // Sockets are children, only stop them from calling back during teardown
+    for (auto it = m_peers.constBegin(); it != m_peers.constEnd(); ++it) {
+        it.key()->disconnect(this);
+    }
+}
+
+void ChatReplicator::loadSettings()
+{
+    const QSettings settings(ORGANIZATION_NAME, APPLICATION_NAME);
+
+    int port = settings.value(SETTINGS_PORT, 0).toInt();
+    if (qEnvironmentVariableIsSet(PORT_VARIABLE)) {
+        port = qEnvironmentVariableIntValue(PORT_VARIABLE);
+    }
+
+    QStringList peers = settings.value(SETTINGS_PEERS).toStringList();
+    if (qEnvironmentVariableIsSet(PEERS_VARIABLE)) {
+        peers = qEnvironmentVariable(PEERS_VARIABLE).split(QLatin1Char(','), Qt::SkipEmptyParts);
+    }
+
+    for (const auto& peer : qAsConst(peers)) {
+        const int separator = peer.lastIndexOf(QLatin1Char(':'));
+        PeerAddress address;
+        address.host = (separator > 0 ? peer.left(separator) : peer).trimmed();
+        address.port = separator > 0 ? quint16(peer.mid(separator + 1).toUInt()) : DEFAULT_PORT;
+        address.socket = nullptr;
+        if (address.host.isEmpty() || address.port == 0) {
+            continue;
+        }
+        m_peerAddresses.append(address);
+
+        // Only configured peers may connect to this master
+        QHostInfo::lookupHost(address.host, this, [this](const QHostInfo& hostInfo) {
+            for (const auto& hostAddress : hostInfo.addresses()) {
+                m_allowedAddresses.insert(hostAddress.toString());
+            }
+        });
+    }
+
+    if (port > 0 && port <= 0xFFFF) {
+        m_server = new QTcpServer(this);
+        connect(m_server, &QTcpServer::newConnection, this, &ChatReplicator::onNewConnection);
+        m_server->listen(QHostAddress::Any, quint16(port));
+    }
+
+    m_enabled = m_server || !m_peerAddresses.isEmpty();
+    if (!m_enabled) {
+        return;
+    }
+
+    m_antiEntropyTimer->start();
+    if (!m_peerAddresses.isEmpty()) {
+        m_connectTimer->start();
+        connectPeers();
+    }
+}
+
+void ChatReplicator::recordMessage(const QString& clientId, const ChatMessage& message)
+{
+    record({{TYPE_KEY, MESSAGE_TYPE}, {CLIENT_ID_KEY, clientId}, {MESSAGE_KEY, message.toJson()}},
+           clientId, message.messageId());
+}
+
+// The session holds what the vector covers: local messages are recorded and
+// remote ones merged before they show up there
+void ChatReplicator::recordRead(const QString& clientId)
+{
+    record({{TYPE_KEY, READ_TYPE}, {CLIENT_ID_KEY, clientId}, {VECTOR_KEY, vectorToJson()}});
+}
+
+void ChatReplicator::recordClear(const QString& clientId)
+{
+    record({{TYPE_KEY, CLEAR_TYPE}, {CLIENT_ID_KEY, clientId}, {VECTOR_KEY, vectorToJson()}});
+}
+
+void ChatReplicator::record(QJsonObject&& operation, const QString& clientId, const QString& messageId)
+{
+    if (!m_enabled) {
+        return;
+    }
+
+    // Counters are strings, JSON numbers are doubles
+    operation.insert(ORIGIN_KEY, m_replicaId);
+    operation.insert(COUNTER_KEY, QString::number(++m_counter));
+    m_vector.insert(m_replicaId, m_counter);
+
+    const QByteArray frame = encodeFrame(operation);
+    append({m_replicaId, m_counter, frame, clientId, messageId});
+
+    for (auto it = m_peers.constBegin(); it != m_peers.constEnd(); ++it) {
+        if (it->ready) {
+            it.key()->write(frame);
+        }
+    }
+}
+
+void ChatReplicator::onNewConnection()
+{
+    while (auto* socket = m_server->nextPendingConnection()) {
+        const QHostAddress peerAddress = socket->peerAddress();
+        if (!isAllowed(peerAddress)) {
+            socket->abort();
+            socket->deleteLater();
+            continue;
+        }
+
+        socket->setParent(this);
+        addSocket(socket);
+        sendHello(socket);
+    }
+}
+
+void ChatReplicator::connectPeers()
+{
+    for (auto& address : m_peerAddresses) {
+        if (address.socket) {
+            continue;
+        }
+
+        address.socket = new QTcpSocket(this);
+        addSocket(address.socket);
+        connect(address.socket, &QTcpSocket::connected, this, [this, socket = address.socket]() {
+            sendHello(socket);
+        });
+        address.socket->connectToHost(address.host, address.port);
+    }
+}
+
+void ChatReplicator::exchangeVectors()
+{
+    for (auto it = m_peers.constBegin(); it != m_peers.constEnd(); ++it) {
+        if (it.key()->state() == QAbstractSocket::ConnectedState) {
+            sendHello(it.key());
+        }
+    }
+}
+
+void ChatReplicator::addSocket(QTcpSocket* socket)
+{
+    m_peers.insert(socket, Peer());
+
+    connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { readFrames(socket); });
+
+    // Failed connection attempts never emit disconnected()
+    connect(socket, &QTcpSocket::stateChanged, this, [this, socket](QAbstractSocket::SocketState state) {
+        if (state == QAbstractSocket::UnconnectedState) {
+            removeSocket(socket);
+        }
+    });
+}
+
+void ChatReplicator::removeSocket(QTcpSocket* socket)
+{
+    if (!m_peers.remove(socket)) {
+        return;
+    }
+
+    // Outgoing connections are retried by the reconnect timer
+    for (auto& address : m_peerAddresses) {
+        if (address.socket == socket) {
+            address.socket = nullptr;
+        }
+    }
+
+    socket->disconnect(this);
+    socket->deleteLater();
+}
+
+void ChatReplicator::readFrames(QTcpSocket* socket)
+{
+    auto it = m_peers.find(socket);
+    if (it == m_peers.end()) {
+        return;
+    }
+
+    it->buffer.append(socket->readAll());
+
+    int offset = 0;
+    while (it->buffer.size() - offset >= int(sizeof(quint32))) {
+        const quint32 size = qFromBigEndian<quint32>(it->buffer.constData() + offset);
+        if (size > MAX_FRAME_SIZE) {
+            socket->abort();
+            return;
+        }
+
+        if (quint32(it->buffer.size() - offset) - sizeof(quint32) < size) {
+            break;
+        }
+
+        const QByteArray frame = it->buffer.mid(offset, int(sizeof(quint32) + size));
+        offset += frame.size();
+        handleFrame(socket, frame);
+
+        // Handling may have aborted the connection
+        it = m_peers.find(socket);
+        if (it == m_peers.end()) {
+            return;
+        }
+    }
+
+    it->buffer.remove(0, offset);
+}
+
+void ChatReplicator::handleFrame(QTcpSocket* socket, const QByteArray& frame)
+{
+    const auto document = QJsonDocument::fromJson(frame.mid(int(sizeof(quint32))));
+    if (!document.isObject()) {
+        return;
+    }
+
+    const QJsonObject object = document.object();
+    const QString type = object.value(TYPE_KEY).toString();
+
+    if (type != HELLO_TYPE) {
+        apply(socket, object, frame);
+        return;
+    }
+
+    if (object.value(REPLICA_KEY).toString() == m_replicaId) {
+        // Connected to ourselves, e.g. via a peer list shared by all masters
+        socket->abort();
+        return;
+    }
+
+    // Send whatever the peer's vector does not cover, in log order so each
+    // master's operations arrive in the order they were made
+    const QJsonObject vector = object.value(VECTOR_KEY).toObject();
+    for (const auto& operation : qAsConst(m_log)) {
+        if (operation.counter > vector.value(operation.origin).toString().toULongLong()) {
+            socket->write(operation.frame);
+        }
+    }
+
+    m_peers[socket].ready = true;
+}
+
+void ChatReplicator::sendHello(QTcpSocket* socket)
+{
+    socket->write(encodeFrame({{TYPE_KEY, HELLO_TYPE}, {REPLICA_KEY, m_replicaId}, {VECTOR_KEY, vectorToJson()}}));
+}
+
+void ChatReplicator::apply(QTcpSocket* source, const QJsonObject& operation, const QByteArray& frame)
+{
+    const QString origin = operation.value(ORIGIN_KEY).toString();
+    const quint64 counter = operation.value(COUNTER_KEY).toString().toULongLong();
+    if (origin.isEmpty() || counter <= m_vector.value(origin)) {
+        return;
+    }
+
+    const QString type = operation.value(TYPE_KEY).toString();
+    const bool isWatermark = type == READ_TYPE || type == CLEAR_TYPE;
+    if (counter != m_vector.value(origin) + 1 ||
+        (isWatermark && !covers(operation.value(VECTOR_KEY).toObject()))) {
+        requestMissing(source);
+        return;
+    }
+
+    const QString clientId = operation.value(CLIENT_ID_KEY).toString();
+    const ChatMessage message = type == MESSAGE_TYPE ?
+                                    ChatMessage::fromJson(operation.value(MESSAGE_KEY).toObject()) : ChatMessage();
+
+    m_vector.insert(origin, counter);
+    append({origin, counter, frame, type == MESSAGE_TYPE ? clientId : QString(), message.messageId()});
+
+    // Relay, so masters which only know one of the others still converge
+    for (auto it = m_peers.constBegin(); it != m_peers.constEnd(); ++it) {
+        if (it->ready && it.key() != source) {
+            it.key()->write(frame);
+        }
+    }
+
+    if (type == MESSAGE_TYPE) {
+        emit messageMerged(clientId, message);
+    } else if (type == READ_TYPE) {
+        emit readMerged(clientId, coveredMessages(clientId, operation.value(VECTOR_KEY).toObject()));
+    } else if (type == CLEAR_TYPE) {
+        emit clearMerged(clientId, coveredMessages(clientId, operation.value(VECTOR_KEY).toObject()));
+    }
+}
+
+bool ChatReplicator::covers(const QJsonObject& vector) const
+{
+    for (auto it = vector.constBegin(); it != vector.constEnd(); ++it) {
+        if (it.value().toString().toULongLong() > m_vector.value(it.key())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ChatReplicator::requestMissing(QTcpSocket* source)
+{
+    auto it = m_peers.find(source);
+    if (it == m_peers.end() || source->state() != QAbstractSocket::ConnectedState) {
+        return;
+    }
+
+    if (!it->gapRequest.isValid() || it->gapRequest.hasExpired(GAP_REQUEST_INTERVAL)) {
+        it->gapRequest.start();
+        sendHello(source);
+    }
+}
+
+void ChatReplicator::append(Operation&& operation)
+{
+    if (m_log.size() >= MAX_LOG_SIZE) {
+        m_log.remove(0, LOG_TRIM);
+    }
+    m_log.append(std::move(operation));
+}
+
+QStringList ChatReplicator::coveredMessages(const QString& clientId, const QJsonObject& vector) const
+{
+    // Messages to all sessions count for every client. Trimmed operations
+    // are no longer resolved, which leaves only very old messages untouched.
+    QStringList messageIds;
+    for (const auto& operation : qAsConst(m_log)) {
+        if (operation.messageId.isEmpty() ||
+            (!operation.clientId.isEmpty() && operation.clientId != clientId)) {
+            continue;
+        }
+        if (operation.counter <= vector.value(operation.origin).toString().toULongLong()) {
+            messageIds.append(operation.messageId);
+        }
+    }
+    return messageIds;
+}
+
+QJsonObject ChatReplicator::vectorToJson() const
+{
+    // Counters are strings, JSON numbers are doubles
+    QJsonObject vector;
+    for (auto it = m_vector.constBegin(); it != m_vector.constEnd(); ++it) {
+        vector.insert(it.key(), QString::number(it.value()));
+    }
+    return vector;
+}
+
+bool ChatReplicator::isAllowed(const QHostAddress& address) const
+{
+    if (address.isLoopback()) {
+        return true;
+    }
+
+    // IPv4 peers may show up as IPv4-mapped IPv6 addresses
+    bool isIPv4 = false;
+    const quint32 ipv4 = address.toIPv4Address(&isIPv4);
+    return m_allowedAddresses.contains(isIPv4 ? QHostAddress(ipv4).toString() : address.toString());
+}
+
+QByteArray ChatReplicator::encodeFrame(const QJsonObject& object)
+{
+    const QByteArray payload = QJsonDocument(object).toJson(QJsonDocument::Compact);
+
+    QByteArray frame(int(sizeof(quint32)), Qt::Uninitialized);
+    qToBigEndian<quint32>(quint32(payload.size()), frame.data());
+    frame.append(payload);
+    return frame;
+}
@@ -0,0 +1,138 @@
+/*
+ * ChatReplicator.h - declaration of ChatReplicator class
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+
+#include "ChatMessage.h"
+
+class QHostAddress;
+class QTcpServer;
+class QTcpSocket;
+class QTimer;
+
+// Keeps the chat sessions of several masters in the same classroom in sync.
+// Every local change becomes an operation numbered per master; peers
+// exchange version vectors (the highest number seen from each master) and
+// send each other only the operations the other side is missing, so the
+// traffic follows the changes rather than the history. Messages are merged
+// by id; a read or clear carries the vector of its master at that time and
+// covers exactly the messages that vector includes, so no wall clocks are
+// compared. Operations of one master are applied strictly in its order, and
+// a read or clear only once everything its vector covers has been applied.
+// Anything arriving ahead of that, e.g. a live operation overtaking a replay
+// on another connection, is dropped and the sender asked for what is missing,
+// which it sends in order.
+//
+// Replication is off unless replicationPort or replicationPeers is set in
+// the ChatMaster settings. VEYON_CHAT_REPLICATION_PORT and
+// VEYON_CHAT_REPLICATION_PEERS override them, e.g. for two masters on one
+// machine.
+class ChatReplicator : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ChatReplicator(QObject* parent = nullptr);
+    ~ChatReplicator() override;
+
+    bool isEnabled() const { return m_enabled; }
+
+    // Local changes, an empty client id stands for all sessions
+    void recordMessage(const QString& clientId, const ChatMessage& message);
+    void recordRead(const QString& clientId);
+    void recordClear(const QString& clientId);
+
+signals:
+    void messageMerged(const QString& clientId, const ChatMessage& message);
+    void readMerged(const QString& clientId, const QStringList& messageIds);
+    void clearMerged(const QString& clientId, const QStringList& messageIds);
+
+private slots:
+    void onNewConnection();
+    void connectPeers();
+    void exchangeVectors();
+
+private:
+    struct Operation
+    {
+        QString origin;
+        quint64 counter;
+        // Length-prefixed, encoded once and forwarded as is
+        QByteArray frame;
+        // Set for messages only, reads and clears are resolved to these
+        QString clientId;
+        QString messageId;
+    };
+
+    struct Peer
+    {
+        QByteArray buffer;
+        bool ready = false;
+        // Hellos asking to fill a gap, at most one per interval
+        QElapsedTimer gapRequest;
+    };
+
+    struct PeerAddress
+    {
+        QString host;
+        quint16 port;
+        QTcpSocket* socket;
+    };
+
+    void loadSettings();
+    void addSocket(QTcpSocket* socket);
+    void removeSocket(QTcpSocket* socket);
+    void readFrames(QTcpSocket* socket);
+    void handleFrame(QTcpSocket* socket, const QByteArray& frame);
+    void sendHello(QTcpSocket* socket);
+    void record(QJsonObject&& operation, const QString& clientId = {}, const QString& messageId = {});
+    void apply(QTcpSocket* source, const QJsonObject& operation, const QByteArray& frame);
+    bool covers(const QJsonObject& vector) const;
+    void requestMissing(QTcpSocket* source);
+    void append(Operation&& operation);
+    QStringList coveredMessages(const QString& clientId, const QJsonObject& vector) const;
+    QJsonObject vectorToJson() const;
+    bool isAllowed(const QHostAddress& address) const;
+    static QByteArray encodeFrame(const QJsonObject& object);
+
+    bool m_enabled;
+    const QString m_replicaId;
+    quint64 m_counter;
+    QHash<QString, quint64> m_vector;
+    QVector<Operation> m_log;
+
+    QTcpServer* m_server;
+    QTimer* m_connectTimer;
+    QTimer* m_antiEntropyTimer;
+    QVector<PeerAddress> m_peerAddresses;
+    QSet<QString> m_allowedAddresses;
+    QHash<QTcpSocket*, Peer> m_peers;
+};
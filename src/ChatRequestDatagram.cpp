@@ -0,0 +1,108 @@
+#include "ChatRequestDatagram.h"
+
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+constexpr int MAGIC_OFFSET = 0;
+constexpr int VERSION_OFFSET = 4;
+constexpr int HOST_LENGTH_OFFSET = 5;
+constexpr int USER_LENGTH_OFFSET = 6;
+constexpr int TIMESTAMP_OFFSET = 8;
+constexpr int HOST_OFFSET = 16;
+constexpr int USER_OFFSET = HOST_OFFSET + ChatRequestDatagram::HostSize;
+constexpr int REQUEST_ID_OFFSET = ChatRequestDatagram::MinimumSize;
+constexpr int ACK_REQUEST_ID_OFFSET = 8;
+
+QByteArray truncatedUtf8(const QString& text, int maxSize)
+{
+    QByteArray utf8 = text.toUtf8();
+    if (utf8.size() <= maxSize) {
+        return utf8;
+    }
+
+    // Never cut a multi-byte sequence in half
+    int size = maxSize;
+    while (size > 0 && (quint8(utf8.at(size)) & 0xC0) == 0x80) {
+        --size;
+    }
+    utf8.truncate(size);
+    return utf8;
+}
+}
+
+QByteArray ChatRequestDatagram::encode(const QString& host, const QString& user)
+{
+    QByteArray datagram(Size, '\0');
+    char* data = datagram.data();
+
+    const QByteArray hostUtf8 = truncatedUtf8(host, HostSize);
+    const QByteArray userUtf8 = truncatedUtf8(user, UserSize);
+
+    qToBigEndian<quint32>(Magic, data + MAGIC_OFFSET);
+    data[VERSION_OFFSET] = char(Version);
+    data[HOST_LENGTH_OFFSET] = char(hostUtf8.size());
+    data[USER_LENGTH_OFFSET] = char(userUtf8.size());
+    memcpy(data + HOST_OFFSET, hostUtf8.constData(), size_t(hostUtf8.size()));
+    memcpy(data + USER_OFFSET, userUtf8.constData(), size_t(userUtf8.size()));
+
+    return datagram;
+}
+
+void ChatRequestDatagram::setTimestamp(QByteArray& datagram, qint64 timestamp)
+{
+    if (datagram.size() >= Size) {
+        qToBigEndian<qint64>(timestamp, datagram.data() + TIMESTAMP_OFFSET);
+    }
+}
+
+void ChatRequestDatagram::setRequestId(QByteArray& datagram, quint32 requestId)
+{
+    if (datagram.size() >= Size) {
+        qToBigEndian<quint32>(requestId, datagram.data() + REQUEST_ID_OFFSET);
+    }
+}
+
+bool ChatRequestDatagram::isDatagram(const char* data, qint64 size)
+{
+    return size >= MinimumSize && qFromBigEndian<quint32>(data + MAGIC_OFFSET) == Magic;
+}
+
+bool ChatRequestDatagram::decode(const char* data, qint64 size, ChatRequestDatagram& request)
+{
+    const quint8 version = isDatagram(data, size) ? quint8(data[VERSION_OFFSET]) : 0;
+    if (version < 1) {
+        return false;
+    }
+
+    const int hostLength = qMin<int>(quint8(data[HOST_LENGTH_OFFSET]), HostSize);
+    const int userLength = qMin<int>(quint8(data[USER_LENGTH_OFFSET]), UserSize);
+
+    request.host = QString::fromUtf8(data + HOST_OFFSET, hostLength);
+    request.user = QString::fromUtf8(data + USER_OFFSET, userLength);
+    request.timestamp = qFromBigEndian<qint64>(data + TIMESTAMP_OFFSET);
+    request.requestId = version >= 2 && size >= Size ? qFromBigEndian<quint32>(data + REQUEST_ID_OFFSET) : 0;
+    return true;
+}
+
+QByteArray ChatRequestDatagram::encodeAck(quint32 requestId)
+{
+    QByteArray datagram(AckSize, '\0');
+    char* data = datagram.data();
+
+    qToBigEndian<quint32>(AckMagic, data + MAGIC_OFFSET);
+    data[VERSION_OFFSET] = char(Version);
+    qToBigEndian<quint32>(requestId, data + ACK_REQUEST_ID_OFFSET);
+
+    return datagram;
+}
+
+bool ChatRequestDatagram::decodeAck(const char* data, qint64 size, quint32& requestId)
+{
+    if (size < AckSize || qFromBigEndian<quint32>(data + MAGIC_OFFSET) != AckMagic) {
+        return false;
+    }
+
+    requestId = qFromBigEndian<quint32>(data + ACK_REQUEST_ID_OFFSET);
+    return true;
+}
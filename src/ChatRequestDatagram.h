@@ -0,0 +1,53 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+// Fixed-layout datagram a student's worker broadcasts when F10 is pressed.
+// All integers are big endian, strings are UTF-8 and zero padded:
+//
+//   0  quint32  magic ("VCRQ")
+//   4  quint8   version
+//   5  quint8   host name length
+//   6  quint8   user name length
+//   7  quint8   reserved
+//   8  qint64   timestamp (ms since epoch, UTC)
+//  16  char[64] host name
+//  80  char[32] user name
+// 112  quint32  request id (version 2)
+//
+// Version 1 masters ignore the trailing request id. The master answers each
+// request id with an ack, laid out as:
+//
+//   0  quint32  magic ("VCRA")
+//   4  quint8   version
+//   5  quint8[3] reserved
+//   8  quint32  request id
+struct ChatRequestDatagram
+{
+    static constexpr quint32 Magic = 0x56435251;
+    static constexpr quint32 AckMagic = 0x56435241;
+    static constexpr quint8 Version = 2;
+    static constexpr int HostSize = 64;
+    static constexpr int UserSize = 32;
+    static constexpr int MinimumSize = 16 + HostSize + UserSize;
+    static constexpr int Size = MinimumSize + 4;
+    static constexpr int AckSize = 12;
+
+    QString host;
+    QString user;
+    qint64 timestamp = 0;
+    // 0 for requests from version 1 workers, which expect no ack
+    quint32 requestId = 0;
+
+    // Builds a complete datagram, only timestamp and request id need patching per send
+    static QByteArray encode(const QString& host, const QString& user);
+    static void setTimestamp(QByteArray& datagram, qint64 timestamp);
+    static void setRequestId(QByteArray& datagram, quint32 requestId);
+
+    static bool isDatagram(const char* data, qint64 size);
+    static bool decode(const char* data, qint64 size, ChatRequestDatagram& request);
+
+    static QByteArray encodeAck(quint32 requestId);
+    static bool decodeAck(const char* data, qint64 size, quint32& requestId);
+};
@@ -0,0 +1,147 @@
+/*
+ * ChatRequestIntake.cpp - implementation of ChatRequestIntake class
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include <QSettings>
+
+#include "ChatMetrics.h"
+#include "ChatRequestIntake.h"
+
+namespace {
+constexpr auto ORGANIZATION_NAME = "Veyon";
+constexpr auto APPLICATION_NAME = "ChatMaster";
+constexpr auto SETTINGS_DEDUP_WINDOW = "requestDedupWindow";
+constexpr auto SETTINGS_BURST = "requestBurst";
+constexpr auto SETTINGS_RATE = "requestRate";
+
+constexpr int DEFAULT_DEDUP_WINDOW = 10;
+// Enough for a whole class asking at once, but not for a flooded port
+constexpr int DEFAULT_BURST = 40;
+constexpr double DEFAULT_RATE = 2.0;
+
+ChatCounterFamily& requestOutcomes()
+{
+    static auto& family = ChatMetrics::instance().counterFamily(
+        QStringLiteral("chat_request_intake_total"), QStringLiteral("F10 chat requests by intake outcome"),
+        QStringLiteral("outcome"),
+        {QStringLiteral("accepted"), QStringLiteral("merged"), QStringLiteral("dropped")});
+    return family;
+}
+
+ChatGauge& requestsPending()
+{
+    static auto& gauge = ChatMetrics::instance().gauge(
+        QStringLiteral("chat_requests_pending"), QStringLiteral("F10 chat requests not handled by the teacher yet"));
+    return gauge;
+}
+}
+
+ChatRequestIntake::ChatRequestIntake(QObject* parent) :
+    QObject(parent),
+    m_dedupWindow(DEFAULT_DEDUP_WINDOW * 1000),
+    m_bucketCapacity(DEFAULT_BURST),
+    m_refillRate(DEFAULT_RATE / 1000.0),
+    m_tokens(DEFAULT_BURST),
+    m_lastRefill(0)
+{
+    const QSettings settings(ORGANIZATION_NAME, APPLICATION_NAME);
+    setDedupWindow(settings.value(SETTINGS_DEDUP_WINDOW, DEFAULT_DEDUP_WINDOW).toInt() * 1000);
+    setRateLimit(settings.value(SETTINGS_BURST, DEFAULT_BURST).toInt(),
+                 settings.value(SETTINGS_RATE, DEFAULT_RATE).toDouble());
+
+    m_clock.start();
+}
+
+void ChatRequestIntake::setRateLimit(int burst, double perSecond)
+{
+    m_bucketCapacity = qMax(1, burst);
+    m_refillRate = qMax(0.0, perSecond) / 1000.0;
+    m_tokens = qMin(m_tokens, m_bucketCapacity);
+}
+
+void ChatRequestIntake::submit(const QString& clientId)
+{
+    if (clientId.isEmpty()) {
+        return;
+    }
+
+    const qint64 now = m_clock.elapsed();
+    expire(now);
+
+    if (m_pending.contains(clientId) || m_recentlyAccepted.contains(clientId)) {
+        count(Outcome::Merged);
+        return;
+    }
+
+    if (!takeToken(now)) {
+        count(Outcome::Dropped);
+        return;
+    }
+
+    count(Outcome::Accepted);
+    m_recentlyAccepted.insert(clientId);
+    m_acceptOrder.enqueue(qMakePair(clientId, now));
+    m_pending.insert(clientId);
+    requestsPending().set(m_pending.size());
+
+    emit requestQueued(clientId);
+}
+
+void ChatRequestIntake::resolve(const QString& clientId)
+{
+    m_pending.remove(clientId);
+    requestsPending().set(m_pending.size());
+}
+
+void ChatRequestIntake::count(Outcome outcome)
+{
+    switch (outcome) {
+    case Outcome::Accepted: ++m_statistics.accepted; break;
+    case Outcome::Merged: ++m_statistics.merged; break;
+    case Outcome::Dropped: ++m_statistics.dropped; break;
+    }
+
+    requestOutcomes().increment(int(outcome));
+}
+
+// A client is accepted again only once its entry has expired, so each
+// client has at most one entry in m_acceptOrder
+void ChatRequestIntake::expire(qint64 now)
+{
+    while (!m_acceptOrder.isEmpty() && now - m_acceptOrder.head().second >= m_dedupWindow) {
+        m_recentlyAccepted.remove(m_acceptOrder.dequeue().first);
+    }
+}
+
+bool ChatRequestIntake::takeToken(qint64 now)
+{
+    m_tokens = qMin(m_bucketCapacity, m_tokens + double(now - m_lastRefill) * m_refillRate);
+    m_lastRefill = now;
+
+    if (m_tokens < 1.0) {
+        return false;
+    }
+
+    m_tokens -= 1.0;
+    return true;
+}
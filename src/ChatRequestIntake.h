@@ -0,0 +1,90 @@
+/*
+ * ChatRequestIntake.h - declaration of ChatRequestIntake class
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QPair>
+#include <QQueue>
+#include <QSet>
+
+// First stage for F10 chat requests on the master. Repeated requests of a
+// client which are already pending or arrive within the dedup window are
+// merged, a token bucket bounds the rate of new requests overall and
+// accepted requests stay queued until the teacher has handled them. The
+// window and the rate come from the ChatMaster settings, the outcomes are
+// counted in ChatMetrics as well.
+class ChatRequestIntake : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Statistics
+    {
+        quint64 accepted = 0;
+        quint64 merged = 0;
+        quint64 dropped = 0;
+    };
+
+    explicit ChatRequestIntake(QObject* parent = nullptr);
+
+    // Window in milliseconds, rate in requests per second
+    void setDedupWindow(int window) { m_dedupWindow = qMax(0, window); }
+    void setRateLimit(int burst, double perSecond);
+
+    void submit(const QString& clientId);
+    void resolve(const QString& clientId);
+
+    bool isPending(const QString& clientId) const { return m_pending.contains(clientId); }
+    int pendingCount() const { return m_pending.size(); }
+    const Statistics& statistics() const { return m_statistics; }
+
+signals:
+    void requestQueued(const QString& clientId);
+
+private:
+    enum class Outcome
+    {
+        Accepted,
+        Merged,
+        Dropped
+    };
+
+    void count(Outcome outcome);
+    void expire(qint64 now);
+    bool takeToken(qint64 now);
+
+    QElapsedTimer m_clock;
+    int m_dedupWindow;
+    double m_bucketCapacity;
+    double m_refillRate;
+    double m_tokens;
+    qint64 m_lastRefill;
+    QSet<QString> m_pending;
+    // Clients accepted within the dedup window, oldest first in m_acceptOrder
+    QSet<QString> m_recentlyAccepted;
+    QQueue<QPair<QString, qint64>> m_acceptOrder;
+    Statistics m_statistics;
+};
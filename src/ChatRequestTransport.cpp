@@ -0,0 +1,23 @@
+#include "ChatRequestTransport.h"
+
+#include <atomic>
+
+namespace {
+std::atomic<ChatRequestTransport*> installedTransport{nullptr};
+}
+
+void ChatRequestTransport::install(ChatRequestTransport* transport)
+{
+    installedTransport.store(transport);
+}
+
+qint64 ChatRequestTransport::send(Kind kind, const QByteArray& datagram, const QHostAddress& address, quint16 port,
+                                  const SendFunction& direct)
+{
+    auto* transport = installedTransport.load();
+    if (transport == nullptr) {
+        return direct(datagram, address, port);
+    }
+
+    return transport->transmit(kind, datagram, address, port, direct);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHostAddress>
+#include <functional>
+
+// Outgoing datagrams of the F10 request protocol, requests from the worker
+// and acks from the master's listener, pass through the installed transport.
+// None is installed in the plugin, datagrams are then sent directly. Tests
+// and the load generator install one to drop or redirect datagrams, e.g. to
+// exercise retries without a lossy network.
+class ChatRequestTransport
+{
+public:
+    enum class Kind
+    {
+        Request,
+        Ack
+    };
+
+    using SendFunction = std::function<qint64(const QByteArray& datagram, const QHostAddress& address, quint16 port)>;
+
+    virtual ~ChatRequestTransport() = default;
+
+    // Called from the worker's and the listener's threads. Sends the datagram
+    // through direct, possibly to another address or not at all, and returns
+    // what QUdpSocket::writeDatagram() would.
+    virtual qint64 transmit(Kind kind, const QByteArray& datagram, const QHostAddress& address, quint16 port,
+                            const SendFunction& direct) = 0;
+
+    // Not owned, nullptr restores direct sending
+    static void install(ChatRequestTransport* transport);
+
+    // Sends through the installed transport or directly
+    static qint64 send(Kind kind, const QByteArray& datagram, const QHostAddress& address, quint16 port,
+                       const SendFunction& direct);
+};
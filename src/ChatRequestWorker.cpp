@@ -1,18 +1,30 @@
 #include "ChatRequestWorker.h"
+#include "ChatRequestDatagram.h"
+#include "ChatRequestTransport.h"
 
 #include <QCoreApplication>
 #include <QDateTime>
-#include <QHostAddress>
 #include <QHostInfo>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QNetworkInterface>
+#include <QRandomGenerator>
+#include <QSettings>
+#include <QTimer>
 
 #ifdef _WIN32
 #include <windows.h>
 #endif
 
 namespace {
-static constexpr quint16 kChatSignalPort = 29665;
+constexpr auto ORGANIZATION_NAME = "Veyon";
+constexpr auto APPLICATION_NAME = "ChatClient";
+// Additionally send the JSON request understood by masters before the binary format
+constexpr auto SETTINGS_LEGACY_REQUESTS = "legacyRequests";
+constexpr int INITIAL_RETRY_DELAY = 250;
+constexpr int MAX_RETRY_DELAY = 4000;
+// Give up on masters that never answer, e.g. ones predating acks
+constexpr int REQUEST_TIMEOUT = 15000;
 }
 
 bool HotkeyFilter::nativeEventFilter(const QByteArray& eventType, void* message, long*)
@@ -34,7 +46,50 @@ bool HotkeyFilter::nativeEventFilter(const QByteArray& eventType, void* message,
 ChatRequestWorker::ChatRequestWorker(QObject* parent)
     : QObject(parent)
     , m_filter(new HotkeyFilter(this))
+    , m_socket(new QUdpSocket(this))
+    , m_retryTimer(new QTimer(this))
+    , m_settings(ChatSignalSettings::load(APPLICATION_NAME))
+    , m_requestId(0)
+    , m_retryDelay(INITIAL_RETRY_DELAY)
 {
+    QString user = QString::fromLocal8Bit(qgetenv("USERNAME"));
+    if (user.isEmpty()) {
+        user = QString::fromLocal8Bit(qgetenv("USER"));
+    }
+    const QString host = QHostInfo::localHostName();
+
+    // Everything but the timestamp is known up front, so pressing F10 neither
+    // creates a socket nor serializes anything
+    m_datagram = ChatRequestDatagram::encode(host, user);
+
+    const QSettings settings(ORGANIZATION_NAME, APPLICATION_NAME);
+    if (settings.value(SETTINGS_LEGACY_REQUESTS, false).toBool()) {
+        const QJsonObject payload{
+            {QStringLiteral("type"), QStringLiteral("chat_request")},
+            {QStringLiteral("host"), host},
+            {QStringLiteral("user"), user}
+        };
+        m_legacyDatagram = QJsonDocument(payload).toJson(QJsonDocument::Compact);
+    }
+
+    // Acks come back to the port requests are sent from
+    m_socket->bind(QHostAddress::AnyIPv4, 0);
+    connect(m_socket, &QUdpSocket::readyRead, this, &ChatRequestWorker::onReadyRead);
+
+    m_retryTimer->setSingleShot(true);
+    connect(m_retryTimer, &QTimer::timeout, this, &ChatRequestWorker::retryRequest);
+
+    if (m_settings.useMulticast()) {
+        m_socket->setSocketOption(QAbstractSocket::MulticastTtlOption, m_settings.ttl);
+        // Lets a master on the same machine receive requests, e.g. for testing
+        m_socket->setSocketOption(QAbstractSocket::MulticastLoopbackOption, 1);
+
+        const QNetworkInterface networkInterface = QNetworkInterface::interfaceFromName(m_settings.interfaceName);
+        if (networkInterface.isValid()) {
+            m_socket->setMulticastInterface(networkInterface);
+        }
+    }
+
 #ifdef _WIN32
     RegisterHotKey(nullptr, 1, 0x4000 /*MOD_NOREPEAT*/, VK_F10);
 #endif
@@ -43,6 +98,7 @@ ChatRequestWorker::ChatRequestWorker(QObject* parent)
         qApp->installNativeEventFilter(m_filter);
     }
     connect(m_filter, &HotkeyFilter::f10Pressed, this, &ChatRequestWorker::sendRequest);
+    connect(m_filter, &HotkeyFilter::f10Pressed, this, &ChatRequestWorker::hotkeyPressed);
 }
 
 ChatRequestWorker::~ChatRequestWorker()
@@ -57,20 +113,83 @@ ChatRequestWorker::~ChatRequestWorker()
 
 void ChatRequestWorker::sendRequest()
 {
-    QUdpSocket socket;
+    // Pressing F10 again while a request is unacknowledged adds no load,
+    // the pending request is already being retried
+    if (m_requestId != 0) {
+        return;
+    }
 
-    QString user = QString::fromLocal8Bit(qgetenv("USERNAME"));
-    if (user.isEmpty()) {
-        user = QString::fromLocal8Bit(qgetenv("USER"));
+    do {
+        m_requestId = QRandomGenerator::global()->generate();
+    } while (m_requestId == 0);
+
+    ChatRequestDatagram::setRequestId(m_datagram, m_requestId);
+    ChatRequestDatagram::setTimestamp(m_datagram, QDateTime::currentMSecsSinceEpoch());
+
+    m_retryDelay = INITIAL_RETRY_DELAY;
+    m_requestAge.start();
+
+    transmit(true);
+    scheduleRetry();
+}
+
+void ChatRequestWorker::retryRequest()
+{
+    if (m_requestId == 0) {
+        return;
+    }
+
+    if (m_requestAge.elapsed() >= REQUEST_TIMEOUT) {
+        m_requestId = 0;
+        return;
+    }
+
+    transmit(false);
+    scheduleRetry();
+}
+
+void ChatRequestWorker::scheduleRetry()
+{
+    // Equal jitter keeps the students of a room from retrying in lockstep
+    const int half = m_retryDelay / 2;
+    m_retryTimer->start(half + int(QRandomGenerator::global()->bounded(half + 1)));
+    m_retryDelay = qMin(m_retryDelay * 2, MAX_RETRY_DELAY);
+}
+
+void ChatRequestWorker::onReadyRead()
+{
+    char buffer[ChatRequestDatagram::AckSize];
+
+    while (m_socket->hasPendingDatagrams()) {
+        const qint64 size = m_socket->readDatagram(buffer, sizeof(buffer));
+
+        quint32 requestId = 0;
+        if (ChatRequestDatagram::decodeAck(buffer, size, requestId) &&
+            requestId != 0 && requestId == m_requestId) {
+            m_retryTimer->stop();
+            m_requestId = 0;
+        }
     }
+}
 
-    const QJsonObject payload{
-        {QStringLiteral("type"), QStringLiteral("chat_request")},
-        {QStringLiteral("host"), QHostInfo::localHostName()},
-        {QStringLiteral("user"), user},
-        {QStringLiteral("ts"), QDateTime::currentDateTimeUtc().toString(Qt::ISODate)}
-    };
+void ChatRequestWorker::transmit(bool firstAttempt)
+{
+    // Fall back to broadcast if the group cannot be reached, e.g. without a multicast route
+    if (!m_settings.useMulticast() || send(m_datagram, m_settings.group) < 0) {
+        send(m_datagram, QHostAddress(QHostAddress::Broadcast));
+    }
 
-    const QByteArray data = QJsonDocument(payload).toJson(QJsonDocument::Compact);
-    socket.writeDatagram(data, QHostAddress::Broadcast, kChatSignalPort);
+    // Masters predating the binary format do not join the group either. They
+    // never ack, so they only get the first attempt.
+    if (firstAttempt && !m_legacyDatagram.isEmpty()) {
+        send(m_legacyDatagram, QHostAddress(QHostAddress::Broadcast));
+    }
+}
+
+qint64 ChatRequestWorker::send(const QByteArray& datagram, const QHostAddress& address)
+{
+    return ChatRequestTransport::send(ChatRequestTransport::Kind::Request, datagram, address, ChatSignalSettings::Port,
+        [this](const QByteArray& data, const QHostAddress& target, quint16 port) {
+            return m_socket->writeDatagram(data, target, port);
+        });
 }
@@ -1,7 +1,12 @@
 #pragma once
 
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHostAddress>
 #include <QObject>
 #include <QUdpSocket>
+
+#include "ChatSignalSettings.h"
 #include <QAbstractNativeEventFilter>
 
 class HotkeyFilter : public QObject, public QAbstractNativeEventFilter
@@ -17,6 +22,10 @@ signals:
     void f10Pressed();
 };
 
+class QTimer;
+
+// Sends a request whenever F10 is pressed and repeats it with exponential
+// backoff until the master acknowledges its request id or it times out.
 class ChatRequestWorker : public QObject
 {
     Q_OBJECT
@@ -25,9 +34,28 @@ public:
     explicit ChatRequestWorker(QObject* parent = nullptr);
     ~ChatRequestWorker() override;
 
+signals:
+    void hotkeyPressed();
+
 public slots:
     void sendRequest();
 
+private slots:
+    void retryRequest();
+    void onReadyRead();
+
 private:
+    void transmit(bool firstAttempt);
+    void scheduleRetry();
+    qint64 send(const QByteArray& datagram, const QHostAddress& address);
+
     HotkeyFilter* m_filter;
+    QUdpSocket* m_socket;
+    QTimer* m_retryTimer;
+    ChatSignalSettings m_settings;
+    QByteArray m_datagram;
+    QByteArray m_legacyDatagram;
+    quint32 m_requestId;
+    int m_retryDelay;
+    QElapsedTimer m_requestAge;
 };
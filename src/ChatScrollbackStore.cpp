@@ -0,0 +1,107 @@
+/*
+ * ChatScrollbackStore.cpp - implementation of ChatScrollbackStore class
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include "ChatScrollbackStore.h"
+#include <QtEndian>
+
+ChatScrollbackStore::ChatScrollbackStore(const QString& fileName) :
+    m_file(fileName),
+    m_end(0)
+{
+    // The display starts empty, so does the file
+    m_file.open(QIODevice::ReadWrite | QIODevice::Truncate);
+}
+
+ChatScrollbackStore::~ChatScrollbackStore()
+{
+    if (m_file.isOpen()) {
+        m_file.close();
+        m_file.remove();
+    }
+}
+
+void ChatScrollbackStore::append(const QString& line)
+{
+    if (!m_file.isOpen()) {
+        return;
+    }
+
+    const QByteArray utf8 = line.toUtf8();
+    char header[sizeof(quint32)];
+    qToBigEndian<quint32>(quint32(utf8.size()), header);
+
+    m_file.seek(m_end);
+    if (m_file.write(header, sizeof(header)) != qint64(sizeof(header)) ||
+        m_file.write(utf8) != utf8.size()) {
+        // Keep the offsets consistent with what can actually be read back
+        m_file.resize(m_end);
+        return;
+    }
+
+    m_offsets.append(m_end);
+    m_end += qint64(sizeof(header)) + utf8.size();
+}
+
+QStringList ChatScrollbackStore::read(int first, int count)
+{
+    QStringList lines;
+
+    first = qMax(first, 0);
+    const int last = qMin(first + count, m_offsets.size());
+    if (!m_file.isOpen() || first >= last) {
+        return lines;
+    }
+
+    // Lines are contiguous, so a page is a single read
+    const qint64 begin = m_offsets[first];
+    const qint64 end = last < m_offsets.size() ? m_offsets[last] : m_end;
+
+    m_file.flush();
+    m_file.seek(begin);
+    const QByteArray page = m_file.read(end - begin);
+    if (page.size() != end - begin) {
+        return lines;
+    }
+
+    lines.reserve(last - first);
+    const char* data = page.constData();
+    for (int i = first; i < last; ++i) {
+        const qint64 offset = m_offsets[i] - begin;
+        const quint32 size = qFromBigEndian<quint32>(data + offset);
+        lines.append(QString::fromUtf8(data + offset + sizeof(quint32), int(size)));
+    }
+
+    return lines;
+}
+
+void ChatScrollbackStore::clear()
+{
+    m_offsets.clear();
+    m_offsets.squeeze();
+    m_end = 0;
+
+    if (m_file.isOpen()) {
+        m_file.resize(0);
+    }
+}
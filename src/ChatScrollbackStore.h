@@ -0,0 +1,53 @@
+/*
+ * ChatScrollbackStore.h - declaration of ChatScrollbackStore class
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#pragma once
+
+#include <QFile>
+#include <QStringList>
+#include <QVector>
+
+// Append-only local file holding every line shown in the client's chat
+// display, so the display itself can be capped and older lines read back
+// in pages. Lines are stored as a big endian quint32 length followed by
+// UTF-8; only the file offset of each line is kept in memory.
+class ChatScrollbackStore
+{
+public:
+    explicit ChatScrollbackStore(const QString& fileName);
+    ~ChatScrollbackStore();
+
+    bool isOpen() const { return m_file.isOpen(); }
+    int size() const { return m_offsets.size(); }
+
+    void append(const QString& line);
+    // Returns lines [first, first + count), clamped to the stored range
+    QStringList read(int first, int count);
+    void clear();
+
+private:
+    QFile m_file;
+    QVector<qint64> m_offsets;
+    qint64 m_end;
+};
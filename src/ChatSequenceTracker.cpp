@@ -0,0 +1,117 @@
+/*
+ * ChatSequenceTracker.cpp - implementation of ChatSequenceTracker class
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include "ChatSequenceTracker.h"
+
+namespace {
+// Ask again if a resync has not been answered within this time
+constexpr int RESYNC_TIMEOUT = 5000;
+// Larger gaps (e.g. after a restart) only fetch their most recent part
+constexpr quint32 MAX_RESYNC_RANGE = 256;
+}
+
+ChatSequenceTracker::ChatSequenceTracker() :
+    m_contiguous(0),
+    m_requested(0)
+{
+}
+
+ChatSequenceTracker::Range ChatSequenceTracker::receive(quint32 sequence)
+{
+    Range gap;
+    if (sequence == 0) {
+        return gap;
+    }
+
+    // Duplicates are filtered before, so seeing 1 again means the peer
+    // restarted its numbering
+    if (sequence == 1 && m_contiguous > 0) {
+        reset();
+    }
+
+    if (sequence <= m_contiguous) {
+        return gap;
+    }
+
+    if (sequence == m_contiguous + 1) {
+        m_contiguous = sequence;
+        absorb();
+        return gap;
+    }
+
+    m_ahead.insert(sequence);
+
+    if (m_requested >= m_contiguous + 1 && m_lastRequest.isValid() &&
+        m_lastRequest.elapsed() >= RESYNC_TIMEOUT) {
+        // The previous request or its answer got lost, ask for all of it
+        m_requested = m_contiguous;
+    }
+
+    if (sequence - 1 > m_requested) {
+        gap.first = qMax(m_contiguous, m_requested) + 1;
+        gap.last = sequence - 1;
+        if (gap.last - gap.first >= MAX_RESYNC_RANGE) {
+            gap.first = gap.last - MAX_RESYNC_RANGE + 1;
+            settle(gap.first - 1);
+        }
+        m_requested = gap.last;
+        m_lastRequest.start();
+    }
+
+    return gap;
+}
+
+void ChatSequenceTracker::settle(quint32 sequence)
+{
+    if (sequence > m_contiguous) {
+        m_contiguous = sequence;
+        for (auto it = m_ahead.begin(); it != m_ahead.end(); ) {
+            if (*it <= m_contiguous) {
+                it = m_ahead.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        absorb();
+    }
+
+    if (m_requested <= m_contiguous) {
+        m_lastRequest.invalidate();
+    }
+}
+
+void ChatSequenceTracker::reset()
+{
+    m_contiguous = 0;
+    m_requested = 0;
+    m_ahead.clear();
+    m_lastRequest.invalidate();
+}
+
+void ChatSequenceTracker::absorb()
+{
+    while (!m_ahead.isEmpty() && m_ahead.remove(m_contiguous + 1)) {
+        ++m_contiguous;
+    }
+}
@@ -0,0 +1,65 @@
+/*
+ * ChatSequenceTracker.h - declaration of ChatSequenceTracker class
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QSet>
+
+// Follows the sequence numbers of one direction of a conversation. It keeps
+// the highest number up to which everything has arrived and reports gaps,
+// i.e. ranges the peer has to send again, once per range unless the resync
+// answer is overdue.
+class ChatSequenceTracker
+{
+public:
+    struct Range
+    {
+        quint32 first = 0;
+        quint32 last = 0;
+
+        bool isEmpty() const { return first == 0 || last < first; }
+    };
+
+    ChatSequenceTracker();
+
+    quint32 contiguous() const { return m_contiguous; }
+
+    // Records an arrived sequence number, returns the range to request
+    Range receive(quint32 sequence);
+
+    // Called once a resync for everything up to the given number has been
+    // answered; whatever is still missing there cannot be recovered
+    void settle(quint32 sequence);
+
+    void reset();
+
+private:
+    void absorb();
+
+    quint32 m_contiguous;
+    quint32 m_requested;
+    QSet<quint32> m_ahead;
+    QElapsedTimer m_lastRequest;
+};
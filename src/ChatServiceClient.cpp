@@ -23,17 +23,40 @@
  */
 
 #include "ChatServiceClient.h"
+#include "ChatClientWidget.h"
 #include <QHostInfo>
 #include <QApplication>
+#include <QTimer>
 
 #include "ChatRequestWorker.h"
 
+namespace {
+constexpr int ACKNOWLEDGE_INTERVAL = 2000;
+constexpr int SENT_MESSAGES_CAPACITY = 256;
+}
+
 ChatServiceClient::ChatServiceClient(QObject* parent) :
     QObject(parent),
     m_clientWidget(nullptr),
-    m_requestWorker(new ChatRequestWorker(this))
+    m_buildScheduled(false),
+    m_clientId(getClientId()),
+    m_requestWorker(new ChatRequestWorker(this)),
+    m_heartbeatTimer(new QTimer(this)),
+    m_lastSequence(0),
+    m_acknowledgeTimer(new QTimer(this)),
+    m_readSequence(0),
+    m_acknowledgedDelivered(0),
+    m_acknowledgedRead(0)
 {
-    initializeClient();
+    connect(m_requestWorker, &ChatRequestWorker::hotkeyPressed, this, &ChatServiceClient::showChatWindow);
+
+    m_heartbeatTimer->setInterval(ChatSession::HeartbeatInterval);
+    connect(m_heartbeatTimer, &QTimer::timeout, this, &ChatServiceClient::heartbeat);
+    m_heartbeatTimer->start();
+
+    m_acknowledgeTimer->setInterval(ACKNOWLEDGE_INTERVAL);
+    m_acknowledgeTimer->setSingleShot(true);
+    connect(m_acknowledgeTimer, &QTimer::timeout, this, &ChatServiceClient::sendAcknowledge);
 }
 
 ChatServiceClient::~ChatServiceClient()
@@ -45,10 +68,32 @@ ChatServiceClient::~ChatServiceClient()
 
 void ChatServiceClient::receiveMessage(const ChatMessage& message)
 {
+    // Only direct messages are numbered, and only those to this client
+    // count, the master may send them to every student
+    if (message.sequence() != 0 && message.receiverId() == m_clientId) {
+        // Numbering starts over when the master has been restarted
+        if (message.sequence() == 1 && m_receivedSequences.contiguous() > 0) {
+            m_readSequence = m_acknowledgedDelivered = m_acknowledgedRead = 0;
+        }
+
+        const auto gap = m_receivedSequences.receive(message.sequence());
+        if (!gap.isEmpty()) {
+            emit resyncRequested(gap.first, gap.last);
+        }
+        updateReceipts();
+    }
+
     if (!m_clientWidget) {
-        initializeClient();
+        // Build the window from the event loop, so a burst of messages (e.g.
+        // a global broadcast right after connecting) is replayed in one go
+        m_pendingMessages.append(message);
+        if (!m_buildScheduled) {
+            m_buildScheduled = true;
+            QMetaObject::invokeMethod(this, &ChatServiceClient::showPendingMessages, Qt::QueuedConnection);
+        }
+        return;
     }
-    
+
     m_clientWidget->receiveMessage(message);
     
     // Show the chat window if it's not visible and we received a message
@@ -59,11 +104,48 @@ void ChatServiceClient::receiveMessage(const ChatMessage& message)
 
 void ChatServiceClient::clearChat()
 {
+    m_pendingMessages.clear();
+
     if (m_clientWidget) {
         m_clientWidget->clearChat();
     }
 }
 
+QList<ChatMessage> ChatServiceClient::sentMessages(quint32 first, quint32 last) const
+{
+    QList<ChatMessage> messages;
+
+    // Older messages have been overwritten in the ring and cannot be resent
+    const quint32 oldest = m_lastSequence >= quint32(SENT_MESSAGES_CAPACITY) ?
+                               m_lastSequence - SENT_MESSAGES_CAPACITY + 1 : 1;
+    for (quint32 sequence = qMax(first, oldest); sequence <= qMin(last, m_lastSequence); ++sequence) {
+        messages.append(m_sentMessages[int(sequence % SENT_MESSAGES_CAPACITY)]);
+    }
+
+    return messages;
+}
+
+void ChatServiceClient::receiveResync(const QList<ChatMessage>& messages, quint32 last)
+{
+    for (const auto& message : messages) {
+        receiveMessage(message);
+    }
+
+    m_receivedSequences.settle(last);
+    updateReceipts();
+}
+
+void ChatServiceClient::updateReceipts()
+{
+    if (m_clientWidget && m_clientWidget->isActiveWindow()) {
+        m_readSequence = m_receivedSequences.contiguous();
+    }
+
+    if (m_receivedSequences.contiguous() != m_acknowledgedDelivered && !m_acknowledgeTimer->isActive()) {
+        m_acknowledgeTimer->start();
+    }
+}
+
 void ChatServiceClient::showChatWindow()
 {
     if (!m_clientWidget) {
@@ -84,21 +166,61 @@ void ChatServiceClient::hideChatWindow()
 
 void ChatServiceClient::onClientMessageSent(const ChatMessage& message)
 {
-    emit sendMessage(message);
+    ChatMessage numbered(message);
+    numbered.setSequence(++m_lastSequence);
+
+    if (m_sentMessages.isEmpty()) {
+        m_sentMessages.resize(SENT_MESSAGES_CAPACITY);
+    }
+    m_sentMessages[int(numbered.sequence() % SENT_MESSAGES_CAPACITY)] = numbered;
+
+    // Any outgoing traffic counts as a heartbeat on the master
+    m_heartbeatTimer->start();
+    emit sendMessage(numbered);
 }
 
 void ChatServiceClient::onClientStatusChanged(ChatSession::ClientStatus status)
 {
+    m_heartbeatTimer->start();
     emit statusChanged(status);
 }
 
+void ChatServiceClient::showPendingMessages()
+{
+    m_buildScheduled = false;
+
+    // A chat cleared before the window was built leaves nothing to show
+    if (!m_clientWidget && !m_pendingMessages.isEmpty()) {
+        showChatWindow();
+    }
+}
+
+void ChatServiceClient::onClientActivated()
+{
+    m_readSequence = m_receivedSequences.contiguous();
+    sendAcknowledge();
+}
+
+void ChatServiceClient::sendAcknowledge()
+{
+    m_acknowledgeTimer->stop();
+
+    const quint32 delivered = m_receivedSequences.contiguous();
+    if (delivered == m_acknowledgedDelivered && m_readSequence == m_acknowledgedRead) {
+        return;
+    }
+
+    m_acknowledgedDelivered = delivered;
+    m_acknowledgedRead = m_readSequence;
+    emit acknowledge(m_acknowledgedDelivered, m_acknowledgedRead);
+}
+
 void ChatServiceClient::initializeClient()
 {
     if (m_clientWidget) {
         return;
     }
 
-    m_clientId = getClientId();
     m_clientWidget = new ChatClientWidget();
     m_clientWidget->setClientId(m_clientId);
 
@@ -107,6 +229,14 @@ void ChatServiceClient::initializeClient()
             this, &ChatServiceClient::onClientMessageSent);
     connect(m_clientWidget, &ChatClientWidget::statusChanged,
             this, &ChatServiceClient::onClientStatusChanged);
+    connect(m_clientWidget, &ChatClientWidget::activated,
+            this, &ChatServiceClient::onClientActivated);
+
+    for (const auto& message : qAsConst(m_pendingMessages)) {
+        m_clientWidget->receiveMessage(message);
+    }
+    m_pendingMessages.clear();
+    m_pendingMessages.squeeze();
 }
 
 QString ChatServiceClient::getClientId() const
@@ -25,12 +25,18 @@
 #pragma once
 
 #include <QObject>
+#include <QVector>
 #include "ChatMessage.h"
-#include "ChatClientWidget.h"
+#include "ChatSequenceTracker.h"
 #include "ChatSession.h"
 
+class ChatClientWidget;
 class ChatRequestWorker;
+class QTimer;
 
+// Student side of the chat. The chat window is only built once the first
+// message arrives or F10 is pressed; until then incoming messages are kept
+// in a plain buffer and replayed into the window when it is built.
 class ChatServiceClient : public QObject
 {
     Q_OBJECT
@@ -39,9 +45,15 @@ public:
     explicit ChatServiceClient(QObject* parent = nullptr);
     ~ChatServiceClient() override;
 
-    // Message handling
+    // Message handling, retried and replayed messages have been dropped by
+    // the ingress pipeline before
     void receiveMessage(const ChatMessage& message);
     void clearChat();
+
+    // Delta resync: own messages the master reported missing, and the
+    // answer to a gap detected here
+    QList<ChatMessage> sentMessages(quint32 first, quint32 last) const;
+    void receiveResync(const QList<ChatMessage>& messages, quint32 last);
     
     // Client management
     void showChatWindow();
@@ -52,16 +64,38 @@ public:
 signals:
     void sendMessage(const ChatMessage& message);
     void statusChanged(ChatSession::ClientStatus status);
+    void heartbeat();
+    // Cumulative receipt: all master messages up to these sequence numbers
+    void acknowledge(quint32 delivered, quint32 read);
+    void resyncRequested(quint32 first, quint32 last);
 
 private slots:
     void onClientMessageSent(const ChatMessage& message);
     void onClientStatusChanged(ChatSession::ClientStatus status);
+    void onClientActivated();
+    void sendAcknowledge();
 
 private:
     void initializeClient();
+    void showPendingMessages();
+    void updateReceipts();
     QString getClientId() const;
 
     ChatClientWidget* m_clientWidget;
+    QVector<ChatMessage> m_pendingMessages;
+    bool m_buildScheduled;
     QString m_clientId;
     ChatRequestWorker* m_requestWorker;
+    QTimer* m_heartbeatTimer;
+
+    // Numbering of own messages, the most recent ones are kept for resyncs
+    quint32 m_lastSequence;
+    QVector<ChatMessage> m_sentMessages;
+    ChatSequenceTracker m_receivedSequences;
+
+    // Receipts are sent at most once per interval, or right away on focus
+    QTimer* m_acknowledgeTimer;
+    quint32 m_readSequence;
+    quint32 m_acknowledgedDelivered;
+    quint32 m_acknowledgedRead;
 };
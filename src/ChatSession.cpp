@@ -24,19 +24,32 @@
 
 #include "ChatSession.h"
 
+#include <QSet>
+#include <algorithm>
+
 ChatSession::ChatSession() :
+    m_handle(-1),
     m_status(ClientStatus::Online),
     m_lastActivity(QDateTime::currentDateTime()),
-    m_unreadCount(0)
+    m_unreadCount(0),
+    m_unreadPriority(ChatMessage::Priority::Normal),
+    m_lastSequence(0),
+    m_deliveredSequence(0),
+    m_readSequence(0)
 {
 }
 
 ChatSession::ChatSession(const QString& clientId) :
     m_clientId(clientId),
     m_clientName(clientId), // Default to clientId, can be changed later
+    m_handle(-1),
     m_status(ClientStatus::Online),
     m_lastActivity(QDateTime::currentDateTime()),
-    m_unreadCount(0)
+    m_unreadCount(0),
+    m_unreadPriority(ChatMessage::Priority::Normal),
+    m_lastSequence(0),
+    m_deliveredSequence(0),
+    m_readSequence(0)
 {
 }
 
@@ -51,9 +64,25 @@ void ChatSession::addMessage(const ChatMessage& message)
     m_history.append(message);
     updateLastActivity();
     
+    if (message.senderId() == "master") {
+        // Only a direct reply answers the client; broadcasts and announcements
+        // reach everybody and leave the client's questions open
+        if (message.receiverId() == m_clientId) {
+            m_oldestUnanswered = QDateTime();
+        }
+        return;
+    }
+
+    if (!m_oldestUnanswered.isValid()) {
+        m_oldestUnanswered = message.timestamp();
+    }
+
     // If this is an incoming message (not from master), increment unread count
-    if (message.senderId() != "master" && message.status() != ChatMessage::Status::Read) {
+    if (message.status() != ChatMessage::Status::Read) {
         m_unreadCount++;
+        if (message.priority() == ChatMessage::Priority::Urgent) {
+            m_unreadPriority = ChatMessage::Priority::Urgent;
+        }
     }
 }
 
@@ -61,12 +90,15 @@ void ChatSession::clearHistory()
 {
     m_history.clear();
     m_unreadCount = 0;
+    m_unreadPriority = ChatMessage::Priority::Normal;
+    m_oldestUnanswered = QDateTime();
     updateLastActivity();
 }
 
 void ChatSession::markAllAsRead()
 {
     m_unreadCount = 0;
+    m_unreadPriority = ChatMessage::Priority::Normal;
     
     // Update status of all messages to read
     for (auto& message : m_history) {
@@ -76,12 +108,121 @@ void ChatSession::markAllAsRead()
     }
 }
 
+void ChatSession::mergeMessage(const ChatMessage& message)
+{
+    // Almost always the newest message, so search from the end
+    int position = m_history.size();
+    while (position > 0 && m_history[position - 1].timestamp() > message.timestamp()) {
+        --position;
+    }
+
+    if (position == m_history.size()) {
+        addMessage(message);
+        return;
+    }
+
+    m_history.insert(position, message);
+    updateLastActivity();
+    recountUnread();
+}
+
+void ChatSession::markRead(const QStringList& messageIds)
+{
+    const QSet<QString> read(messageIds.cbegin(), messageIds.cend());
+    for (auto& message : m_history) {
+        if (read.contains(message.messageId())) {
+            message.setStatus(ChatMessage::Status::Read);
+        }
+    }
+    recountUnread();
+}
+
+void ChatSession::removeMessages(const QStringList& messageIds)
+{
+    const QSet<QString> removed(messageIds.cbegin(), messageIds.cend());
+    const auto end = std::remove_if(m_history.begin(), m_history.end(), [&removed](const ChatMessage& message) {
+        return removed.contains(message.messageId());
+    });
+    m_history.erase(end, m_history.end());
+    recountUnread();
+    updateLastActivity();
+}
+
+QStringList ChatSession::removeExpired(const QDateTime& now)
+{
+    QStringList removed;
+    const auto end = std::remove_if(m_history.begin(), m_history.end(), [&now, &removed](const ChatMessage& message) {
+        if (message.expiresAt().isValid() && message.expiresAt() <= now) {
+            removed.append(message.messageId());
+            return true;
+        }
+        return false;
+    });
+
+    if (!removed.isEmpty()) {
+        m_history.erase(end, m_history.end());
+        recountUnread();
+    }
+    return removed;
+}
+
+bool ChatSession::acknowledge(quint32 delivered, quint32 read)
+{
+    // Acks may arrive out of order, watermarks only ever move forward
+    read = qMin(read, m_lastSequence);
+    delivered = qMin(qMax(delivered, read), m_lastSequence);
+
+    const bool changed = delivered > m_deliveredSequence || read > m_readSequence;
+    m_deliveredSequence = qMax(m_deliveredSequence, delivered);
+    m_readSequence = qMax(m_readSequence, read);
+    return changed;
+}
+
+ChatMessage::Status ChatSession::deliveryStatus(quint32 sequence) const
+{
+    if (sequence != 0 && sequence <= m_readSequence) {
+        return ChatMessage::Status::Read;
+    }
+    if (sequence != 0 && sequence <= m_deliveredSequence) {
+        return ChatMessage::Status::Delivered;
+    }
+    return ChatMessage::Status::Sent;
+}
+
+QList<ChatMessage> ChatSession::sentMessages(quint32 first, quint32 last) const
+{
+    QList<ChatMessage> messages;
+
+    // Recent ranges are the common case, so only walk back as far as needed
+    for (int i = m_history.size() - 1; i >= 0; --i) {
+        const ChatMessage& message = m_history[i];
+        if (message.senderId() != "master" || message.sequence() == 0) {
+            continue;
+        }
+        if (message.sequence() < first) {
+            break;
+        }
+        if (message.sequence() <= last) {
+            messages.prepend(message);
+        }
+    }
+
+    return messages;
+}
+
+int ChatSession::urgency() const
+{
+    // Only unread urgent messages raise a session above the others
+    return m_unreadCount > 0 && m_unreadPriority == ChatMessage::Priority::Urgent ? 1 : 0;
+}
+
 QString ChatSession::statusString() const
 {
     switch (m_status) {
         case ClientStatus::Online: return "Online";
         case ClientStatus::Away: return "Away";
         case ClientStatus::Typing: return "Typing...";
+        case ClientStatus::Offline: return "Offline";
     }
     return "Online";
 }
@@ -90,3 +231,30 @@ void ChatSession::updateLastActivity()
 {
     m_lastActivity = QDateTime::currentDateTime();
 }
+
+void ChatSession::recountUnread()
+{
+    m_unreadCount = 0;
+    m_unreadPriority = ChatMessage::Priority::Normal;
+    m_oldestUnanswered = QDateTime();
+
+    for (const auto& message : qAsConst(m_history)) {
+        if (message.senderId() == "master") {
+            if (message.receiverId() == m_clientId) {
+                m_oldestUnanswered = QDateTime();
+            }
+            continue;
+        }
+
+        if (!m_oldestUnanswered.isValid()) {
+            m_oldestUnanswered = message.timestamp();
+        }
+
+        if (message.status() != ChatMessage::Status::Read) {
+            m_unreadCount++;
+            if (message.priority() == ChatMessage::Priority::Urgent) {
+                m_unreadPriority = ChatMessage::Priority::Urgent;
+            }
+        }
+    }
+}
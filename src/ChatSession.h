@@ -25,8 +25,10 @@
 #pragma once
 
 #include "ChatMessage.h"
+#include "ChatSequenceTracker.h"
 #include <QList>
 #include <QString>
+#include <QStringList>
 #include <QDateTime>
 
 class ChatSession
@@ -36,28 +38,67 @@ public:
     {
         Online,
         Away,
-        Typing
+        Typing,
+        Offline
     };
 
+    // Typing notifications are leases which expire on the master unless the
+    // client refreshes them, so a lost "stopped typing" update is harmless
+    static constexpr int TypingLease = 5000;
+    static constexpr int TypingLeaseRefresh = 3000;
+
+    // Clients announce themselves at this interval unless other traffic
+    // already did so
+    static constexpr int HeartbeatInterval = 10000;
+
     ChatSession();
     explicit ChatSession(const QString& clientId);
     
     // Getters
     QString clientId() const { return m_clientId; }
     QString clientName() const { return m_clientName; }
+    int handle() const { return m_handle; }
     ClientStatus status() const { return m_status; }
     QList<ChatMessage> history() const { return m_history; }
     QDateTime lastActivity() const { return m_lastActivity; }
     int unreadCount() const { return m_unreadCount; }
+    int urgency() const;
+    QDateTime oldestUnanswered() const { return m_oldestUnanswered; }
     
     // Setters
     void setClientName(const QString& name) { m_clientName = name; }
+    void setHandle(int handle) { m_handle = handle; }
     void setStatus(ClientStatus status);
     
     // Message management
     void addMessage(const ChatMessage& message);
     void clearHistory();
     void markAllAsRead();
+
+    // Replication between masters: messages are inserted by timestamp, reads
+    // and clears name the messages the other master had when it read or
+    // cleared, so clock differences between the masters do not matter
+    void mergeMessage(const ChatMessage& message);
+    void markRead(const QStringList& messageIds);
+    void removeMessages(const QStringList& messageIds);
+
+    // Removes messages which expired by now, returns their ids
+    QStringList removeExpired(const QDateTime& now);
+    
+    // Delivery tracking: the master numbers its messages to the client and
+    // the client acknowledges them cumulatively, so a receipt moves a
+    // watermark instead of touching individual messages
+    quint32 nextSequence() { return ++m_lastSequence; }
+    quint32 lastSequence() const { return m_lastSequence; }
+    quint32 deliveredSequence() const { return m_deliveredSequence; }
+    quint32 readSequence() const { return m_readSequence; }
+    bool acknowledge(quint32 delivered, quint32 read);
+    ChatMessage::Status deliveryStatus(quint32 sequence) const;
+    // The master's own messages numbered first to last, for a client's resync
+    QList<ChatMessage> sentMessages(quint32 first, quint32 last) const;
+
+    // Gap detection on the client's numbered messages
+    ChatSequenceTracker& receivedSequences() { return m_receivedSequences; }
     
     // Utility
     QString statusString() const;
@@ -66,10 +107,18 @@ public:
 private:
     QString m_clientId;
     QString m_clientName;
+    int m_handle;
     ClientStatus m_status;
     QList<ChatMessage> m_history;
     QDateTime m_lastActivity;
     int m_unreadCount;
+    ChatMessage::Priority m_unreadPriority;
+    QDateTime m_oldestUnanswered;
+    quint32 m_lastSequence;
+    quint32 m_deliveredSequence;
+    quint32 m_readSequence;
+    ChatSequenceTracker m_receivedSequences;
     
     void updateLastActivity();
+    void recountUnread();
 };
@@ -1,45 +1,299 @@
 #include "ChatSignalListener.h"
+#include "ChatMetrics.h"
+#include "ChatRequestDatagram.h"
+#include "ChatRequestTransport.h"
 
 #include <QHostAddress>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QNetworkInterface>
+#include <QSocketNotifier>
+#include <QThread>
+#include <QTimer>
+
+#ifdef Q_OS_LINUX
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cstring>
+#endif
 
 namespace {
-static constexpr quint16 kChatSignalPort = 29665;
+constexpr auto APPLICATION_NAME = "ChatMaster";
+// Decoded requests are handed to the GUI thread at most once per frame
+constexpr int DRAIN_INTERVAL = 16;
+constexpr size_t QUEUE_CAPACITY = 1024;
+
+ChatCounter& requestsReceived()
+{
+    static auto& counter = ChatMetrics::instance().counter(
+        QStringLiteral("chat_requests_total"), QStringLiteral("F10 chat requests received by the listener"));
+    return counter;
 }
 
-ChatSignalListener::ChatSignalListener(QObject* parent)
-    : QObject(parent)
-    , m_socket(new QUdpSocket(this))
+ChatCounter& requestsDropped()
 {
-    m_socket->bind(QHostAddress::AnyIPv4, kChatSignalPort,
+    static auto& counter = ChatMetrics::instance().counter(
+        QStringLiteral("chat_requests_dropped_total"), QStringLiteral("F10 chat requests dropped on a full queue"));
+    return counter;
+}
+}
+
+ChatSignalReceiver::ChatSignalReceiver(ChatSignalListener* listener, const ChatSignalSettings& settings)
+    : QObject(nullptr)
+    , m_listener(listener)
+    , m_settings(settings)
+#ifdef Q_OS_LINUX
+    , m_socketDescriptor(-1)
+    , m_notifier(nullptr)
+#else
+    , m_socket(nullptr)
+#endif
+    , m_recentRequestIndex(0)
+{
+    memset(m_recentRequests, 0, sizeof(m_recentRequests));
+}
+
+ChatSignalReceiver::~ChatSignalReceiver()
+{
+#ifdef Q_OS_LINUX
+    if (m_socketDescriptor >= 0) {
+        ::close(m_socketDescriptor);
+    }
+#endif
+}
+
+void ChatSignalReceiver::open()
+{
+#ifdef Q_OS_LINUX
+    m_socketDescriptor = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (m_socketDescriptor < 0) {
+        return;
+    }
+
+    // Same sharing semantics as QUdpSocket::ShareAddress on Unix
+    const int reuse = 1;
+    ::setsockopt(m_socketDescriptor, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(ChatSignalSettings::Port);
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    if (::bind(m_socketDescriptor, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        ::close(m_socketDescriptor);
+        m_socketDescriptor = -1;
+        return;
+    }
+
+    m_notifier = new QSocketNotifier(m_socketDescriptor, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &ChatSignalReceiver::onReadyRead);
+#else
+    m_socket = new QUdpSocket(this);
+    m_socket->bind(QHostAddress::AnyIPv4, ChatSignalSettings::Port,
                    QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint);
-    connect(m_socket, &QUdpSocket::readyRead, this, &ChatSignalListener::onReadyRead);
+    connect(m_socket, &QUdpSocket::readyRead, this, &ChatSignalReceiver::onReadyRead);
+#endif
+
+    // Broadcast requests keep arriving on the wildcard address in either mode
+    if (m_settings.useMulticast()) {
+        joinGroup();
+    }
+}
+
+void ChatSignalReceiver::joinGroup()
+{
+    const QNetworkInterface networkInterface = QNetworkInterface::interfaceFromName(m_settings.interfaceName);
+
+#ifdef Q_OS_LINUX
+    ip_mreqn membership;
+    memset(&membership, 0, sizeof(membership));
+    membership.imr_multiaddr.s_addr = htonl(m_settings.group.toIPv4Address());
+    membership.imr_address.s_addr = htonl(INADDR_ANY);
+    membership.imr_ifindex = networkInterface.isValid() ? networkInterface.index() : 0;
+
+    ::setsockopt(m_socketDescriptor, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership));
+#else
+    if (networkInterface.isValid()) {
+        m_socket->joinMulticastGroup(m_settings.group, networkInterface);
+    } else {
+        m_socket->joinMulticastGroup(m_settings.group);
+    }
+#endif
 }
 
-void ChatSignalListener::onReadyRead()
+void ChatSignalReceiver::onReadyRead()
 {
+#ifdef Q_OS_LINUX
+    mmsghdr messages[BatchSize];
+    iovec vectors[BatchSize];
+    sockaddr_in senders[BatchSize];
+
+    for (;;) {
+        memset(messages, 0, sizeof(messages));
+        for (int i = 0; i < BatchSize; ++i) {
+            vectors[i].iov_base = m_buffers[i];
+            vectors[i].iov_len = MaxDatagramSize;
+            messages[i].msg_hdr.msg_iov = &vectors[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+            messages[i].msg_hdr.msg_name = &senders[i];
+            messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        }
+
+        const int count = ::recvmmsg(m_socketDescriptor, messages, BatchSize, MSG_DONTWAIT, nullptr);
+        if (count <= 0) {
+            break;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            handleDatagram(m_buffers[i], int(messages[i].msg_len),
+                           QHostAddress(ntohl(senders[i].sin_addr.s_addr)), ntohs(senders[i].sin_port));
+        }
+
+        if (count < BatchSize) {
+            break;
+        }
+    }
+#else
     while (m_socket->hasPendingDatagrams()) {
-        QByteArray data;
-        data.resize(int(m_socket->pendingDatagramSize()));
         QHostAddress peerAddress;
         quint16 peerPort = 0;
-        m_socket->readDatagram(data.data(), data.size(), &peerAddress, &peerPort);
-        const auto doc = QJsonDocument::fromJson(data);
+        const qint64 size = m_socket->readDatagram(m_buffers[0], MaxDatagramSize, &peerAddress, &peerPort);
+        if (size < 0) {
+            break;
+        }
+        handleDatagram(m_buffers[0], int(size), peerAddress, peerPort);
+    }
+#endif
+}
+
+void ChatSignalReceiver::handleDatagram(const char* data, int size, const QHostAddress& peerAddress, quint16 peerPort)
+{
+    ChatRequestRecord record;
+
+    ChatRequestDatagram request;
+    if (ChatRequestDatagram::decode(data, size, request)) {
+        if (request.requestId != 0) {
+            // Ack retries too, the previous ack may have been the one lost
+            acknowledge(request.requestId, peerAddress, peerPort);
+            if (isRecentRequest(request.requestId, peerAddress)) {
+                return;
+            }
+        }
+
+        record.host = request.host;
+        record.user = request.user;
+        record.timestamp = request.timestamp;
+    } else {
+        // Requests from workers predating the binary format
+        const auto doc = QJsonDocument::fromJson(QByteArray::fromRawData(data, size));
         if (!doc.isObject()) {
-            continue;
+            return;
         }
 
         const auto object = doc.object();
         if (object.value(QStringLiteral("type")) != QStringLiteral("chat_request")) {
-            continue;
+            return;
         }
 
-        const QString hostName = object.value(QStringLiteral("host")).toString();
-        if (hostName.isEmpty()) {
-            emit requestFromHost(peerAddress.toString());
-        } else {
-            emit requestFromHost(hostName);
-        }
+        record.host = object.value(QStringLiteral("host")).toString();
+        record.user = object.value(QStringLiteral("user")).toString();
+    }
+
+    if (record.host.isEmpty()) {
+        record.host = peerAddress.toString();
+    }
+
+    m_listener->enqueue(std::move(record));
+}
+
+void ChatSignalReceiver::acknowledge(quint32 requestId, const QHostAddress& peerAddress, quint16 peerPort)
+{
+    ChatRequestTransport::send(ChatRequestTransport::Kind::Ack, ChatRequestDatagram::encodeAck(requestId),
+                               peerAddress, peerPort,
+        [this](const QByteArray& ack, const QHostAddress& address, quint16 port) -> qint64 {
+#ifdef Q_OS_LINUX
+            sockaddr_in target;
+            memset(&target, 0, sizeof(target));
+            target.sin_family = AF_INET;
+            target.sin_port = htons(port);
+            target.sin_addr.s_addr = htonl(address.toIPv4Address());
+
+            return ::sendto(m_socketDescriptor, ack.constData(), size_t(ack.size()), MSG_DONTWAIT,
+                            reinterpret_cast<sockaddr*>(&target), sizeof(target));
+#else
+            return m_socket->writeDatagram(ack, address, port);
+#endif
+        });
+}
+
+bool ChatSignalReceiver::isRecentRequest(quint32 requestId, const QHostAddress& peerAddress)
+{
+    const quint64 key = (quint64(peerAddress.toIPv4Address()) << 32) | requestId;
+    if (m_recentRequestSet.contains(key)) {
+        return true;
+    }
+
+    m_recentRequestSet.remove(m_recentRequests[m_recentRequestIndex]);
+    m_recentRequests[m_recentRequestIndex] = key;
+    m_recentRequestIndex = (m_recentRequestIndex + 1) % RecentRequestCount;
+    m_recentRequestSet.insert(key);
+    return false;
+}
+
+ChatSignalListener::ChatSignalListener(QObject* parent)
+    : QObject(parent)
+    , m_thread(new QThread(this))
+    , m_drainTimer(new QTimer(this))
+    , m_queue(QUEUE_CAPACITY)
+    , m_drainPending(false)
+    , m_droppedRecords(0)
+{
+    m_drainTimer->setSingleShot(true);
+    m_drainTimer->setInterval(DRAIN_INTERVAL);
+    connect(m_drainTimer, &QTimer::timeout, this, &ChatSignalListener::drain);
+
+    auto* receiver = new ChatSignalReceiver(this, ChatSignalSettings::load(APPLICATION_NAME));
+    receiver->moveToThread(m_thread);
+    connect(m_thread, &QThread::started, receiver, &ChatSignalReceiver::open);
+    connect(m_thread, &QThread::finished, receiver, &QObject::deleteLater);
+
+    m_thread->setObjectName(QStringLiteral("ChatSignalListener"));
+    m_thread->start();
+}
+
+ChatSignalListener::~ChatSignalListener()
+{
+    m_thread->quit();
+    m_thread->wait();
+}
+
+void ChatSignalListener::enqueue(ChatRequestRecord&& record)
+{
+    requestsReceived().increment();
+    if (!m_queue.push(std::move(record))) {
+        m_droppedRecords.fetch_add(1, std::memory_order_relaxed);
+        requestsDropped().increment();
+    }
+
+    // Only the first record after a drain posts an event to the GUI thread
+    if (!m_drainPending.exchange(true)) {
+        QMetaObject::invokeMethod(this, [this]() {
+            if (!m_drainTimer->isActive()) {
+                m_drainTimer->start();
+            }
+        }, Qt::QueuedConnection);
+    }
+}
+
+void ChatSignalListener::drain()
+{
+    m_drainPending.store(false);
+
+    ChatRequestRecord record;
+    while (m_queue.pop(record)) {
+        emit requestFromHost(record.host);
     }
 }
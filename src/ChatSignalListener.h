@@ -1,7 +1,70 @@
 #pragma once
 
 #include <QObject>
+#include <QSet>
 #include <QUdpSocket>
+#include <atomic>
+
+#include "ChatSignalSettings.h"
+#include "ChatSpscQueue.h"
+
+class QSocketNotifier;
+class QThread;
+class QTimer;
+class ChatSignalListener;
+
+// Decoded F10 request handed from the receiver thread to the GUI thread
+struct ChatRequestRecord
+{
+    QString host;
+    QString user;
+    qint64 timestamp = 0;
+};
+
+// Owns the request socket inside the listener thread. Datagrams are read in
+// batches (recvmmsg() on Linux), validated and decoded there, so neither
+// unrelated traffic on the port nor JSON parsing touches the GUI thread.
+// Requests carrying an id are acked from here as well, and retries of a
+// recently seen id are acked again but not forwarded.
+class ChatSignalReceiver : public QObject
+{
+    Q_OBJECT
+
+public:
+    ChatSignalReceiver(ChatSignalListener* listener, const ChatSignalSettings& settings);
+    ~ChatSignalReceiver() override;
+
+public slots:
+    void open();
+
+private slots:
+    void onReadyRead();
+
+private:
+    static constexpr int BatchSize = 32;
+    static constexpr int MaxDatagramSize = 1500;
+    static constexpr int RecentRequestCount = 256;
+
+    void handleDatagram(const char* data, int size, const QHostAddress& peerAddress, quint16 peerPort);
+    void joinGroup();
+    void acknowledge(quint32 requestId, const QHostAddress& peerAddress, quint16 peerPort);
+    bool isRecentRequest(quint32 requestId, const QHostAddress& peerAddress);
+
+    ChatSignalListener* m_listener;
+    const ChatSignalSettings m_settings;
+#ifdef Q_OS_LINUX
+    int m_socketDescriptor;
+    QSocketNotifier* m_notifier;
+#else
+    QUdpSocket* m_socket;
+#endif
+    char m_buffers[BatchSize][MaxDatagramSize];
+
+    // Ring of the last (peer, request id) keys plus a set for lookups
+    quint64 m_recentRequests[RecentRequestCount];
+    int m_recentRequestIndex;
+    QSet<quint64> m_recentRequestSet;
+};
 
 class ChatSignalListener : public QObject
 {
@@ -9,13 +72,23 @@ class ChatSignalListener : public QObject
 
 public:
     explicit ChatSignalListener(QObject* parent = nullptr);
+    ~ChatSignalListener() override;
+
+    // Called from the receiver thread
+    void enqueue(ChatRequestRecord&& record);
+
+    quint64 droppedRecords() const { return m_droppedRecords.load(std::memory_order_relaxed); }
 
 signals:
     void requestFromHost(const QString& hostName);
 
 private slots:
-    void onReadyRead();
+    void drain();
 
 private:
-    QUdpSocket* m_socket;
+    QThread* m_thread;
+    QTimer* m_drainTimer;
+    ChatSpscQueue<ChatRequestRecord> m_queue;
+    std::atomic<bool> m_drainPending;
+    std::atomic<quint64> m_droppedRecords;
 };
@@ -0,0 +1,28 @@
+#include "ChatSignalSettings.h"
+
+#include <QSettings>
+
+namespace {
+constexpr auto ORGANIZATION_NAME = "Veyon";
+constexpr auto SETTINGS_MODE = "requestMode";
+constexpr auto SETTINGS_GROUP = "multicastGroup";
+constexpr auto SETTINGS_TTL = "multicastTtl";
+constexpr auto SETTINGS_INTERFACE = "multicastInterface";
+// Organization-local scope, see RFC 2365
+constexpr auto DEFAULT_GROUP = "239.255.29.65";
+}
+
+ChatSignalSettings ChatSignalSettings::load(const char* applicationName)
+{
+    const QSettings settings(ORGANIZATION_NAME, applicationName);
+
+    ChatSignalSettings result;
+    if (settings.value(SETTINGS_MODE).toString().compare(QStringLiteral("multicast"), Qt::CaseInsensitive) == 0) {
+        result.mode = Mode::Multicast;
+    }
+    result.group = QHostAddress(settings.value(SETTINGS_GROUP, DEFAULT_GROUP).toString());
+    result.ttl = qBound(1, settings.value(SETTINGS_TTL, 1).toInt(), 255);
+    result.interfaceName = settings.value(SETTINGS_INTERFACE).toString();
+
+    return result;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <QHostAddress>
+#include <QString>
+
+// Transport settings for F10 chat requests, shared by the student's worker
+// and the master's listener. Requests are broadcast on the subnet by default.
+// In multicast mode they go to a group which only masters join, so student
+// machines are not woken up by each other's requests.
+struct ChatSignalSettings
+{
+    enum class Mode
+    {
+        Broadcast,
+        Multicast
+    };
+
+    static constexpr quint16 Port = 29665;
+
+    Mode mode = Mode::Broadcast;
+    QHostAddress group;
+    int ttl = 1;
+    QString interfaceName;
+
+    bool useMulticast() const { return mode == Mode::Multicast && group.isMulticast(); }
+
+    // Reads the settings from the given Veyon chat settings application
+    static ChatSignalSettings load(const char* applicationName);
+};
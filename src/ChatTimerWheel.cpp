@@ -0,0 +1,145 @@
+/*
+ * ChatTimerWheel.cpp - implementation of ChatTimerWheel class
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include "ChatTimerWheel.h"
+#include <QTimer>
+
+ChatTimerWheel::ChatTimerWheel(int tickInterval, int slotCount, int levelCount, QObject* parent) :
+    QObject(parent),
+    m_timer(new QTimer(this)),
+    m_tickInterval(qMax(1, tickInterval)),
+    m_slotCount(qMax(2, slotCount)),
+    m_levelCount(qMax(1, levelCount)),
+    m_now(0),
+    m_slots(m_slotCount * m_levelCount)
+{
+    m_timer->setInterval(m_tickInterval);
+    connect(m_timer, &QTimer::timeout, this, &ChatTimerWheel::advance);
+}
+
+void ChatTimerWheel::schedule(const QString& key, int delay)
+{
+    cancel(key);
+
+    // Round up so that a key never expires before its delay has passed
+    const qint64 ticks = qMax(1, (delay + m_tickInterval - 1) / m_tickInterval);
+    place(key, m_now + ticks);
+
+    if (!m_timer->isActive()) {
+        m_timer->start();
+    }
+}
+
+void ChatTimerWheel::cancel(const QString& key)
+{
+    const auto it = m_entries.constFind(key);
+    if (it == m_entries.constEnd()) {
+        return;
+    }
+
+    slot(it->level, it->slot).remove(key);
+    m_entries.erase(it);
+
+    if (m_entries.isEmpty()) {
+        m_timer->stop();
+    }
+}
+
+void ChatTimerWheel::clear()
+{
+    for (auto& keys : m_slots) {
+        keys.clear();
+    }
+    m_entries.clear();
+    m_timer->stop();
+}
+
+void ChatTimerWheel::place(const QString& key, qint64 due)
+{
+    const qint64 delta = due - m_now;
+
+    // Pick the finest level whose span still covers the delay. Keys beyond
+    // the top level are parked there and re-placed whenever it cascades.
+    int level = 0;
+    qint64 resolution = 1;
+    while (level < m_levelCount - 1 && delta >= resolution * m_slotCount) {
+        resolution *= m_slotCount;
+        ++level;
+    }
+
+    Entry entry;
+    entry.due = due;
+    entry.level = level;
+    entry.slot = int((due / resolution) % m_slotCount);
+
+    slot(entry.level, entry.slot).insert(key);
+    m_entries.insert(key, entry);
+}
+
+void ChatTimerWheel::advance()
+{
+    ++m_now;
+
+    // Cascade every higher level whose slot boundary has been reached
+    qint64 resolution = 1;
+    for (int level = 1; level < m_levelCount; ++level) {
+        resolution *= m_slotCount;
+        if (m_now % resolution != 0) {
+            break;
+        }
+
+        const int index = int((m_now / resolution) % m_slotCount);
+        const QSet<QString> keys = std::move(slot(level, index));
+        slot(level, index).clear();
+
+        for (const QString& key : keys) {
+            const qint64 due = m_entries.value(key).due;
+            m_entries.remove(key);
+            place(key, due);
+        }
+    }
+
+    QStringList expiredKeys;
+    QSet<QString>& current = slot(0, int(m_now % m_slotCount));
+
+    for (auto it = current.begin(); it != current.end(); ) {
+        const auto entry = m_entries.constFind(*it);
+        if (entry != m_entries.constEnd() && entry->due > m_now) {
+            ++it;
+            continue;
+        }
+
+        expiredKeys.append(*it);
+        m_entries.remove(*it);
+        it = current.erase(it);
+    }
+
+    if (m_entries.isEmpty()) {
+        m_timer->stop();
+    }
+
+    if (!expiredKeys.isEmpty()) {
+        emit expired(expiredKeys);
+    }
+}
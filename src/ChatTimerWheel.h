@@ -0,0 +1,80 @@
+/*
+ * ChatTimerWheel.h - declaration of ChatTimerWheel class
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#pragma once
+
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+
+class QTimer;
+
+// Hierarchical timer wheel driven by a single QTimer. Level 0 has a
+// resolution of one tick, every further level covers slotCount times the
+// span of the previous one and cascades its keys down when reached.
+// Scheduling, rescheduling and cancelling a key are O(1), all keys expiring
+// in the same tick are reported with one signal. The timer only runs while
+// keys are scheduled.
+class ChatTimerWheel : public QObject
+{
+    Q_OBJECT
+
+public:
+    ChatTimerWheel(int tickInterval, int slotCount, int levelCount = 1, QObject* parent = nullptr);
+
+    void schedule(const QString& key, int delay);
+    void cancel(const QString& key);
+    void clear();
+
+    bool isScheduled(const QString& key) const { return m_entries.contains(key); }
+    int size() const { return m_entries.size(); }
+    int tickInterval() const { return m_tickInterval; }
+
+signals:
+    void expired(const QStringList& keys);
+
+private slots:
+    void advance();
+
+private:
+    struct Entry
+    {
+        qint64 due;
+        int level;
+        int slot;
+    };
+
+    void place(const QString& key, qint64 due);
+    QSet<QString>& slot(int level, int index) { return m_slots[level * m_slotCount + index]; }
+
+    QTimer* m_timer;
+    int m_tickInterval;
+    int m_slotCount;
+    int m_levelCount;
+    qint64 m_now;
+    QVector<QSet<QString>> m_slots;
+    QHash<QString, Entry> m_entries;
+};
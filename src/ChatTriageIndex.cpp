@@ -0,0 +1,221 @@
+/*
+ * ChatTriageIndex.cpp - implementation of ChatTriageIndex class
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include "ChatTriageIndex.h"
+#include <QRandomGenerator>
+
+bool ChatTriageKey::operator<(const ChatTriageKey& other) const
+{
+    if (unread != other.unread) {
+        return unread;
+    }
+    if (urgency != other.urgency) {
+        return urgency > other.urgency;
+    }
+    if (oldestUnanswered != other.oldestUnanswered) {
+        return oldestUnanswered < other.oldestUnanswered;
+    }
+    return handle < other.handle;
+}
+
+bool ChatTriageKey::operator==(const ChatTriageKey& other) const
+{
+    return unread == other.unread &&
+           urgency == other.urgency &&
+           oldestUnanswered == other.oldestUnanswered &&
+           handle == other.handle;
+}
+
+ChatTriageIndex::ChatTriageIndex()
+{
+    // Every level of the head initially points past the end, one step away
+    m_head.next.assign(MaxLevels, nullptr);
+    m_head.width.assign(MaxLevels, 1);
+}
+
+ChatTriageIndex::~ChatTriageIndex()
+{
+    clear();
+}
+
+void ChatTriageIndex::update(const ChatTriageKey& key)
+{
+    const auto it = m_nodes.constFind(key.handle);
+    if (it != m_nodes.constEnd()) {
+        if (it.value()->key == key) {
+            return;
+        }
+        removeNode(it.value()->key);
+    }
+
+    insertNode(key);
+}
+
+void ChatTriageIndex::remove(int handle)
+{
+    const auto it = m_nodes.constFind(handle);
+    if (it != m_nodes.constEnd()) {
+        removeNode(it.value()->key);
+    }
+}
+
+void ChatTriageIndex::clear()
+{
+    qDeleteAll(m_nodes);
+    m_nodes.clear();
+    m_head.next.assign(MaxLevels, nullptr);
+    m_head.width.assign(MaxLevels, 1);
+}
+
+ChatTriageKey ChatTriageIndex::key(int handle) const
+{
+    const auto it = m_nodes.constFind(handle);
+    return it != m_nodes.constEnd() ? it.value()->key : ChatTriageKey();
+}
+
+int ChatTriageIndex::rank(int handle) const
+{
+    const auto it = m_nodes.constFind(handle);
+    if (it == m_nodes.constEnd()) {
+        return -1;
+    }
+
+    return countLess(it.value()->key);
+}
+
+int ChatTriageIndex::countLess(const ChatTriageKey& key) const
+{
+    int steps = 0;
+    const Node* node = &m_head;
+
+    for (int level = MaxLevels - 1; level >= 0; --level) {
+        while (node->next[level] && node->next[level]->key < key) {
+            steps += node->width[level];
+            node = node->next[level];
+        }
+    }
+
+    return steps;
+}
+
+int ChatTriageIndex::handleAt(int rank) const
+{
+    if (rank < 0 || rank >= size()) {
+        return -1;
+    }
+
+    // Widths count positions starting at 1 for the first real node
+    int remaining = rank + 1;
+    const Node* node = &m_head;
+
+    for (int level = MaxLevels - 1; level >= 0; --level) {
+        while (node->next[level] && node->width[level] <= remaining) {
+            remaining -= node->width[level];
+            node = node->next[level];
+        }
+    }
+
+    return node->key.handle;
+}
+
+void ChatTriageIndex::insertNode(const ChatTriageKey& key)
+{
+    const int height = randomLevel();
+
+    auto* newNode = new Node;
+    newNode->key = key;
+    newNode->next.assign(height, nullptr);
+    newNode->width.assign(height, 0);
+
+    Node* chain[MaxLevels];
+    int stepsAtLevel[MaxLevels] = {};
+
+    Node* node = &m_head;
+    for (int level = MaxLevels - 1; level >= 0; --level) {
+        while (node->next[level] && node->next[level]->key < key) {
+            stepsAtLevel[level] += node->width[level];
+            node = node->next[level];
+        }
+        chain[level] = node;
+    }
+
+    int steps = 0;
+    for (int level = 0; level < height; ++level) {
+        Node* previous = chain[level];
+        newNode->next[level] = previous->next[level];
+        previous->next[level] = newNode;
+        newNode->width[level] = previous->width[level] - steps;
+        previous->width[level] = steps + 1;
+        steps += stepsAtLevel[level];
+    }
+
+    for (int level = height; level < MaxLevels; ++level) {
+        ++chain[level]->width[level];
+    }
+
+    m_nodes.insert(key.handle, newNode);
+}
+
+void ChatTriageIndex::removeNode(const ChatTriageKey& key)
+{
+    Node* chain[MaxLevels];
+
+    Node* node = &m_head;
+    for (int level = MaxLevels - 1; level >= 0; --level) {
+        while (node->next[level] && node->next[level]->key < key) {
+            node = node->next[level];
+        }
+        chain[level] = node;
+    }
+
+    Node* target = chain[0]->next[0];
+    if (!target || !(target->key == key)) {
+        return;
+    }
+
+    const int height = int(target->next.size());
+    for (int level = 0; level < height; ++level) {
+        Node* previous = chain[level];
+        previous->width[level] += target->width[level] - 1;
+        previous->next[level] = target->next[level];
+    }
+
+    for (int level = height; level < MaxLevels; ++level) {
+        --chain[level]->width[level];
+    }
+
+    m_nodes.remove(key.handle);
+    delete target;
+}
+
+int ChatTriageIndex::randomLevel()
+{
+    // Geometric distribution with p = 1/2, one random word per insertion
+    const quint32 bits = QRandomGenerator::global()->generate();
+    int level = 1;
+    while (level < MaxLevels && (bits & (1u << (level - 1)))) {
+        ++level;
+    }
+    return level;
+}
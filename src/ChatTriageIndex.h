@@ -0,0 +1,86 @@
+/*
+ * ChatTriageIndex.h - declaration of ChatTriageIndex class
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#pragma once
+
+#include <QHash>
+#include <QtGlobal>
+#include <vector>
+
+// Sort key of a session in triage order: unread sessions first, then more
+// urgent ones, then the one waiting longest for an answer
+struct ChatTriageKey
+{
+    bool unread = false;
+    int urgency = 0;
+    qint64 oldestUnanswered = 0;
+    int handle = -1;
+
+    bool operator<(const ChatTriageKey& other) const;
+    bool operator==(const ChatTriageKey& other) const;
+};
+
+// Indexable skip list of session handles ordered by ChatTriageKey. Updates,
+// rank and positional lookups are all O(log n), so a single session event
+// never requires re-sorting the whole client list.
+class ChatTriageIndex
+{
+public:
+    ChatTriageIndex();
+    ~ChatTriageIndex();
+
+    ChatTriageIndex(const ChatTriageIndex&) = delete;
+    ChatTriageIndex& operator=(const ChatTriageIndex&) = delete;
+
+    void update(const ChatTriageKey& key);
+    void remove(int handle);
+    void clear();
+
+    bool contains(int handle) const { return m_nodes.contains(handle); }
+    ChatTriageKey key(int handle) const;
+    int size() const { return m_nodes.size(); }
+
+    // Position of the given handle, or -1 if it is not indexed
+    int rank(int handle) const;
+    // Number of indexed keys ordered before the given key
+    int countLess(const ChatTriageKey& key) const;
+    int handleAt(int rank) const;
+
+private:
+    static constexpr int MaxLevels = 20;
+
+    struct Node
+    {
+        ChatTriageKey key;
+        std::vector<Node*> next;
+        std::vector<int> width;
+    };
+
+    void insertNode(const ChatTriageKey& key);
+    void removeNode(const ChatTriageKey& key);
+    static int randomLevel();
+
+    Node m_head;
+    QHash<int, Node*> m_nodes;
+};
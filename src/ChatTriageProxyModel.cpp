@@ -0,0 +1,201 @@
+/*
+ * ChatTriageProxyModel.cpp - implementation of ChatTriageProxyModel class
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include "ChatTriageProxyModel.h"
+#include "ChatClientListModel.h"
+
+ChatTriageProxyModel::ChatTriageProxyModel(QObject* parent) :
+    QAbstractProxyModel(parent),
+    m_clientModel(nullptr)
+{
+}
+
+void ChatTriageProxyModel::setSourceModel(QAbstractItemModel* sourceModel)
+{
+    beginResetModel();
+
+    if (m_clientModel) {
+        disconnect(m_clientModel, nullptr, this, nullptr);
+    }
+
+    QAbstractProxyModel::setSourceModel(sourceModel);
+    m_clientModel = qobject_cast<ChatClientListModel*>(sourceModel);
+
+    if (m_clientModel) {
+        connect(m_clientModel, &QAbstractItemModel::dataChanged,
+                this, &ChatTriageProxyModel::onSourceDataChanged);
+        connect(m_clientModel, &QAbstractItemModel::rowsInserted,
+                this, &ChatTriageProxyModel::onSourceRowsInserted);
+        connect(m_clientModel, &QAbstractItemModel::rowsAboutToBeRemoved,
+                this, &ChatTriageProxyModel::onSourceRowsAboutToBeRemoved);
+        connect(m_clientModel, &QAbstractItemModel::modelReset,
+                this, &ChatTriageProxyModel::rebuild);
+        connect(m_clientModel, &QAbstractItemModel::layoutChanged,
+                this, &ChatTriageProxyModel::rebuild);
+    }
+
+    m_index.clear();
+    if (m_clientModel) {
+        for (int row = 0; row < m_clientModel->rowCount(); ++row) {
+            m_index.update(keyForSourceRow(row));
+        }
+    }
+
+    endResetModel();
+}
+
+QModelIndex ChatTriageProxyModel::mapToSource(const QModelIndex& proxyIndex) const
+{
+    if (!m_clientModel || !proxyIndex.isValid()) {
+        return QModelIndex();
+    }
+
+    const int sourceRow = m_clientModel->rowOfHandle(m_index.handleAt(proxyIndex.row()));
+    return sourceRow >= 0 ? m_clientModel->index(sourceRow, proxyIndex.column()) : QModelIndex();
+}
+
+QModelIndex ChatTriageProxyModel::mapFromSource(const QModelIndex& sourceIndex) const
+{
+    if (!m_clientModel || !sourceIndex.isValid()) {
+        return QModelIndex();
+    }
+
+    const int rank = m_index.rank(sourceIndex.data(ChatClientListModel::HandleRole).toInt());
+    return rank >= 0 ? createIndex(rank, sourceIndex.column()) : QModelIndex();
+}
+
+QModelIndex ChatTriageProxyModel::index(int row, int column, const QModelIndex& parent) const
+{
+    if (parent.isValid() || row < 0 || row >= m_index.size() || column != 0) {
+        return QModelIndex();
+    }
+
+    return createIndex(row, column);
+}
+
+QModelIndex ChatTriageProxyModel::parent(const QModelIndex& child) const
+{
+    Q_UNUSED(child)
+    return QModelIndex();
+}
+
+int ChatTriageProxyModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : m_index.size();
+}
+
+int ChatTriageProxyModel::columnCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : 1;
+}
+
+void ChatTriageProxyModel::onSourceDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight)
+{
+    for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+        updateSourceRow(row);
+    }
+}
+
+void ChatTriageProxyModel::onSourceRowsInserted(const QModelIndex& parent, int first, int last)
+{
+    if (parent.isValid()) {
+        return;
+    }
+
+    for (int row = first; row <= last; ++row) {
+        const ChatTriageKey key = keyForSourceRow(row);
+        const int rank = m_index.countLess(key);
+        beginInsertRows(QModelIndex(), rank, rank);
+        m_index.update(key);
+        endInsertRows();
+    }
+}
+
+void ChatTriageProxyModel::onSourceRowsAboutToBeRemoved(const QModelIndex& parent, int first, int last)
+{
+    if (parent.isValid()) {
+        return;
+    }
+
+    for (int row = first; row <= last; ++row) {
+        const int handle = m_clientModel->index(row).data(ChatClientListModel::HandleRole).toInt();
+        const int rank = m_index.rank(handle);
+        if (rank < 0) {
+            continue;
+        }
+        beginRemoveRows(QModelIndex(), rank, rank);
+        m_index.remove(handle);
+        endRemoveRows();
+    }
+}
+
+void ChatTriageProxyModel::rebuild()
+{
+    beginResetModel();
+    m_index.clear();
+    if (m_clientModel) {
+        for (int row = 0; row < m_clientModel->rowCount(); ++row) {
+            m_index.update(keyForSourceRow(row));
+        }
+    }
+    endResetModel();
+}
+
+ChatTriageKey ChatTriageProxyModel::keyForSourceRow(int sourceRow) const
+{
+    const QModelIndex sourceIndex = m_clientModel->index(sourceRow);
+
+    ChatTriageKey key;
+    key.unread = sourceIndex.data(ChatClientListModel::UnreadCountRole).toInt() > 0;
+    key.urgency = sourceIndex.data(ChatClientListModel::UrgencyRole).toInt();
+    key.oldestUnanswered = sourceIndex.data(ChatClientListModel::OldestUnansweredRole).toLongLong();
+    key.handle = sourceIndex.data(ChatClientListModel::HandleRole).toInt();
+    return key;
+}
+
+void ChatTriageProxyModel::updateSourceRow(int sourceRow)
+{
+    const ChatTriageKey newKey = keyForSourceRow(sourceRow);
+    const int oldRank = m_index.rank(newKey.handle);
+    if (oldRank < 0) {
+        return;
+    }
+
+    const ChatTriageKey oldKey = m_index.key(newKey.handle);
+    if (!(oldKey == newKey)) {
+        // The row itself is still indexed, so it must not count towards its new position
+        const int newRank = m_index.countLess(newKey) - (oldKey < newKey ? 1 : 0);
+        if (newRank != oldRank) {
+            beginMoveRows(QModelIndex(), oldRank, oldRank,
+                          QModelIndex(), newRank > oldRank ? newRank + 1 : newRank);
+            m_index.update(newKey);
+            endMoveRows();
+        } else {
+            m_index.update(newKey);
+        }
+    }
+
+    const QModelIndex proxyIndex = index(m_index.rank(newKey.handle), 0);
+    emit dataChanged(proxyIndex, proxyIndex);
+}
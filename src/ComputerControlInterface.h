@@ -2,31 +2,57 @@
 
 #include <QList>
 #include <QString>
+#include <functional>
 
 class FeatureMessage;
 
 class Computer
 {
 public:
+    explicit Computer(const QString& hostAddress = QString()) :
+        m_hostAddress(hostAddress)
+    {
+    }
+
     QString hostAddress() const
     {
-        return QString();
+        return m_hostAddress;
     }
+
+private:
+    QString m_hostAddress;
 };
 
 class ComputerControlInterface
 {
 public:
+    // Receives the messages sent to the computer, e.g. a simulated student
+    using Sink = std::function<void(const FeatureMessage&)>;
+
+    ComputerControlInterface() = default;
+
+    explicit ComputerControlInterface(const QString& hostAddress, Sink sink = Sink()) :
+        m_computer(hostAddress),
+        m_sink(std::move(sink))
+    {
+    }
+
     Computer computer() const
     {
-        return Computer();
+        return m_computer;
     }
 
     void sendFeatureMessage(const FeatureMessage& message, bool synchronous)
     {
-        (void)message;
         (void)synchronous;
+        if (m_sink) {
+            m_sink(message);
+        }
     }
+
+private:
+    Computer m_computer;
+    Sink m_sink;
 };
 
 using ComputerControlInterfaceList = QList<ComputerControlInterface*>;
@@ -2,12 +2,33 @@
 
 #include "FeatureMessage.h"
 
+#include <functional>
+
 class VeyonWorkerInterface
 {
 public:
-    void sendFeatureMessage(const FeatureMessage& message)
+    // Receives the messages the worker sends to the master
+    using Sink = std::function<void(const FeatureMessage&)>;
+
+    VeyonWorkerInterface() = default;
+
+    explicit VeyonWorkerInterface(Sink sink) :
+        m_sink(std::move(sink))
     {
-        (void)message;
     }
+
+    // False if the message could not be handed to the server, like Veyon's
+    // sendFeatureMessageReply()
+    bool sendFeatureMessage(const FeatureMessage& message)
+    {
+        if (!m_sink) {
+            return false;
+        }
+        m_sink(message);
+        return true;
+    }
+
+private:
+    Sink m_sink;
 };
 
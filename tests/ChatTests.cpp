@@ -0,0 +1,801 @@
+/*
+ * ChatTests.cpp - behavioural tests for the chat core
+ *
+ * Copyright (c) 2025 Manus AI <manus@example.com>
+ *
+ * This file is part of Veyon Chat Plugin - https://github.com/veyon/veyon-chat-plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QHostInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLineEdit>
+#include <QRandomGenerator>
+#include <QScrollBar>
+#include <QSettings>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTemporaryFile>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTextEdit>
+#include <QThread>
+#include <QTimer>
+#include <QUdpSocket>
+#include <QUuid>
+#include <QtEndian>
+#include <QtTest>
+#include <algorithm>
+#include <atomic>
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+#include "ChatClientWidget.h"
+#include "ChatFileTransfer.h"
+#include "ChatMetricsServer.h"
+#include "ChatReplicator.h"
+#include "ChatRequestDatagram.h"
+#include "ChatRequestTransport.h"
+#include "ChatRequestWorker.h"
+#include "ChatServiceClient.h"
+#include "ChatSession.h"
+#include "ChatSignalListener.h"
+#include "ChatSignalSettings.h"
+#include "ChatTimerWheel.h"
+
+namespace {
+constexpr auto ORGANIZATION_NAME = "Veyon";
+constexpr auto MASTER_APPLICATION_NAME = "ChatMaster";
+constexpr auto CLIENT_APPLICATION_NAME = "ChatClient";
+constexpr auto REPLICATION_PORT_VARIABLE = "VEYON_CHAT_REPLICATION_PORT";
+constexpr auto REPLICATION_PEERS_VARIABLE = "VEYON_CHAT_REPLICATION_PEERS";
+
+// Time for a background thread to bind its socket
+constexpr int STARTUP_DELAY = 200;
+
+qint64 percentile(QVector<qint64> values, double fraction)
+{
+    if (values.isEmpty()) {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    return values.at(qMin(values.size() - 1, int(fraction * values.size())));
+}
+
+// Resident set size of the test process, -1 where unknown
+qint64 residentKiB()
+{
+#ifdef Q_OS_LINUX
+    QFile statm(QStringLiteral("/proc/self/statm"));
+    if (statm.open(QIODevice::ReadOnly)) {
+        const QList<QByteArray> fields = statm.readAll().split(' ');
+        if (fields.size() > 1) {
+            return fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE) / 1024;
+        }
+    }
+#endif
+    return -1;
+}
+
+quint16 freeTcpPort()
+{
+    QTcpServer server;
+    server.listen(QHostAddress::LocalHost);
+    return server.serverPort();
+}
+
+QStringList messageIds(const ChatSession& session)
+{
+    QStringList ids;
+    const auto history = session.history();
+    for (const auto& message : history) {
+        ids.append(message.messageId());
+    }
+    return ids;
+}
+
+// Length-prefixed JSON, as replicators exchange it
+QByteArray replicationFrame(const QJsonObject& object)
+{
+    const QByteArray payload = QJsonDocument(object).toJson(QJsonDocument::Compact);
+    QByteArray frame(int(sizeof(quint32)), Qt::Uninitialized);
+    qToBigEndian<quint32>(quint32(payload.size()), frame.data());
+    return frame + payload;
+}
+
+int clientWindowCount()
+{
+    int count = 0;
+    const auto widgets = QApplication::topLevelWidgets();
+    for (const auto* widget : widgets) {
+        count += qobject_cast<const ChatClientWidget*>(widget) != nullptr;
+    }
+    return count;
+}
+
+// Sends requests to the listener over loopback, which broadcasts may not
+// reach, and loses the first datagrams of each kind
+class LossyRequestTransport : public ChatRequestTransport
+{
+public:
+    LossyRequestTransport(int lostRequests, int lostAcks) :
+        m_lostRequests(lostRequests),
+        m_lostAcks(lostAcks)
+    {
+    }
+
+    qint64 transmit(Kind kind, const QByteArray& datagram, const QHostAddress& address, quint16 port,
+                    const SendFunction& direct) override
+    {
+        if (kind == Kind::Request) {
+            if (requests++ < m_lostRequests) {
+                return datagram.size();
+            }
+            return direct(datagram, QHostAddress(QHostAddress::LocalHost), port);
+        }
+
+        if (acks++ < m_lostAcks) {
+            return datagram.size();
+        }
+        return direct(datagram, address, port);
+    }
+
+    std::atomic<int> requests{0};
+    std::atomic<int> acks{0};
+
+private:
+    const int m_lostRequests;
+    const int m_lostAcks;
+};
+}
+
+class ChatTests : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanup();
+
+    void typingLeaseMessageCount();
+    void typingLeaseExpiry();
+
+    void requestLatency();
+    void requestFlood();
+    void requestMulticastLoopback();
+    void requestRetryUntilAcked();
+
+    void resyncAfterLoss();
+    void fileTransferThroughput();
+    void replicationTwoMasters();
+    void replicationOutOfOrder();
+
+    void clientStartupFootprint();
+    void scrollbackPageIn();
+
+    void metricsSocketInUse();
+
+private:
+    QTemporaryDir m_settingsDirectory;
+};
+
+void ChatTests::initTestCase()
+{
+    // Settings, scrollback and outbox files go to a test location
+    QStandardPaths::setTestModeEnabled(true);
+    QVERIFY(m_settingsDirectory.isValid());
+    QSettings::setPath(QSettings::NativeFormat, QSettings::UserScope, m_settingsDirectory.path());
+}
+
+// Every test starts with the default settings and transport
+void ChatTests::cleanup()
+{
+    ChatRequestTransport::install(nullptr);
+    qunsetenv(REPLICATION_PORT_VARIABLE);
+    qunsetenv(REPLICATION_PEERS_VARIABLE);
+    QSettings(ORGANIZATION_NAME, MASTER_APPLICATION_NAME).clear();
+    QSettings(ORGANIZATION_NAME, CLIENT_APPLICATION_NAME).clear();
+}
+
+// A student typing for a few seconds. Each keystroke used to reach the master
+// as a status update, with leases only the start, one refresh and the stop do.
+void ChatTests::typingLeaseMessageCount()
+{
+    constexpr int Keystrokes = 48;
+    constexpr int KeyInterval = 80;
+
+    ChatClientWidget widget;
+    auto* input = widget.findChild<QLineEdit*>(QStringLiteral("messageInput"));
+    QVERIFY(input);
+
+    QList<ChatSession::ClientStatus> updates;
+    connect(&widget, &ChatClientWidget::statusChanged, this, [&updates](ChatSession::ClientStatus status) {
+        updates.append(status);
+    });
+
+    for (int i = 0; i < Keystrokes; ++i) {
+        input->insert(QStringLiteral("a"));
+        QTest::qWait(KeyInterval);
+    }
+
+    // Going idle ends the lease explicitly
+    QTRY_VERIFY_WITH_TIMEOUT(!updates.isEmpty() && updates.last() == ChatSession::ClientStatus::Online, 5000);
+
+    QCOMPARE(updates.count(ChatSession::ClientStatus::Typing), 2);
+    QCOMPARE(updates.size(), 3);
+
+    qInfo("%d keystrokes, %d status updates (%.1fx fewer)", Keystrokes, int(updates.size()),
+          double(Keystrokes) / updates.size());
+}
+
+// The master drops a lease that is not refreshed in time, refreshed leases
+// live on
+void ChatTests::typingLeaseExpiry()
+{
+    ChatTimerWheel wheel(50, 64);
+    QSignalSpy expired(&wheel, &ChatTimerWheel::expired);
+
+    wheel.schedule(QStringLiteral("pc-01"), 300);
+    wheel.schedule(QStringLiteral("pc-02"), 300);
+    QTest::qWait(200);
+    wheel.schedule(QStringLiteral("pc-02"), 300);
+
+    QTRY_COMPARE_WITH_TIMEOUT(expired.count(), 1, 1000);
+    QCOMPARE(expired.at(0).at(0).toStringList(), QStringList{QStringLiteral("pc-01")});
+    QVERIFY(wheel.isScheduled(QStringLiteral("pc-02")));
+
+    QTRY_COMPARE_WITH_TIMEOUT(expired.count(), 2, 1000);
+    QCOMPARE(expired.at(1).at(0).toStringList(), QStringList{QStringLiteral("pc-02")});
+    QCOMPARE(wheel.size(), 0);
+}
+
+// Requests sent over loopback to the master's listener, from the datagram
+// leaving the socket to requestFromHost on the GUI thread
+void ChatTests::requestLatency()
+{
+    constexpr int Requests = 200;
+    constexpr qint64 MaxLatency = 100 * 1000 * 1000;
+
+    ChatSignalListener listener;
+    QSignalSpy received(&listener, &ChatSignalListener::requestFromHost);
+    QTest::qWait(STARTUP_DELAY);
+
+    QElapsedTimer clock;
+    clock.start();
+    qint64 sentAt = 0;
+    QVector<qint64> latencies;
+    connect(&listener, &ChatSignalListener::requestFromHost, this, [&]() {
+        latencies.append(clock.nsecsElapsed() - sentAt);
+    });
+
+    QUdpSocket socket;
+    QByteArray datagram = ChatRequestDatagram::encode(QStringLiteral("pc-01"), QStringLiteral("student"));
+    for (int i = 1; i <= Requests; ++i) {
+        ChatRequestDatagram::setRequestId(datagram, quint32(i));
+        ChatRequestDatagram::setTimestamp(datagram, QDateTime::currentMSecsSinceEpoch());
+        sentAt = clock.nsecsElapsed();
+        QCOMPARE(socket.writeDatagram(datagram, QHostAddress::LocalHost, ChatSignalSettings::Port), qint64(datagram.size()));
+        QVERIFY(received.wait(1000));
+    }
+    QCOMPARE(received.takeFirst().at(0).toString(), QStringLiteral("pc-01"));
+
+    const qint64 p50 = percentile(latencies, 0.5);
+    const qint64 p99 = percentile(latencies, 0.99);
+    qInfo("request latency over %d requests: p50 %lld us, p99 %lld us", Requests, p50 / 1000, p99 / 1000);
+    QVERIFY(p99 < MaxLatency);
+
+    // Workers predating the binary format are still understood
+    const QByteArray legacy = QJsonDocument(QJsonObject{
+        {QStringLiteral("type"), QStringLiteral("chat_request")},
+        {QStringLiteral("host"), QStringLiteral("pc-02")},
+        {QStringLiteral("user"), QStringLiteral("student")}
+    }).toJson(QJsonDocument::Compact);
+    received.clear();
+    socket.writeDatagram(legacy, QHostAddress::LocalHost, ChatSignalSettings::Port);
+    QVERIFY(received.wait(1000));
+    QCOMPARE(received.takeFirst().at(0).toString(), QStringLiteral("pc-02"));
+}
+
+// Floods the request port from another thread with unrelated datagrams and
+// some requests while a timer on the GUI thread measures how late it fires
+void ChatTests::requestFlood()
+{
+    constexpr int FloodDuration = 2000;
+    constexpr int TickInterval = 10;
+    constexpr qint64 MaxStall = 100;
+
+    ChatSignalListener listener;
+    QSignalSpy received(&listener, &ChatSignalListener::requestFromHost);
+    QTest::qWait(STARTUP_DELAY);
+
+    std::atomic<bool> flooding{true};
+    std::atomic<quint64> sent{0};
+    QScopedPointer<QThread> flooder(QThread::create([&flooding, &sent]() {
+        QUdpSocket socket;
+        const QByteArray noise(512, 'x');
+        QByteArray datagram = ChatRequestDatagram::encode(QStringLiteral("pc-01"), QStringLiteral("student"));
+        quint32 requestId = 0;
+        while (flooding.load()) {
+            for (int i = 0; i < 9; ++i) {
+                socket.writeDatagram(noise, QHostAddress::LocalHost, ChatSignalSettings::Port);
+            }
+            ChatRequestDatagram::setRequestId(datagram, ++requestId);
+            socket.writeDatagram(datagram, QHostAddress::LocalHost, ChatSignalSettings::Port);
+            sent += 10;
+        }
+    }));
+
+    QElapsedTimer clock;
+    clock.start();
+    qint64 lastTick = 0;
+    qint64 maxStall = 0;
+    QTimer ticker;
+    ticker.setTimerType(Qt::PreciseTimer);
+    ticker.setInterval(TickInterval);
+    connect(&ticker, &QTimer::timeout, this, [&]() {
+        const qint64 now = clock.elapsed();
+        maxStall = qMax(maxStall, now - lastTick - TickInterval);
+        lastTick = now;
+    });
+
+    flooder->start();
+    lastTick = clock.elapsed();
+    ticker.start();
+    QTest::qWait(FloodDuration);
+    flooding = false;
+    QVERIFY(flooder->wait(5000));
+    ticker.stop();
+
+    qInfo("%llu datagrams sent, %d requests delivered, %llu dropped on a full queue, GUI stalled at most %lld ms",
+          sent.load(), received.count(), listener.droppedRecords(), maxStall);
+    QVERIFY(received.count() > 0);
+    QVERIFY(maxStall < MaxStall);
+}
+
+// Requests sent to the multicast group are looped back to a master on the
+// same machine, which joined the group
+void ChatTests::requestMulticastLoopback()
+{
+    const QHostAddress group(QStringLiteral("239.255.29.65"));
+    for (const auto* applicationName : {MASTER_APPLICATION_NAME, CLIENT_APPLICATION_NAME}) {
+        QSettings settings(ORGANIZATION_NAME, applicationName);
+        settings.setValue(QStringLiteral("requestMode"), QStringLiteral("multicast"));
+        settings.setValue(QStringLiteral("multicastGroup"), group.toString());
+    }
+
+    ChatSignalListener listener;
+    QSignalSpy received(&listener, &ChatSignalListener::requestFromHost);
+    QTest::qWait(STARTUP_DELAY);
+
+    QUdpSocket socket;
+    QVERIFY(socket.bind(QHostAddress::AnyIPv4, 0));
+    socket.setSocketOption(QAbstractSocket::MulticastTtlOption, 1);
+    socket.setSocketOption(QAbstractSocket::MulticastLoopbackOption, 1);
+
+    QByteArray datagram = ChatRequestDatagram::encode(QStringLiteral("pc-01"), QStringLiteral("student"));
+    ChatRequestDatagram::setRequestId(datagram, 1);
+    if (socket.writeDatagram(datagram, group, ChatSignalSettings::Port) < 0) {
+        QSKIP("No multicast route on this machine");
+    }
+    QVERIFY(received.wait(1000));
+    QCOMPARE(received.takeFirst().at(0).toString(), QStringLiteral("pc-01"));
+
+    // A worker in multicast mode reaches the master as well
+    ChatRequestWorker worker;
+    worker.sendRequest();
+    QVERIFY(received.wait(1000));
+    QCOMPARE(received.takeFirst().at(0).toString(), QHostInfo::localHostName());
+}
+
+// A request whose first two attempts and first ack are lost is retried until
+// the fourth attempt is acked, and reaches the teacher once
+void ChatTests::requestRetryUntilAcked()
+{
+    LossyRequestTransport transport(2, 1);
+    ChatRequestTransport::install(&transport);
+
+    ChatSignalListener listener;
+    QSignalSpy received(&listener, &ChatSignalListener::requestFromHost);
+    QTest::qWait(STARTUP_DELAY);
+
+    ChatRequestWorker worker;
+    worker.sendRequest();
+
+    QTRY_COMPARE_WITH_TIMEOUT(transport.acks.load(), 2, 5000);
+    // Longer than the next retry delay, no further attempt may follow
+    QTest::qWait(2000);
+    QCOMPARE(transport.requests.load(), 4);
+    QCOMPARE(received.count(), 1);
+    QCOMPARE(received.at(0).at(0).toString(), QHostInfo::localHostName());
+
+    // Once acked, pressing F10 again sends a new request
+    worker.sendRequest();
+    QVERIFY(received.wait(1000));
+    QCOMPARE(transport.requests.load(), 5);
+}
+
+// Worker startup with the chat window left unbuilt, against building it for
+// the first message. The figures are printed rather than compared, earlier
+// tests have already paid for loading styles and fonts in this process.
+void ChatTests::clientStartupFootprint()
+{
+    QElapsedTimer timer;
+
+    const qint64 initialResident = residentKiB();
+    timer.start();
+    ChatServiceClient client;
+    const qint64 startupTime = timer.nsecsElapsed();
+    const qint64 startupResident = residentKiB();
+    QCOMPARE(clientWindowCount(), 0);
+
+    // Messages are buffered until the window is built
+    client.receiveMessage(ChatMessage(QStringLiteral("master"), client.clientId(), QStringLiteral("Hello")));
+    QCOMPARE(clientWindowCount(), 0);
+
+    timer.restart();
+    client.showChatWindow();
+    const qint64 buildTime = timer.nsecsElapsed();
+    const qint64 builtResident = residentKiB();
+    QCOMPARE(clientWindowCount(), 1);
+
+    const auto widgets = QApplication::topLevelWidgets();
+    for (auto* widget : widgets) {
+        if (auto* clientWidget = qobject_cast<ChatClientWidget*>(widget)) {
+            auto* display = clientWidget->findChild<QTextEdit*>();
+            QVERIFY(display);
+            QVERIFY(display->toPlainText().contains(QStringLiteral("Hello")));
+        }
+    }
+
+    qInfo("worker startup without window: %lld us, %lld KiB; building the window: %lld us, %lld KiB more",
+          startupTime / 1000, startupResident - initialResident, buildTime / 1000, builtResident - startupResident);
+}
+
+// Direct messages to a student over a link losing every fourth one. The
+// student asks for exactly the missing numbers and ends up acknowledging all
+// of them.
+void ChatTests::resyncAfterLoss()
+{
+    constexpr quint32 Messages = 40;
+    constexpr quint32 LossInterval = 4;
+
+    ChatServiceClient client;
+    ChatSession session(client.clientId());
+
+    QList<quint32> requested;
+    connect(&client, &ChatServiceClient::resyncRequested, this,
+            [&](quint32 first, quint32 last) {
+                for (quint32 sequence = first; sequence <= last; ++sequence) {
+                    requested.append(sequence);
+                }
+                client.receiveResync(session.sentMessages(first, last), last);
+            });
+
+    quint32 delivered = 0;
+    connect(&client, &ChatServiceClient::acknowledge, this, [&delivered](quint32 sequence) {
+        delivered = sequence;
+    });
+
+    QList<quint32> lost;
+    for (quint32 i = 0; i < Messages; ++i) {
+        ChatMessage message(QStringLiteral("master"), client.clientId(), QStringLiteral("Message [%1]").arg(i));
+        message.setSequence(session.nextSequence());
+        session.addMessage(message);
+
+        // The last message always arrives, it reveals the gap before it
+        if (message.sequence() % LossInterval == 0 && message.sequence() != Messages) {
+            lost.append(message.sequence());
+            continue;
+        }
+        client.receiveMessage(message);
+    }
+
+    QCOMPARE(requested, lost);
+    QTRY_COMPARE_WITH_TIMEOUT(delivered, Messages, 5000);
+
+    qInfo("%d of %u messages lost, %d resent", int(lost.size()), Messages, int(requested.size()));
+}
+
+// A file sent to one student over a queued loopback, the receiver writing
+// it to the download folder. A repeated offer with a broken chunk size must
+// be dropped, not divided by.
+void ChatTests::fileTransferThroughput()
+{
+    constexpr qint64 Size = 16 * 1024 * 1024;
+    constexpr double MinThroughput = 5;
+
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    QByteArray content(int(Size), Qt::Uninitialized);
+    QRandomGenerator::global()->fillRange(reinterpret_cast<quint32*>(content.data()), int(Size / sizeof(quint32)));
+    QCOMPARE(file.write(content), Size);
+    file.close();
+
+    const QString clientId = QStringLiteral("pc-01");
+    ChatFileSender sender;
+    ChatFileReceiver receiver;
+    connect(&sender, &ChatFileSender::sendOffer, &receiver, [&receiver](const QString&, const ChatFileOffer& offer) {
+        receiver.receiveOffer(offer);
+    }, Qt::QueuedConnection);
+    connect(&sender, &ChatFileSender::sendChunk, &receiver, [&receiver](const QString&, const ChatFileChunk& chunk) {
+        receiver.receiveChunk(chunk);
+    }, Qt::QueuedConnection);
+    connect(&receiver, &ChatFileReceiver::acknowledge, &sender, [&sender, clientId](const QString& transferId, quint32 next) {
+        sender.acknowledge(transferId, clientId, next);
+    }, Qt::QueuedConnection);
+
+    QString receivedPath;
+    connect(&receiver, &ChatFileReceiver::fileReceived, this, [&receivedPath](const QString&, const QString& filePath) {
+        receivedPath = filePath;
+    });
+
+    QElapsedTimer timer;
+    timer.start();
+    const QString transferId = sender.send(file.fileName(), clientId);
+    QVERIFY(!transferId.isEmpty());
+    QTRY_VERIFY_WITH_TIMEOUT(!receivedPath.isEmpty(), 60000);
+    const double seconds = qMax<qint64>(1, timer.nsecsElapsed()) / 1e9;
+
+    QFile received(receivedPath);
+    QVERIFY(received.open(QIODevice::ReadOnly));
+    QVERIFY(received.readAll() == content);
+    received.close();
+    received.remove();
+
+    const double throughput = Size / seconds / (1024 * 1024);
+    qInfo("%lld MiB in %.0f ms: %.1f MiB/s", Size / (1024 * 1024), seconds * 1000, throughput);
+    QVERIFY(throughput > MinThroughput);
+
+    QSignalSpy acknowledged(&receiver, &ChatFileReceiver::acknowledge);
+    ChatFileOffer offer;
+    offer.transferId = transferId;
+    offer.fileName = QFileInfo(file.fileName()).fileName();
+    offer.size = Size;
+    offer.chunkSize = 0;
+    receiver.receiveOffer(offer);
+    QCOMPARE(acknowledged.count(), 0);
+}
+
+// Two masters on localhost sharing a student's session. The student's clock
+// runs an hour ahead, and each read or clear on one master races a new
+// message on the other; both must survive on both masters.
+void ChatTests::replicationTwoMasters()
+{
+    const QString clientId = QStringLiteral("pc-01");
+    const quint16 port = freeTcpPort();
+    QVERIFY(port != 0);
+
+    qputenv(REPLICATION_PORT_VARIABLE, QByteArray::number(port));
+    ChatReplicator first;
+    qunsetenv(REPLICATION_PORT_VARIABLE);
+    qputenv(REPLICATION_PEERS_VARIABLE, QStringLiteral("127.0.0.1:%1").arg(port).toUtf8());
+    ChatReplicator second;
+    qunsetenv(REPLICATION_PEERS_VARIABLE);
+    QVERIFY(first.isEnabled());
+    QVERIFY(second.isEnabled());
+
+    // Wired like the plugin wires the master widget
+    ChatSession firstSession(clientId);
+    ChatSession secondSession(clientId);
+    for (auto pair : {qMakePair(&first, &firstSession), qMakePair(&second, &secondSession)}) {
+        ChatSession* session = pair.second;
+        connect(pair.first, &ChatReplicator::messageMerged, this, [session](const QString&, const ChatMessage& message) {
+            session->mergeMessage(message);
+        });
+        connect(pair.first, &ChatReplicator::readMerged, this, [session](const QString&, const QStringList& ids) {
+            session->markRead(ids);
+        });
+        connect(pair.first, &ChatReplicator::clearMerged, this, [session](const QString&, const QStringList& ids) {
+            session->removeMessages(ids);
+        });
+    }
+
+    const auto receive = [&clientId](ChatReplicator& replicator, ChatSession& session, const QString& content,
+                                     qint64 clockSkew = 0) {
+        QJsonObject json = ChatMessage(clientId, QStringLiteral("master"), content).toJson();
+        json[QStringLiteral("timestamp")] = QDateTime::currentMSecsSinceEpoch() + clockSkew;
+        const ChatMessage message = ChatMessage::fromJson(json);
+        session.addMessage(message);
+        replicator.recordMessage(clientId, message);
+        return message.messageId();
+    };
+
+    const QString ahead = receive(first, firstSession, QStringLiteral("ahead"), 3600 * 1000);
+    QTRY_COMPARE_WITH_TIMEOUT(messageIds(secondSession), QStringList{ahead}, 5000);
+
+    secondSession.markAllAsRead();
+    second.recordRead(clientId);
+    const QString racingRead = receive(first, firstSession, QStringLiteral("racing read"));
+
+    QTRY_COMPARE_WITH_TIMEOUT(messageIds(secondSession), (QStringList{racingRead, ahead}), 5000);
+    QTRY_COMPARE_WITH_TIMEOUT(firstSession.history().constFirst().status(), ChatMessage::Status::Read, 5000);
+    QCOMPARE(firstSession.unreadCount(), 1);
+    QCOMPARE(secondSession.unreadCount(), 1);
+
+    secondSession.clearHistory();
+    second.recordClear(clientId);
+    const QString racingClear = receive(first, firstSession, QStringLiteral("racing clear"));
+
+    QTRY_COMPARE_WITH_TIMEOUT(messageIds(firstSession), QStringList{racingClear}, 5000);
+    QTRY_COMPARE_WITH_TIMEOUT(messageIds(secondSession), QStringList{racingClear}, 5000);
+}
+
+// Three masters, the first played by the test. Its operations reach the
+// second out of order, as when a live operation overtakes a replay on
+// another connection. None may be skipped, and the third gets them all from
+// the second.
+void ChatTests::replicationOutOfOrder()
+{
+    constexpr int Operations = 3;
+
+    const QString clientId = QStringLiteral("pc-01");
+    const quint16 port = freeTcpPort();
+    QVERIFY(port != 0);
+
+    qputenv(REPLICATION_PORT_VARIABLE, QByteArray::number(port));
+    ChatReplicator second;
+    qunsetenv(REPLICATION_PORT_VARIABLE);
+    qputenv(REPLICATION_PEERS_VARIABLE, QStringLiteral("127.0.0.1:%1").arg(port).toUtf8());
+    ChatReplicator third;
+    qunsetenv(REPLICATION_PEERS_VARIABLE);
+
+    QStringList secondMerged;
+    QStringList thirdMerged;
+    connect(&second, &ChatReplicator::messageMerged, this, [&secondMerged](const QString&, const ChatMessage& message) {
+        secondMerged.append(message.content());
+    });
+    connect(&third, &ChatReplicator::messageMerged, this, [&thirdMerged](const QString&, const ChatMessage& message) {
+        thirdMerged.append(message.content());
+    });
+
+    const QString origin = QUuid::createUuid().toString(QUuid::WithoutBraces);
+    QVector<QByteArray> operations;
+    QStringList contents;
+    for (int counter = 1; counter <= Operations; ++counter) {
+        contents.append(QStringLiteral("Message [%1]").arg(counter));
+        operations.append(replicationFrame({
+            {QStringLiteral("type"), QStringLiteral("message")},
+            {QStringLiteral("origin"), origin},
+            {QStringLiteral("counter"), QString::number(counter)},
+            {QStringLiteral("clientId"), clientId},
+            {QStringLiteral("message"), ChatMessage(clientId, QStringLiteral("master"), contents.last()).toJson()}
+        }));
+    }
+
+    // Answers every hello with what the other side is missing, in order
+    QTcpSocket first;
+    QByteArray buffer;
+    connect(&first, &QTcpSocket::readyRead, this, [&]() {
+        buffer.append(first.readAll());
+        while (buffer.size() >= int(sizeof(quint32))) {
+            const int size = int(qFromBigEndian<quint32>(buffer.constData()));
+            if (buffer.size() < int(sizeof(quint32)) + size) {
+                break;
+            }
+            const QJsonObject object = QJsonDocument::fromJson(buffer.mid(int(sizeof(quint32)), size)).object();
+            buffer.remove(0, int(sizeof(quint32)) + size);
+
+            if (object.value(QStringLiteral("type")).toString() == QLatin1String("hello")) {
+                const QJsonObject vector = object.value(QStringLiteral("vector")).toObject();
+                for (int known = vector.value(origin).toString().toInt(); known < Operations; ++known) {
+                    first.write(operations.at(known));
+                }
+            }
+        }
+    });
+
+    first.connectToHost(QHostAddress::LocalHost, port);
+    QVERIFY(first.waitForConnected(5000));
+    first.write(replicationFrame({
+        {QStringLiteral("type"), QStringLiteral("hello")},
+        {QStringLiteral("replica"), origin},
+        {QStringLiteral("vector"), QJsonObject()}
+    }));
+    first.write(operations.at(2));
+    first.write(operations.at(0));
+    first.write(operations.at(1));
+
+    QTRY_COMPARE_WITH_TIMEOUT(secondMerged, contents, 5000);
+    QTRY_COMPARE_WITH_TIMEOUT(thirdMerged, contents, 5000);
+}
+
+// A client window capped at 100 messages after 2000 have arrived. Scrolling
+// to the top pages the older ones back in from the scrollback file and drops
+// as many at the bottom, a new message brings back the latest ones.
+void ChatTests::scrollbackPageIn()
+{
+    constexpr int Messages = 2000;
+    constexpr int Limit = 100;
+    constexpr int Page = 100;
+    constexpr qint64 MaxPageIn = 100 * 1000 * 1000;
+
+    QSettings(ORGANIZATION_NAME, CLIENT_APPLICATION_NAME).setValue(QStringLiteral("scrollbackLimit"), Limit);
+
+    ChatClientWidget widget;
+    auto* display = widget.findChild<QTextEdit*>();
+    QVERIFY(display);
+
+    for (int i = 0; i < Messages; ++i) {
+        widget.receiveMessage(ChatMessage(QStringLiteral("master"), QStringLiteral("pc-01"),
+                                          QStringLiteral("Message [%1]").arg(i)));
+    }
+    QVERIFY(display->toPlainText().contains(QStringLiteral("Message [%1]").arg(Messages - 1)));
+    QVERIFY(!display->toPlainText().contains(QStringLiteral("Message [%1]").arg(Messages - Limit - 1)));
+    const int cappedBlocks = display->document()->blockCount();
+
+    QElapsedTimer timer;
+    QVector<qint64> latencies;
+    const int scrollTop = display->verticalScrollBar()->minimum();
+    while (!display->toPlainText().contains(QStringLiteral("Message [0]"))) {
+        QVERIFY(latencies.size() < Messages / Limit);
+        timer.start();
+        QMetaObject::invokeMethod(&widget, "onScrollPositionChanged", Q_ARG(int, scrollTop));
+        latencies.append(timer.nsecsElapsed());
+        QVERIFY(display->document()->blockCount() <= Limit + Page);
+    }
+    QVERIFY(!display->toPlainText().contains(QStringLiteral("Message [%1]").arg(Messages - 1)));
+
+    widget.receiveMessage(ChatMessage(QStringLiteral("master"), QStringLiteral("pc-01"),
+                                      QStringLiteral("Message [%1]").arg(Messages)));
+    QVERIFY(display->toPlainText().contains(QStringLiteral("Message [%1]").arg(Messages)));
+    QVERIFY(!display->toPlainText().contains(QStringLiteral("Message [0]")));
+    QVERIFY(display->document()->blockCount() <= Limit);
+
+    const qint64 p50 = percentile(latencies, 0.5);
+    const qint64 p99 = percentile(latencies, 0.99);
+    qInfo("%d messages capped at %d blocks, %d pages read back: p50 %lld us, p99 %lld us",
+          Messages, cappedBlocks, int(latencies.size()), p50 / 1000, p99 / 1000);
+    QVERIFY(p99 < MaxPageIn);
+}
+
+// A second client process asking for the metrics socket of a running one
+// must not take it over
+void ChatTests::metricsSocketInUse()
+{
+    const QString name = QStringLiteral("veyon-chat-tests-metrics-%1").arg(QCoreApplication::applicationPid());
+
+    ChatMetricsServer running(CLIENT_APPLICATION_NAME, name);
+    QVERIFY(running.isListening());
+
+    ChatMetricsServer second(CLIENT_APPLICATION_NAME, name);
+    QVERIFY(!second.isListening());
+    QVERIFY(running.isListening());
+}
+
+int main(int argc, char* argv[])
+{
+    // Widgets are created, but never shown
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication app(argc, argv);
+
+    ChatTests tests;
+    return QTest::qExec(&tests, argc, argv);
+}
+
+#include "ChatTests.moc"